@@ -0,0 +1,36 @@
+#pragma once
+#include <SDL.h>
+
+// Set to 1 (CMake option ENGINE_TRACK_ALLOCATIONS) to count every heap
+// allocation: global operator new/delete are replaced and SDL's allocator
+// is wrapped. Off, the counters just stay at zero.
+#ifndef ENGINE_TRACK_ALLOCATIONS
+#define ENGINE_TRACK_ALLOCATIONS 0
+#endif
+
+struct AllocationCounts {
+    Uint64 allocations = 0; // new, malloc, calloc, and realloc that moved or grew from null
+    Uint64 frees = 0;
+    Uint64 bytes = 0;       // requested by those allocations
+};
+
+// Process-wide counters, from any thread. Take a snapshot at the start of a
+// frame and subtract it at the end to get that frame's allocations.
+class AllocationTracker {
+public:
+    static constexpr bool enabled() { return ENGINE_TRACK_ALLOCATIONS != 0; }
+
+    // Routes SDL_malloc and friends through the counters. Has to run before
+    // SDL allocates anything, i.e. first thing in main().
+    static void installSdlHooks();
+    static AllocationCounts totals();
+
+    static AllocationCounts since(const AllocationCounts& start) {
+        AllocationCounts now = totals();
+        AllocationCounts d;
+        d.allocations = now.allocations - start.allocations;
+        d.frees = now.frees - start.frees;
+        d.bytes = now.bytes - start.bytes;
+        return d;
+    }
+};
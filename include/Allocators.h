@@ -0,0 +1,79 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Scratch memory for one simulation tick: a bump pointer into a single
+// block, handed back all at once by reset(). Nothing is freed individually
+// and nothing is constructed or destroyed, so only use it for plain data.
+//
+// allocate() is safe from several jobs at once. If a tick needs more than
+// the block holds, the extra comes from the heap and the block is grown to
+// fit at the next reset(), so after the first big tick it stops allocating.
+class FrameArena {
+public:
+    explicit FrameArena(size_t bytes);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = 16);
+    template<typename T>
+    T* allocate(size_t count) { return static_cast<T*>(allocate(count * sizeof(T), alignof(T) < 16 ? 16 : alignof(T))); }
+
+    // Everything allocated since the last reset becomes invalid. Not safe
+    // while another thread is still allocating.
+    void reset();
+
+    size_t capacity() const { return blockSize; }
+    size_t used() const { return lastUsed; }     // by the previous tick, overflow included
+    size_t highWater() const { return peak; }
+    int overflows() const { return overflowCount; } // ticks that didn't fit
+
+private:
+    Uint8* block = nullptr;
+    size_t blockSize = 0;
+    std::atomic<size_t> offset{ 0 };
+
+    std::mutex overflowMutex;
+    std::vector<void*> overflowBlocks;
+    size_t overflowBytes = 0;
+
+    size_t lastUsed = 0;
+    size_t peak = 0;
+    int overflowCount = 0;
+};
+
+// Fixed-size blocks carved out of larger slabs, recycled through a free
+// list. Acquire and release are a couple of pointer moves; the heap is only
+// touched when every block is in use and a new slab is needed. Blocks are
+// 16-byte aligned. Not thread-safe.
+class BlockPool {
+public:
+    BlockPool(size_t blockBytes, size_t blocksPerSlab);
+    ~BlockPool();
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    void* acquire();
+    void release(void* block);
+
+    size_t blockSize() const { return blockBytes; }
+    size_t blocksInUse() const { return inUse; }
+    size_t blocksAllocated() const { return slabs.size() * blocksPerSlab; }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    size_t blockBytes;
+    size_t blocksPerSlab;
+    std::vector<void*> slabs;
+    FreeBlock* freeList = nullptr;
+    size_t inUse = 0;
+
+    void addSlab();
+};
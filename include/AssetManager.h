@@ -0,0 +1,155 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "SpriteBatch.h"
+#include "TextRenderer.h"
+
+enum class AssetState {
+    LOADING,
+    READY,
+    FAILED
+};
+
+// Loads images and fonts in the background so the window has something to
+// show on its first frame. Loader threads do the slow part (PNG decoding,
+// opening the font and rasterizing its glyph atlas) into plain surfaces;
+// update() on the main thread turns finished ones into textures, stopping
+// once the frame's upload budget is spent, so a burst of finished assets is
+// spread over several frames instead of stalling one.
+//
+// Assets are shared through reference-counted handles: asking for the same
+// file again returns the one already loaded or loading, and dropping the
+// last handle frees it. Handles are copied and dropped on the main thread
+// only, like everything else here but the loaders.
+class AssetManager {
+public:
+    class Handle {
+    public:
+        Handle() = default;
+        Handle(const Handle& other);
+        Handle(Handle&& other) noexcept;
+        Handle& operator=(Handle other) noexcept;
+        ~Handle() { reset(); }
+
+        void reset();
+        explicit operator bool() const { return owner != nullptr; }
+
+    private:
+        friend class AssetManager;
+        Handle(AssetManager* owner, Uint32 index);
+
+        AssetManager* owner = nullptr;
+        Uint32 index = 0;
+    };
+
+    struct Progress {
+        int requested = 0;   // assets currently held, loaded or not
+        int ready = 0;
+        int failed = 0;
+        double decodeMs = 0.0;          // summed over the loaders
+        double uploadMs = 0.0;          // on the main thread
+        double worstFrameUploadMs = 0.0;
+        int uploadFrames = 0;           // update() calls that uploaded anything
+
+        bool done() const { return ready + failed == requested; }
+        float fraction() const { return requested ? static_cast<float>(ready + failed) / requested : 1.0f; }
+    };
+
+    AssetManager() = default;
+    ~AssetManager() { stop(); }
+    AssetManager(const AssetManager&) = delete;
+    AssetManager& operator=(const AssetManager&) = delete;
+
+    void start(SDL_Renderer* renderer, RenderBackend& backend, int loaders);
+    // Joins the loaders and frees every asset, handles or not
+    void stop();
+
+    Handle loadImage(const char* path);
+    // The font and a glyph atlas of it, ready for TextRenderer
+    Handle loadFont(const char* path, int pointSize);
+
+    // Main thread, once a frame: uploads finished assets until budgetMs has
+    // gone by. At least one goes up per call, so loading always moves on.
+    void update(double budgetMs);
+    // Blocks until everything asked for so far is ready or failed
+    void finish();
+
+    AssetState state(const Handle& handle) const;
+    Progress progress() const;
+
+    // Empty until the asset is ready
+    const Sprite& sprite(const Handle& handle) const;
+    SDL_Texture* texture(const Handle& handle) const;
+    TTF_Font* font(const Handle& handle) const;
+    const GlyphAtlas& glyphs(const Handle& handle) const;
+
+private:
+    enum class Kind : Uint8 {
+        IMAGE,
+        FONT
+    };
+
+    struct Asset {
+        Kind kind = Kind::IMAGE;
+        std::string key;
+        std::string path;
+        int pointSize = 0;
+        int refs = 0;                   // main thread
+
+        // Filled by a loader before the asset goes on the upload queue
+        bool decoded = false;
+        std::string error;
+        SDL_Surface* surface = nullptr; // images
+        TTF_Font* font = nullptr;       // fonts, with their atlas in glyphs
+        GlyphAtlas glyphs;
+        double decodeMs = 0.0;
+
+        // Main thread, from the upload on
+        AssetState state = AssetState::LOADING;
+        SDL_Texture* texture = nullptr;
+        Sprite sprite;
+    };
+
+    SDL_Renderer* renderer = nullptr;
+    RenderBackend* backend = nullptr;
+    std::vector<std::thread> loaders;
+
+    // Slots are reused once freed; an Asset never moves while a loader has it
+    std::vector<std::unique_ptr<Asset>> assets;
+    std::vector<Uint32> freeSlots;
+    std::unordered_map<std::string, Uint32> byKey;
+
+    // Guards everything below
+    mutable std::mutex lock;
+    std::condition_variable queued;   // something to decode, or stopping
+    std::condition_variable decoded;  // something to upload
+    std::deque<Uint32> decodeQueue;
+    std::deque<Uint32> uploadQueue;
+    int decoding = 0;
+    bool stopping = false;
+    double decodeMs = 0.0;
+
+    // Main thread
+    double uploadMs = 0.0;
+    double worstFrameUploadMs = 0.0;
+    int uploadFrames = 0;
+    // SDL_ttf shares one FreeType library between every font
+    std::mutex fontLock;
+
+    Handle request(Kind kind, const char* path, int pointSize);
+    void loaderLoop();
+    void decode(Asset& asset);
+    void upload(Uint32 index);
+    void retain(Uint32 index);
+    void release(Uint32 index);
+    void freeAsset(Uint32 index);
+    const Asset* find(const Handle& handle) const;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "SpriteBatch.h"
+
+// On-disk layout of assets.pack, written by tools/asset_cooker.cpp.
+// Everything is little-endian and read in place from the mapped file:
+//
+//   PackHeader
+//   PackPage[pageCount]       at pageTableOffset
+//   PackSprite[spriteCount]   at spriteTableOffset, sorted by name
+//   page pixels               each at its own 64-byte aligned pixelOffset,
+//                             RGBA bytes with premultiplied alpha
+namespace pack {
+
+constexpr Uint32 MAGIC = 0x4B415044; // "DPAK"
+constexpr Uint32 VERSION = 1;
+constexpr int NAME_LENGTH = 48;
+
+struct PackHeader {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 pageCount;
+    Uint32 spriteCount;
+    Uint32 pageTableOffset;
+    Uint32 spriteTableOffset;
+};
+
+struct PackPage {
+    Uint32 width;
+    Uint32 height;
+    Uint32 pitch;
+    Uint32 reserved;
+    Uint64 pixelOffset;
+};
+
+struct PackSprite {
+    char name[NAME_LENGTH]; // path under the asset dir without extension, e.g. "menusprites/HEALTH"
+    Uint32 page;
+    Uint16 x, y, w, h;      // pixels within the page
+    float u0, v0, u1, v1;
+};
+
+}
+
+// Maps a cooked pack into memory and turns each page into one texture,
+// uploaded straight from the mapping without any decoding.
+class AssetPack {
+public:
+    AssetPack() = default;
+    ~AssetPack();
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    // The backend gets the pages' pixels as they are in the file
+    bool createTextures(SDL_Renderer* renderer, RenderBackend& backend);
+    void destroyTextures();
+
+    // Returns false if the pack has no sprite by that name
+    bool findSprite(const char* name, Sprite& out) const;
+
+    size_t spriteCount() const { return header ? header->spriteCount : 0; }
+    size_t pageCount() const { return header ? header->pageCount : 0; }
+
+private:
+    const Uint8* data = nullptr;
+    size_t dataSize = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+    const pack::PackHeader* header = nullptr;
+    const pack::PackPage* pages = nullptr;
+    const pack::PackSprite* sprites = nullptr;
+
+    RenderBackend* backend = nullptr;
+    std::vector<SDL_Texture*> pageTextures;
+    SDL_BlendMode pageBlend = SDL_BLENDMODE_BLEND;
+
+    bool validate() const;
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "BulletPool.h"
+#include "BulletPattern.h"
+#include "Playfield.h"
+#include "World.h"
+#include "Input.h"
+
+// A fixed, deterministic script for the headless benchmark: which buttons are
+// held on each tick, which bullet rings get fired and which pattern emitters
+// get placed. Same script, same frames, so runs on different commits can be
+// compared directly.
+class BenchScenario {
+public:
+    struct Phase {
+        int startTick;
+        Uint16 buttons;     // held for the whole phase
+        int ringBullets;    // bullets per ring, 0 for none
+        int ringInterval;   // ticks between rings
+        float ringSpeed;    // pixels per second
+        const char* pattern = nullptr; // emitters placed when the phase starts
+        int emitters = 0;              // spread across the top of the field
+        int enemies = 0;               // in rows from the top, drifting down
+    };
+
+    BenchScenario(Uint32 id, std::vector<Phase> phases) : scenarioId(id), phases(std::move(phases)) {}
+
+    // Warm-up, strafing under light fire, then focused dodging under a
+    // dense spiral that keeps tens of thousands of bullets alive (id 1)
+    static const BenchScenario& standard();
+    // Boss fight: hundreds of live pattern emitters at once (id 2)
+    static const BenchScenario& boss();
+    // Thousands of enemies while the player keeps firing (id 3)
+    static const BenchScenario& swarm();
+    // Hundreds of curved lasers, about a hundred nodes each (id 4)
+    static const BenchScenario& lasers();
+    // Built-in scenario by id, nullptr if there is none; recordings store the id
+    static const BenchScenario* find(Uint32 id);
+
+    Uint32 id() const { return scenarioId; }
+
+    Uint16 buttonsAt(int tick) const;
+    // Fires whatever the script has for this tick
+    void spawnAt(int tick, BulletPool& bullets, EmitterPool& emitters,
+                 const PatternLibrary& patterns, World& world, const Playfield& bounds) const;
+
+private:
+    Uint32 scenarioId;
+    std::vector<Phase> phases; // sorted by startTick
+
+    const Phase& phaseAt(int tick) const;
+};
@@ -0,0 +1,176 @@
+#pragma once
+#include <SDL.h>
+#include <string>
+#include <vector>
+#include "BulletPool.h"
+#include "LaserPool.h"
+
+class JobSystem;
+class StateWriter;
+class StateReader;
+
+// Bullet patterns are written in a small line-based language, compiled once
+// at load time to bytecode, and run by a register VM that steps every live
+// emitter each tick. Emitters are plain structs in one array, so a tick is a
+// tight loop over the bytecode with no virtual calls and no allocation.
+//
+// Language, one instruction per line, '#' starts a comment:
+//
+//   pattern <name>            starts a new program (ends the previous one)
+//   set  rD a                 rD = a
+//   add  rD a b               rD = a + b
+//   mul  rD a b               rD = a * b
+//   sin  rD a                 rD = sin(a degrees)
+//   ramp rD target ticks      slide rD linearly to target over ticks
+//   wait ticks                resume next tick after this many
+//   loop count ... end        repeat the body count times
+//   ring count speed [angle]  evenly spaced circle, angle in degrees
+//   fan  count spread speed   spread (degrees) aimed at the player
+//   shot speed angle          single bullet
+//   laser speed angle length  curved laser keeping length nodes (one per
+//                             tick); radius is half its width, life how
+//                             long the head runs, curve how it bends
+//   radius a / life a / accel a / curve a   style for later shots
+//                             (curve in degrees per second)
+//   color RRGGBBAA            style for later shots
+//   move vx vy                emitter drift in pixels per second
+//
+// Operands are numbers or registers r0-r15. Falling off the end of a
+// program, or 'halt', retires the emitter.
+
+enum class PatternOp : Uint8 {
+    HALT, SET, ADD, MUL, SIN, RAMP, WAIT, LOOP, END,
+    RING, FAN, SHOT, RADIUS, COLOR, LIFE, ACCEL, CURVE, MOVE, LASER
+};
+
+struct PatternInstruction {
+    PatternOp op;
+    Uint8 dst;         // register written by SET/ADD/MUL/SIN/RAMP
+    Uint8 regMask;     // bit i set: operand[i] is a register number
+    Uint8 pad;
+    float operand[3];  // COLOR keeps its Uint32 bit pattern in operand[0]
+};
+
+// Every compiled program, back to back in one code array
+class PatternLibrary {
+public:
+    // Compiles every pattern in source; on failure error holds "line N: ..."
+    // and nothing from this source is added
+    bool compile(const char* source, std::string& error);
+    bool loadFile(const char* path, std::string& error);
+
+    // Program id or -1
+    int find(const char* name) const;
+    size_t programCount() const { return programs.size(); }
+    Uint32 entryPoint(int program) const { return programs[program].start; }
+    const PatternInstruction* code() const { return instructions.data(); }
+    size_t codeSize() const { return instructions.size(); }
+
+    // Boss patterns compiled into the game
+    static const char* builtinSource();
+
+private:
+    struct Program {
+        std::string name;
+        Uint32 start;
+    };
+    std::vector<Program> programs;
+    std::vector<PatternInstruction> instructions;
+};
+
+// Staging area the VM writes shots (and lasers) into. Grows on demand up to
+// limit and keeps its memory across clear(), so once the first busy ticks
+// are over it never allocates again.
+template<typename T>
+class SpawnBuffer {
+public:
+    explicit SpawnBuffer(size_t limit) : limit(limit) {}
+
+    T* data() { return items.data(); }
+    size_t size() const { return count; }
+    size_t dropped() const { return droppedCount; }
+    void clear() { count = 0; droppedCount = 0; }
+
+    T* push() {
+        if (count == items.size()) {
+            if (count >= limit) {
+                droppedCount++;
+                return nullptr;
+            }
+            size_t grown = items.size() < 64 ? 64 : items.size() * 2;
+            items.resize(grown < limit ? grown : limit);
+        }
+        return &items[count++];
+    }
+
+private:
+    std::vector<T> items;
+    size_t limit;
+    size_t count = 0;
+    size_t droppedCount = 0;
+};
+
+class EmitterPool {
+public:
+    static constexpr int REGISTERS = 16;
+    static constexpr int MAX_LOOP_DEPTH = 4;
+    static constexpr int MAX_RAMPS = 2;
+    static constexpr int MAX_OPS_PER_TICK = 256; // runaway loops can't stall a tick
+    static constexpr size_t JOB_CHUNK = 64;       // emitters per job, each with its own buffer
+
+    // maxSpawnsPerTick caps what any one chunk can stage in a tick
+    EmitterPool(size_t capacity, size_t maxSpawnsPerTick);
+
+    bool spawn(const PatternLibrary& library, int program, float x, float y);
+    void clear() { emitters.clear(); }
+    size_t size() const { return emitters.size(); }
+
+    // Steps every emitter one tick, staging shots per chunk; bullets aimed
+    // with 'fan' go toward target
+    void update(const PatternLibrary& library, float dt, float targetX, float targetY, JobSystem& jobs);
+    // Hands the staged shots to bullets and lasers in emitter order, whatever
+    // thread ran each chunk, and retires halted emitters. Returns how many
+    // bullets were added.
+    size_t flushSpawns(BulletPool& bullets, LaserPool& lasers);
+    // Shots and lasers lost to full chunk buffers in the last flush
+    size_t droppedSpawns() const { return lastDropped; }
+
+    // Every emitter's registers, style and program state, into a state
+    // image and back; the staged shots are per tick and not part of it
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+private:
+    struct Emitter {
+        float regs[REGISTERS];
+        float x, y;
+        float vx, vy;
+        // Style for the next shots
+        float radius, life, accel, curve;
+        Uint32 color;
+
+        Uint32 pc;
+        Uint32 wait;
+        Uint8 loopDepth;
+        Uint8 rampCount;
+        Uint8 halted;
+        struct { Uint32 body; Uint32 remaining; } loops[MAX_LOOP_DEPTH];
+        struct { Uint8 reg; Uint32 ticks; float step; } ramps[MAX_RAMPS];
+    };
+
+    size_t capacity;
+    std::vector<Emitter> emitters;
+    std::vector<SpawnBuffer<BulletSpawn>> chunkSpawns; // one per JOB_CHUNK emitters
+    std::vector<SpawnBuffer<LaserSpawn>> chunkLasers;
+    size_t lastDropped = 0;
+
+    // Everything one chunk of emitters staged this tick
+    struct ChunkOutput {
+        SpawnBuffer<BulletSpawn>& shots;
+        SpawnBuffer<LaserSpawn>& lasers;
+    };
+
+    void tick(Emitter& e, const PatternInstruction* code, float dt, float targetX, float targetY, ChunkOutput& out);
+    // Returns false once the emitter has halted
+    bool step(Emitter& e, const PatternInstruction* code, float targetX, float targetY, ChunkOutput& out);
+};
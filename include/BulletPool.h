@@ -0,0 +1,110 @@
+#pragma once
+#include <SDL.h>
+#include <cstddef>
+#include "Playfield.h"
+
+class JobSystem;
+class StateWriter;
+class StateReader;
+
+// Everything needed to put one bullet into the pool.
+struct BulletSpawn {
+    float x, y;
+    float vx, vy;        // pixels per second
+    float ax, ay;        // pixels per second^2
+    float angularVel;    // radians per second, rotates the velocity
+    float lifetime;      // seconds
+    float radius;
+    Uint32 color;        // 0xRRGGBBAA
+};
+
+// Fixed-capacity bullet storage laid out as structure-of-arrays so the
+// per-tick integration can run 4 (SSE2) or 8 (AVX2) bullets per instruction.
+// Live bullets are always packed in [0, size()); dead ones are swap-removed
+// at the end of update(), so nothing is ever allocated after construction.
+class BulletPool {
+public:
+    explicit BulletPool(size_t capacity);
+    ~BulletPool();
+    BulletPool(const BulletPool&) = delete;
+    BulletPool& operator=(const BulletPool&) = delete;
+
+    bool spawn(const BulletSpawn& b);
+    // Appends as many as fit; returns how many were added
+    size_t spawnBatch(const BulletSpawn* spawns, size_t n);
+    void clear() { count = 0; }
+
+    // Removed on the next update(); indices stay valid until then
+    void kill(size_t i) { life[i] = 0.0f; }
+    // Kills every live bullet touching the circle (bombs). Their indices go
+    // to killed, if given, which needs room for size() entries; returns how
+    // many there were. Like kill(), they're removed on the next update().
+    size_t killInRadius(float cx, float cy, float radius, Uint32* killed);
+    // Each bullet only counts for graze once; returns true the first time
+    bool markGrazed(size_t i) {
+        if (flags[i] & FLAG_GRAZED) return false;
+        flags[i] |= FLAG_GRAZED;
+        return true;
+    }
+
+    // Integrate motion and lifetime, then drop everything that expired or
+    // left the playfield entirely
+    void update(float dt, const Playfield& bounds);
+    // Same, with integration split into fixed blocks across the job system
+    void update(float dt, const Playfield& bounds, JobSystem& jobs);
+
+    size_t size() const { return count; }
+    size_t capacity() const { return maxBullets; }
+
+    const float* posX() const { return x; }
+    const float* posY() const { return y; }
+    const float* velX() const { return vx; }
+    const float* velY() const { return vy; }
+    const float* radii() const { return radius; }
+    const Uint32* colors() const { return color; }
+
+    // Live bullets into a state image and back (see StateSnapshot.h)
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+    // Which kernel update() was built with: "avx2", "sse2" or "scalar"
+    static const char* kernelName();
+
+private:
+    static constexpr Uint8 FLAG_GRAZED = 1;
+
+    size_t maxBullets = 0;
+    size_t paddedCapacity = 0; // rounded up to a whole SIMD block
+    size_t count = 0;
+    void* block = nullptr;     // single aligned allocation backing every array below
+
+    float* x = nullptr;
+    float* y = nullptr;
+    float* vx = nullptr;
+    float* vy = nullptr;
+    float* ax = nullptr;
+    float* ay = nullptr;
+    float* angularVel = nullptr;
+    float* life = nullptr;
+    float* radius = nullptr;
+    Uint32* color = nullptr;
+    Uint8* flags = nullptr;
+    Uint8* deadMask = nullptr;  // one bit per bullet, filled by the kernel
+
+    // Bullets per integration job; a multiple of 8 so no two jobs share a
+    // deadMask byte
+    static constexpr size_t JOB_BLOCK = 4096;
+
+    // Flags expired/off-field bullets in deadMask; returns true if any were.
+    // begin must be a multiple of 8.
+    bool integrate(size_t begin, size_t end, float dt, const Playfield& bounds);
+    void compact();
+    void moveBullet(size_t from, size_t to);
+
+    bool isDead(size_t i) const { return (deadMask[i >> 3] >> (i & 7)) & 1; }
+    void setDead(size_t i, bool dead) {
+        Uint8 bit = static_cast<Uint8>(1u << (i & 7));
+        if (dead) deadMask[i >> 3] |= bit;
+        else deadMask[i >> 3] &= static_cast<Uint8>(~bit);
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "SpriteBatch.h"
+
+enum class CircleBackend {
+    SPRITE,   // anti-aliased, pre-rasterized textures, one quad per circle
+    SCANLINE  // hard-edged, one untextured span per scanline
+};
+
+// Filled circles and rings, going through the sprite batch so they layer with
+// everything else. The sprite backend rasterizes every integer radius up to
+// MAX_CACHED_RADIUS once, white with coverage in alpha, into a single atlas;
+// color comes from the vertex tint, so one texture serves every color and
+// all circles on a layer end up in the same draw call. Rings are cached per
+// (radius, thickness) the first time they're asked for.
+class CircleRenderer {
+public:
+    static constexpr int MAX_CACHED_RADIUS = 64;
+
+    bool init(SDL_Renderer* renderer, SpriteBatch* batch);
+    void cleanup();
+
+    void setBackend(CircleBackend backend) { this->backend = backend; }
+    CircleBackend getBackend() const { return backend; }
+
+    void fillCircle(float cx, float cy, float radius, SDL_Color color, Uint8 layer);
+    void ring(float cx, float cy, float radius, float thickness, SDL_Color color, Uint8 layer);
+
+    // The cached sprite for a radius (clamped to 1..MAX_CACHED_RADIUS). It has
+    // a 1 px margin for the anti-aliased edge, so draw it (2r + 2) wide.
+    const Sprite& circleSprite(int radius) const;
+
+private:
+    struct RingKey {
+        int radius;
+        int thickness;
+    };
+
+    SDL_Renderer* renderer = nullptr;
+    SpriteBatch* batch = nullptr;
+    CircleBackend backend = CircleBackend::SPRITE;
+
+    SDL_Texture* circleAtlas = nullptr;
+    Sprite circleSprites[MAX_CACHED_RADIUS + 1];
+
+    std::vector<RingKey> ringKeys;
+    std::vector<Sprite> ringSprites; // each owns its texture
+
+    const Sprite* findRing(int radius, int thickness);
+    void fillCircleSpans(float cx, float cy, float radius, SDL_Color color, Uint8 layer);
+    void ringSpans(float cx, float cy, float radius, float thickness, SDL_Color color, Uint8 layer);
+};
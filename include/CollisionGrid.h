@@ -0,0 +1,100 @@
+#pragma once
+#include <SDL.h>
+#include <cstddef>
+#include <vector>
+#include "Playfield.h"
+
+class JobSystem;
+
+// Uniform spatial grid over the playfield for circle-vs-circle queries.
+// Rebuilt from scratch every tick with a counting sort: count items per cell,
+// prefix-sum into cell offsets, then scatter. Items in a grid row end up
+// contiguous, so a query walks one span per row instead of one per cell, and
+// the narrow phase reads copies of x/y/r laid out in that same sorted order.
+class CollisionGrid {
+public:
+    CollisionGrid(const Playfield& bounds, float cellSize, size_t maxItems);
+
+    void build(const float* x, const float* y, const float* radius, size_t count);
+    // Same result, slot for slot: blocks of items count and scatter in
+    // parallel, each into its own reserved range of every cell
+    void build(const float* x, const float* y, const float* radius, size_t count, JobSystem& jobs);
+
+    size_t size() const { return itemCount; }
+    int columns() const { return cols; }
+    int rowCount() const { return rows; }
+
+    // Calls fn(itemIndex) for every item whose circle overlaps the query
+    // circle. itemIndex refers to the arrays passed to build(). Return false
+    // from fn to stop early.
+    template<typename Fn>
+    void queryCircle(float cx, float cy, float radius, Fn&& fn) const;
+
+    bool overlapsAny(float cx, float cy, float radius) const;
+
+    // Runs queryCircle for a whole set of query circles (e.g. player shots
+    // against the enemy grid), calling fn(queryIndex, itemIndex) per overlap
+    template<typename Fn>
+    void queryCircles(const float* qx, const float* qy, const float* qr, size_t queryCount, Fn&& fn) const;
+
+private:
+    Playfield bounds;
+    float cellSize;
+    float invCellSize;
+    int cols;
+    int rows;
+    size_t maxItems;
+    size_t itemCount = 0;
+    float maxRadius = 0.0f; // largest item radius this build; widens query ranges
+
+    std::vector<Uint32> cellOf;      // per input item
+    std::vector<Uint32> cellStart;   // cols * rows + 1 prefix offsets
+    std::vector<Uint32> sortedIndex; // input index of each sorted slot
+    std::vector<float> sortedX;
+    std::vector<float> sortedY;
+    std::vector<float> sortedR;
+
+    static constexpr size_t JOB_BLOCK = 4096;
+    std::vector<Uint32> blockCursor;    // per block, per cell: count, then write cursor
+    std::vector<float> blockMaxRadius;
+
+    int cellColumn(float px) const {
+        int c = static_cast<int>((px - bounds.left) * invCellSize);
+        return c < 0 ? 0 : (c >= cols ? cols - 1 : c);
+    }
+    int cellRow(float py) const {
+        int r = static_cast<int>((py - bounds.top) * invCellSize);
+        return r < 0 ? 0 : (r >= rows ? rows - 1 : r);
+    }
+};
+
+template<typename Fn>
+void CollisionGrid::queryCircle(float cx, float cy, float radius, Fn&& fn) const {
+    if (itemCount == 0) return;
+
+    const float reach = radius + maxRadius;
+    const int c0 = cellColumn(cx - reach);
+    const int c1 = cellColumn(cx + reach);
+    const int r0 = cellRow(cy - reach);
+    const int r1 = cellRow(cy + reach);
+
+    for (int row = r0; row <= r1; ++row) {
+        const Uint32 begin = cellStart[row * cols + c0];
+        const Uint32 end = cellStart[row * cols + c1 + 1];
+        for (Uint32 s = begin; s < end; ++s) {
+            const float dx = sortedX[s] - cx;
+            const float dy = sortedY[s] - cy;
+            const float rr = sortedR[s] + radius;
+            if (dx * dx + dy * dy <= rr * rr) {
+                if (!fn(static_cast<size_t>(sortedIndex[s]))) return;
+            }
+        }
+    }
+}
+
+template<typename Fn>
+void CollisionGrid::queryCircles(const float* qx, const float* qy, const float* qr, size_t queryCount, Fn&& fn) const {
+    for (size_t q = 0; q < queryCount; ++q) {
+        queryCircle(qx[q], qy[q], qr[q], [&](size_t item) { return fn(q, item); });
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <SDL.h>
+
+// Component types for the World. Plain data only; behaviour lives in
+// EntitySystems. Positions are centers, in window pixels.
+
+struct Position {
+    float x, y;
+};
+
+// Where the entity was at the start of the tick, for render interpolation
+struct PrevPosition {
+    float x, y;
+};
+
+struct Velocity {
+    float x, y; // pixels per second
+};
+
+struct Collider {
+    float radius;
+};
+
+struct Health {
+    int hp;
+    int max;
+};
+
+// Destroyed when it runs out
+struct Lifetime {
+    float seconds;
+};
+
+struct Tint {
+    Uint32 color; // 0xRRGGBBAA
+};
+
+struct PlayerState {
+    int speed;             // pixels per tick, halved while focused
+    int hurtboxSize;
+    int bombs;
+    int maxBombs;
+    int invulnerableTicks; // after a hit
+    int grazeCount;
+    int shotCooldown;      // ticks until the next shot
+    int itemsCollected;
+};
+
+struct Enemy {
+    int points;
+};
+
+struct Shot {
+    int damage;
+};
+
+enum ItemKind : int {
+    ITEM_POINT,
+    ITEM_BOMB
+};
+
+struct Item {
+    int kind;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <SDL.h>
+#include <functional>
+#include "SpriteBatch.h"
+
+// Screen layers of the game view, bottom to top
+enum CompositeLayer : Uint8 {
+    COMPOSITE_FRAME = 0,  // walls and the divider
+    COMPOSITE_PLAYFIELD,  // player, bullets, hurtbox
+    COMPOSITE_HUD,        // side panel: HP, bombs, graze
+    COMPOSITE_OVERLAY,    // pause dimming and menu
+    COMPOSITE_COUNT
+};
+
+// Keeps each layer in a window-sized render-target texture that is only
+// redrawn after markDirty(); a clean layer costs one quad per frame. A live
+// layer skips its texture and draws straight into the frame instead, for
+// content that changes every frame anyway (the playfield while playing),
+// where caching would only add a copy.
+class Compositor {
+public:
+    // Draws the layer's content into the sprite batch, in window coordinates
+    using Builder = std::function<void()>;
+
+    // Returns false only on a hard failure; without render-target support
+    // every layer is simply drawn live
+    bool init(SDL_Renderer* renderer, SpriteBatch* batch, int width, int height);
+    void cleanup();
+
+    // area is the part of the layer that is composited. Opaque layers are
+    // cleared to black and copied without blending; the rest start out
+    // transparent. batchLayer is where the layer's quad sorts in the frame.
+    void setLayer(CompositeLayer layer, SDL_Rect area, bool opaque, Uint8 batchLayer, Builder builder);
+    void setVisible(CompositeLayer layer, bool visible);
+    // Going from live to cached marks the layer dirty so it gets captured
+    void setLive(CompositeLayer layer, bool live);
+    void markDirty(CompositeLayer layer) { layers[layer].dirty = true; }
+    // Target contents are lost on SDL_RENDER_TARGETS_RESET / DEVICE_RESET
+    void markAllDirty();
+
+    // Redraws dirty layers into their textures (one flush each), then queues
+    // every visible layer into the batch. Call before anything else is
+    // queued for the frame.
+    void compose();
+
+    // Texture redraws per layer over the last full second
+    int rebuildsPerSecond(CompositeLayer layer) const { return layers[layer].rebuildRate; }
+    static const char* layerName(CompositeLayer layer);
+
+private:
+    struct Layer {
+        SDL_Texture* texture = nullptr;
+        Sprite sprite;
+        SDL_FRect dst = { 0.0f, 0.0f, 0.0f, 0.0f };
+        bool opaque = false;
+        Uint8 batchLayer = LAYER_BACKGROUND;
+        Builder builder;
+        bool visible = true;
+        bool live = false;
+        bool dirty = true;
+        int rebuilds = 0;     // this second
+        int rebuildRate = 0;  // last second
+    };
+
+    SDL_Renderer* renderer = nullptr;
+    SpriteBatch* batch = nullptr;
+    int width = 0;
+    int height = 0;
+    Layer layers[COMPOSITE_COUNT];
+    Uint32 rateStart = 0;
+
+    void rebuild(Layer& layer);
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <SDL.h>
+#include <unordered_map>
+#include <vector>
+
+class JobSystem;
+class RenderStateCache;
+
+// Software rasterizer behind SpriteBatch, for machines where SDL would only
+// give us its generic software renderer anyway. Draws into its own
+// SIMD-aligned RGBA32 framebuffer and uploads it with one SDL_UpdateTexture
+// per frame in present().
+//
+// It keeps a CPU copy of every texture it's told about (registerTexture),
+// premultiplied, and everything it draws stays premultiplied so render
+// targets composite the same way SDL's do. Sampling is nearest, like SDL's
+// default scale quality.
+//
+// Runs submitted between two finish() calls are recorded, binned into
+// 64x64 tiles and rasterized tile by tile in submission order. Tiles never
+// share pixels, so with a job system they go wide. Axis-aligned quads (every
+// sprite, rect and cached circle) take the SSE2/AVX2 span kernels; anything
+// else goes through a scalar triangle fallback.
+class CpuRenderBackend {
+public:
+    CpuRenderBackend() = default;
+    ~CpuRenderBackend();
+    CpuRenderBackend(const CpuRenderBackend&) = delete;
+    CpuRenderBackend& operator=(const CpuRenderBackend&) = delete;
+
+    // renderer may be null (benchmarks): no upload and no render targets,
+    // present() only finishes
+    bool init(SDL_Renderer* renderer, RenderStateCache& cache, int width, int height);
+    void cleanup();
+    // Tiles go across these threads; null rasterizes on the caller
+    void setJobs(JobSystem* jobs) { this->jobs = jobs; }
+
+    // Keeps a copy of the pixels the texture was made from. Call once right
+    // after creating it; textures the backend never saw draw nothing.
+    bool registerTexture(SDL_Texture* texture, SDL_Surface* surface);
+    bool registerPixels(SDL_Texture* texture, const void* pixels, int width, int height, int pitch,
+                        bool premultiplied);
+
+    // Targets are CPU images; the SDL texture is a 1x1 handle to key them by
+    bool supportsTargets() const { return renderer != nullptr; }
+    SDL_Texture* createTarget(int width, int height);
+    void destroyTexture(SDL_Texture* texture);
+    void setTarget(SDL_Texture* target);
+
+    void clear(SDL_Color color);
+    void drawGeometry(SDL_Texture* texture, SDL_BlendMode blend, const SDL_Vertex* vertices, int vertexCount,
+                      const int* indices, int indexCount);
+    // Rasterizes everything recorded into the current target
+    void finish();
+    void present();
+    // Finishes and copies the top-left width x height of the screen out as
+    // RGBA32 rows; opaque wherever the frame was cleared, so premultiplied
+    // or not makes no difference there
+    bool readPixels(Uint32* dst, int width, int height);
+
+    // The frame as of the last finish(), RGBA32 premultiplied
+    const Uint32* pixels() const { return screen.pixels; }
+    int pitch() const { return screen.pitch; } // in pixels
+
+    static const char* name() { return "cpu"; }
+    // Which span kernel was built: "avx2", "sse2" or "scalar"
+    static const char* kernelName();
+
+    static constexpr int TILE_SIZE = 64;
+
+private:
+    struct Image {
+        Uint32* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        int pitch = 0; // in pixels
+    };
+
+    // One quad or triangle, already clipped to the target
+    struct Command {
+        const Image* image;   // null draws solid color
+        Uint32 color;         // premultiplied, same byte order as the pixels
+        Uint8 blend;
+        bool triangle;
+        int x0, y0, x1, y1;   // covered pixels, [x0, x1) x [y0, y1)
+        // Quads: 16.16 texel coordinates at pixel (x0, y0) and the step per
+        // pixel; triangles: u is the index of the first of 3 TriangleVertex
+        Sint32 u, v, du, dv;
+    };
+
+    struct TriangleVertex {
+        float x, y;
+        float u, v; // in texels
+    };
+
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* upload = nullptr; // streaming texture present() copies into
+    JobSystem* jobs = nullptr;
+
+    Image screen;
+    Image* target = &screen;
+    std::unordered_map<SDL_Texture*, Image> images;
+    bool warnedUnregistered = false;
+
+    std::vector<Command> commands;
+    std::vector<TriangleVertex> triangleVertices;
+    std::vector<std::vector<Uint32>> tileCommands; // command indices per tile
+
+    static bool allocateImage(Image& image, int width, int height);
+    static void freeImage(Image& image);
+
+    void addQuad(const Image* image, Uint8 blend, const SDL_Vertex* v);
+    void addTriangle(const Image* image, Uint8 blend, const SDL_Vertex& a, const SDL_Vertex& b, const SDL_Vertex& c);
+    void rasterizeTile(int tile, int tilesX) const;
+    void rasterizeQuad(const Command& c, int x0, int x1, int y0, int y1) const;
+    void rasterizeTriangle(const Command& c, int x0, int x1, int y0, int y1) const;
+};
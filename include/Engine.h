@@ -2,22 +2,159 @@
 #include <SDL.h>
 #include <SDL_ttf.h>      // Add this
 #include <string>
+#include <atomic>
+#include <thread>
 #include <SDL_image.h>
+#include "TextRenderer.h"
+#include "SpriteBatch.h"
+#include "Compositor.h"
+#include "CircleRenderer.h"
+#include "FramePacer.h"
+#include "BulletPool.h"
+#include "BulletPattern.h"
+#include "LaserPool.h"
+#include "ParticleSystem.h"
+#include "CollisionGrid.h"
+#include "Playfield.h"
+#include "AssetPack.h"
+#include "AssetManager.h"
+#include "Input.h"
+#include "FrameTimings.h"
+#include "FrameCapture.h"
+#include "BenchScenario.h"
+#include "Profiler.h"
+#include "InputRecording.h"
+#include "JobSystem.h"
+#include "World.h"
+#include "Components.h"
+#include "EntitySystems.h"
+#include "Allocators.h"
+#include "AllocationTracker.h"
+#include "Stage.h"
+#include "StateSnapshot.h"
+#include "RenderCommandList.h"
+#include "TripleBuffer.h"
 
 enum class GameState {
     TITLE_SCREEN,
     GAME_RUNNING,
     PAUSED
 };
+
+// What the main thread needs to draw one simulation tick: the playfield as
+// recorded commands, plus the few numbers the HUD, pause menu and late-latched
+// player are built from. Filled by whichever thread runs the simulation,
+// handed over through a TripleBuffer and only read after that.
+struct FrameSnapshot {
+    GameState state = GameState::TITLE_SCREEN;
+    Uint32 game = 0;             // counts startGame() calls
+    Uint32 tick = 0;             // ticks since that game started
+    Uint64 publishedAt = 0;      // performance counter
+    Uint64 inputSampledAt = 0;   // when the keyboard was last read for a tick
+    bool keyboardInput = true;   // false under playback or a scripted scenario
+    bool latchPlayer = false;    // player left out of the playfield for the late latch
+
+    RenderCommandList playfield;
+
+    struct Player {
+        float x, y;
+        float dx, dy;            // moved over the last tick
+        int speed;
+        int hurtboxSize;
+        bool focused;
+        bool visible;            // off on blink frames while invulnerable
+    } player = {};
+    int health = 0;
+    int bombs = 0;
+    int graze = 0;
+    int items = 0;
+    int pauseSelection = 0;
+
+    // For the stats overlay
+    size_t particles = 0;
+    Uint64 droppedParticles = 0;
+    size_t arenaUsed = 0;
+    size_t arenaCapacity = 0;
+    size_t arenaHighWater = 0;
+    size_t rewindSnapshots = 0;
+    size_t rewindBytes = 0;
+    size_t lasers = 0;
+    size_t laserNodes = 0;
+};
+
 class Engine {
 public:
     Engine(const std::string& title, int width, int height);
+    void setFramePacing(PacingMode mode, int targetHz = 60);
+    // Dummy video driver + software renderer; call before init()
+    void setHeadless(bool enabled) { headless = enabled; }
+    // Threads for the simulation jobs, including the main one; 0 = one per
+    // CPU. Results are identical for any count.
+    void setThreadCount(int threads);
+    int threadCount() const { return jobs.threadCount(); }
+    // Draw the player from input read right before the batch is flushed
+    // instead of from the last tick. Visual only; the simulation still gets
+    // its buttons once per tick.
+    void setLateLatch(bool enabled) { lateLatch = enabled; }
+    // Run the simulation on its own thread in run(), publishing a snapshot
+    // per tick, while the main thread polls events, draws the newest snapshot
+    // and presents. A slow present or a vsync wait then no longer holds up
+    // the ticks, and the ticks no longer hold up the frame.
+    void setSimulationThread(bool enabled) { useSimThread = enabled; }
+    // Abort if a frame spent in GAME_RUNNING touches the heap, once the
+    // game has had ALLOC_WARMUP_FRAMES to grow its buffers. Needs a build
+    // with ENGINE_TRACK_ALLOCATIONS.
+    void setAssertNoAllocations(bool enabled);
     bool init();
     void run();
+    // Plays the scenario for a fixed number of frames as fast as possible,
+    // recording per-stage frame times. Damage is off so the run never ends early.
+    void runScenario(const BenchScenario& scenario, int frames, FrameTimings& timings);
+    // The same setup in pieces, for engine_microbench: start a game driven by
+    // the scenario's buttons with damage off, advance it without rendering,
+    // and hand input back to the keyboard with endScenario()
+    void beginScenario(const BenchScenario& scenario);
+    void stepScenario(int ticks);
+    void endScenario();
+    // One frame of whatever state the engine is in: queue everything and
+    // flush the batch, then present. No input, no ticks.
+    void drawFrame();
+    void captureFrame();
+    void presentFrame();
+    // Fire this scenario's bullets in normal play (input still from the keyboard)
+    void setScenario(const BenchScenario* scenario) { activeScenario = scenario; }
+    // Play this stage script in every game; empty for none
+    void setStage(const std::string& path) { stagePath = path; }
+    // Write every presented frame to this file as a QOI stream, from init()
+    // until cleanup(); see FrameCapture.h
+    void captureTo(const std::string& path) { capturePath = path; }
+
+    // Each game started from the title is written here when it ends
+    void recordTo(const std::string& path);
+    // Plays a recording through run() with rendering, then quits
+    bool startPlayback(const char* path);
+    // Runs a recording's ticks back to back without rendering or a window
+    // (init() not needed) and checks the final state against the recorded
+    // hash; returns false on a mismatch
+    bool replayFast(const char* path);
+    Uint64 simulationHash();
+    // Everything the simulation reads as one flat image: the world, bullets,
+    // emitters, the stage with its script position, and game and menu state.
+    // Loading one carries on exactly as the saved tick would have, which is
+    // what rewind, practice restarts and rollback need. Images only load into
+    // the engine that wrote them. Particles are drawn only and not part of
+    // it; loading clears them.
+    void saveState(std::vector<Uint8>& image);
+    bool loadState(const std::vector<Uint8>& image);
+    // Keep this many seconds of play to step back through while Backspace is
+    // held; 0 (the default) for none. delta stores each snapshot as an XOR
+    // against the one before. Unavailable while recording or replaying.
+    void setRewind(int seconds, bool delta = true);
     void cleanup();
     void render();
-    void handleInput();
+    void handleInput(Uint16 buttons);
     void clampPosition();
+    Playfield playfieldBounds() const { return Playfield::fromWindow(width, height); }
 
 private:
     std::string title;
@@ -25,41 +162,235 @@ private:
     int height;
     SDL_Window* window;
     SDL_Renderer* renderer;
-    bool isRunning;
-
-    SDL_Texture* playerTexture;
+    std::atomic<bool> isRunning;
+    bool headless = false;
 
     GameState currentState = GameState::TITLE_SCREEN;
 
-    int rectX;
-    int rectY;
-    int rectSpeed;
+    // Simulation runs at a fixed rate regardless of how fast we render
+    static constexpr int SIM_HZ = 60;
+    static constexpr double SIM_DT = 1.0 / SIM_HZ;
+    static constexpr int MAX_TICKS_PER_FRAME = 8; // stop the spiral of death on long hitches
+
+    FramePacer pacer;
+    double tickAccumulator = 0.0;
+    float renderAlpha = 1.0f; // how far between the previous and current tick we are drawing
+
+    // Bullet script for the current game; during runScenario() it also
+    // supplies the buttons instead of the keyboard
+    const BenchScenario* activeScenario = nullptr;
+    const BenchScenario* previousScenario = nullptr; // restored by endScenario()
+    int scenarioTick = 0;
+    bool scenarioInput = false;
+    bool noDamage = false;
+    FrameTimings* frameTimings = nullptr;
+
+    // Timed waves, patterns, dialog and boss phases, streamed from stagePath
+    std::string stagePath;
+    Stage stage;
+
+    // Frames read back after drawing and encoded off the main thread; a
+    // frame is dropped rather than wait for a free buffer
+    static constexpr int CAPTURE_BUFFERS = 8;
+    static constexpr int CAPTURE_WORKERS = 2;
+    std::string capturePath;
+    FrameCapture capture;
+
+    std::string recordPath;
+    InputRecording recording;
+    bool recordingActive = false;
+    InputRecording playback;
+    InputRecording::Reader playbackReader{ playback };
+    bool playbackActive = false;
+
+    // The player, enemies, shots and items. The player entity is recreated
+    // by every startGame(), which resets its health, bombs and counters.
+    World world;
+    EntitySystems entitySystems;
+    Entity player;
+    Query<Position> hashQuery;
+    float aimX = 0.0f; // player position as of the start of the tick graph
+    float aimY = 0.0f;
+    static constexpr int SHOT_INTERVAL_TICKS = 4;
+
+    static constexpr size_t MAX_BULLETS = 65536;
+    BulletPool bullets;
+
+    // Curved lasers from the pattern VM, each a ring of path nodes out of one
+    // segment pool; tested against the player on their own, not in the grid
+    static constexpr size_t MAX_LASERS = 1024;
+    LaserPool lasers;
+
+    // Bomb blasts, hit sparks and trails. Drawn only; nothing in the
+    // simulation reads them, so they stay out of recordings and the hash.
+    static constexpr size_t MAX_PARTICLES = 131072;
+    ParticleSystem particles;
+    static constexpr float BOMB_RADIUS = 120.0f;
+    // Indices of the bullets a bomb clears, for their debris; room for the
+    // whole pool so a full-screen bomb doesn't need the tick arena
+    std::vector<Uint32> bombCleared;
+    bool playerHit = false; // this tick, for the effect after the tick graph
+
+    // Pattern VM: emitters run bytecode and stage their shots per chunk
+    static constexpr size_t MAX_EMITTERS = 4096;
+    static constexpr size_t MAX_SPAWNS_PER_TICK = 16384;
+    PatternLibrary patterns;
+    EmitterPool emitters;
+
+    // Broad phase for everything the player can touch, rebuilt each tick
+    static constexpr float COLLISION_CELL_SIZE = 16.0f;
+    CollisionGrid bulletGrid;
+    float grazeRadius = 16.0f;   // around the hurtbox center
+    static constexpr int HIT_INVULNERABLE_TICKS = 2 * SIM_HZ;
+
+    // Each tick runs as a graph of jobs: emitters and bullet integration in
+    // parallel, then spawning, the grid build and the collision queries
+    JobSystem jobs;
+    TaskGraph tickGraph;
+
+    // Scratch for one tick's jobs, reset at the start of every tick. Sized
+    // for the worst tick up front: growing it at a reset would be a heap
+    // allocation mid-game, which --assert-no-alloc rightly aborts on.
+    static constexpr size_t FRAME_ARENA_BYTES = EntitySystems::scratchBytes();
+    FrameArena frameArena;
+
+    // Heap use per frame (all zero unless built with ENGINE_TRACK_ALLOCATIONS)
+    static constexpr int ALLOC_WARMUP_FRAMES = 120;
+    AllocationCounts lastFrameAllocations;
+    bool assertNoAllocations = false;
+    int runningFrames = 0; // since the shown game started
+
+    // Fonts and loose PNGs decode on loader threads while the title is up;
+    // each frame uploads what's finished within the budget. Games can only
+    // be started once the gameplay sprites and the font are in.
+    static constexpr int ASSET_LOADERS = 2;
+    static constexpr double ASSET_UPLOAD_BUDGET_MS = 2.0;
+    AssetManager assets;
+    AssetManager::Handle fontAsset;
+    AssetManager::Handle spriteAssets[4]; // player, heart, bomb, selector
+    std::atomic<bool> gameAssetsReady{ false };
+    bool assetsReported = false;
+    Uint64 initStart = 0;
+    bool firstFramePresented = false;
 
     // For FPS counter
-    TTF_Font* font = nullptr;
-    SDL_Texture* fpsTexture = nullptr;
+    TextRenderer text;
+    char fpsText[32] = "";
     SDL_Rect fpsRect;
     Uint32 fpsTimerStart = 0;
     int frameCount = 0;
     int currentFPS = 0;
-    int hurtboxSize = 5;
-    SDL_Texture* heartTexture = nullptr;
-    SDL_Texture* bombTexture = nullptr;
-    SDL_Texture* selectorTexture = nullptr;
-
-    int playerHealth = 3; // start with 3 HP
-    int maxHealth = 5;
-    int maxBombs = 5;
-    int bombs = 5; // start with 5 bombs
-    bool xKeyPreviouslyDown = false; // For detecting single key press
-    int pauseMenuSelection = 0; // 0 = Title, 1 = Continue
+    AssetPack assetPack;
+
+    // Every draw goes through the batch and is submitted once per frame
+    SpriteBatch spriteBatch;
+    CircleRenderer circles;
+    Sprite playerSprite;
+    Sprite heartSprite;
+    Sprite bombSprite;
+    Sprite selectorSprite;
+    bool showRenderStats = false;
+    bool showProfiler = false;
+
+    // Frame, playfield, HUD and pause overlay, cached in render targets.
+    // What the HUD and overlay layers last drew, to know when they're stale.
+    Compositor compositor;
+    int hudHealth = -1;
+    int hudBombs = -1;
+    int hudGraze = -1;
+    int hudItems = -1;
+    int overlaySelection = -1;
+
+    // Keys arrive as events only; each tick samples the map once. The latency
+    // tracker times key events through to the present that shows them.
+    ActionMap actionMap;
+    InputLatency inputLatency;
+    bool lateLatch = false;
+
+    Uint16 prevButtons = 0;  // for detecting single key presses
+    Uint16 heldButtons = 0;  // as of the last tick
+    static constexpr int PAUSE_OPTIONS = 3;
+    int pauseMenuSelection = 0; // 0 = Title, 1 = Continue, 2 = Restart
+    std::atomic<bool> startRequested{ false }; // Enter on the title; the next update starts the game
+
+    // Restart in the pause menu goes back to the checkpoint: the start of
+    // the game, or wherever F5 set one in practice (not while recording,
+    // which has to replay from the start). Rewind steps back one snapshot
+    // per tick while Backspace is held, taken every REWIND_INTERVAL_TICKS.
+    static constexpr Uint32 STATE_MAGIC = 0x54535344; // "DSST"
+    static constexpr int REWIND_INTERVAL_TICKS = 2;
+    std::vector<Uint8> checkpoint;
+    std::vector<Uint8> stateScratch;
+    StateHistory rewindHistory;
+    std::atomic<bool> rewindHeld{ false };
+    std::atomic<bool> checkpointRequested{ false };
+    bool restartPending = false;
+
+    // The simulation side hands a FrameSnapshot to the drawing side after
+    // every update, on one thread (runFrame) or two (setSimulationThread)
+    bool useSimThread = false;
+    std::thread simThread;
+    std::atomic<bool> simThreadRunning{ false };
+    TripleBuffer<FrameSnapshot> snapshots;
+    const FrameSnapshot* shown = nullptr; // what the main thread draws from
+    Uint32 gameCount = 0;
+    Uint32 gameTicks = 0;
+    Uint64 lastInputSample = 0;
+    RenderCommandList latchedPlayer;
+    // Presents that showed no new tick, and ticks that were never shown
+    Uint32 shownGame = 0;
+    Uint32 shownTick = 0;
+    Uint64 framesDuplicated = 0;
+    Uint64 ticksDropped = 0;
 
     void updateFPS();
     void renderFPS();
-    SDL_Texture* createTextTexture(const std::string& text, SDL_Color color);
+    void drawTextCentered(const char* str, int centerX, int y, SDL_Color color, Uint8 layer = LAYER_HUD);
+    void renderStats();
+    void renderProfiler();
+    void handleDebugKey(SDL_Scancode key);
+    void processEvent(SDL_Event& e);
+    bool loadPackedSprites();
+    void requestLooseSprites();
+    void streamAssets();
+    void finishLoading();
 
     void renderTitleScreen();
     void handleTitleInput(SDL_Event& e);
-    void drawFilledCircle(int centerX, int centerY, int radius, SDL_Color color);
     void renderPauseMenu();
+    void setupLayers();
+    void renderFrame();
+    void renderHud();
+    void renderPlayfield();
+    void recordPlayfield(RenderCommandList& list);
+    void recordStageText(RenderCommandList& list);
+    void recordPlayer(RenderCommandList& list, float x, float y, float dx, float dy, bool focused, bool visible);
+    void recordParticles(RenderCommandList& list);
+    void recordBullets(RenderCommandList& list);
+    void recordLasers(RenderCommandList& list);
+    void captureSnapshot(FrameSnapshot& snapshot);
+    void acquireSnapshot();
+    GameState shownState() const { return shown ? shown->state : currentState; }
+    bool lateLatching() const;
+    void renderLatchedPlayer();
+    void startGame();
+    void startRecordedGame();
+    void startRecording();
+    void setCheckpoint();
+    void restartFromCheckpoint();
+    bool rewindEnabled() const;
+    bool rewinding() const;
+    void stepBack();
+    void simulateTick(Uint16 buttons);
+    void finishRecording();
+    bool loadRecording(const char* path);
+    void finishPlayback();
+    void runFrame(double frameTime);
+    void updateFrame(double frameTime);
+    void simulationLoop();
+    void updateSimulation();
+    void buildTickGraph();
+    void checkCollisions();
+    void triggerBomb(float x, float y);
+    void spawnTickEffects();
 };
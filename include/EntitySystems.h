@@ -0,0 +1,88 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "World.h"
+#include "Components.h"
+#include "CollisionGrid.h"
+#include "Playfield.h"
+#include "SpriteBatch.h"
+#include "RenderCommandList.h"
+#include "Allocators.h"
+
+// The per-tick systems over the World: motion, lifetimes, culling, player
+// shots against enemies and item pickup. Each one is a linear walk over the
+// chunk arrays its query matches. The player's own movement and the bullet
+// collisions stay in Engine, which owns the input and the bullet pool.
+class EntitySystems {
+public:
+    static constexpr size_t MAX_ENEMIES = 8192;
+    static constexpr float PICKUP_RADIUS = 24.0f;
+
+    explicit EntitySystems(const Playfield& bounds);
+
+    static Entity spawnPlayer(World& world, float x, float y);
+    static Entity spawnEnemy(World& world, float x, float y, float vx, float vy, int hp);
+    static Entity spawnShot(World& world, float x, float y);
+    static Entity spawnItem(World& world, float x, float y, ItemKind kind);
+
+    // Start of a tick: remember where everything was for interpolation
+    void storePrevious(World& world);
+    // Per-tick gathers go into scratch, which the caller resets between ticks
+    void update(World& world, Entity player, float dt, FrameArena& scratch);
+    // The most update() takes from scratch: every gather at MAX_ENEMIES
+    static constexpr size_t scratchBytes();
+
+    // Enemies, shots and items as one run of circles, with how far each
+    // moved this tick for interpolation
+    void draw(World& world, RenderCommandList& list, Uint8 layer);
+
+    size_t enemyCount(World& world) { return enemyQuery.count(world); }
+
+    // Where enemies died during the last update(), for effects. Lives in
+    // that update's scratch, so it's only good until the caller resets it.
+    struct Kill {
+        float x, y;
+    };
+    const Kill* kills() const { return killList; }
+    size_t killCount() const { return killTotal; }
+
+private:
+    Playfield bounds;
+
+    Query<Position, PrevPosition> previousQuery;
+    Query<Position, Velocity> motionQuery;
+    Query<Lifetime> lifetimeQuery;
+    Query<Position, Collider, Health, Enemy> enemyQuery;
+    Query<Position, Collider, Shot> shotQuery;
+    Query<Position, Item> itemQuery;
+    Query<Position, PrevPosition, Collider, Tint> drawQuery;
+
+    // Enemy broad phase, rebuilt each tick from a gather over the enemy chunks
+    CollisionGrid enemyGrid;
+
+    // Items dropped this tick, created once iteration is over. Both lists
+    // come out of the tick's scratch with room for every enemy, since none
+    // can die twice in one tick.
+    struct Drop {
+        float x, y;
+        ItemKind kind;
+    };
+    Drop* dropList = nullptr;
+    size_t dropTotal = 0;
+    Kill* killList = nullptr;
+    size_t killTotal = 0;
+
+    void integrate(World& world, float dt);
+    void expire(World& world, float dt);
+    void resolveShots(World& world, FrameArena& scratch);
+    void collectItems(World& world, Entity player);
+};
+
+constexpr size_t EntitySystems::scratchBytes() {
+    // Each gather is rounded up to the arena's 16-byte alignment
+    return 3 * ((MAX_ENEMIES * sizeof(float) + 15) & ~size_t(15)) +
+           ((MAX_ENEMIES * sizeof(Entity) + 15) & ~size_t(15)) +
+           ((MAX_ENEMIES * sizeof(Health*) + 15) & ~size_t(15)) +
+           ((MAX_ENEMIES * sizeof(Drop) + 15) & ~size_t(15)) +
+           ((MAX_ENEMIES * sizeof(Kill) + 15) & ~size_t(15));
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <SDL.h>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FrameTimings.h"
+
+// Records what the window shows, for bug reports and perf triage, without
+// an outside screen recorder perturbing the timing.
+//
+// The render thread reads each frame into one of a fixed pool of pixel
+// buffers and queues it; worker threads QOI-encode the frames and append
+// them to one file in frame order, so the file is a plain stream of QOI
+// images (ffmpeg -f qoi_pipe -framerate 60 -i capture.qoi capture.mp4).
+// A .csv next to it maps each image to the frame it came from and when.
+//
+// Nothing waits on the workers: when every buffer is still queued the frame
+// is dropped and counted, and the index shows the gap. The time the render
+// thread spends on each frame (readback included) is kept, to show the
+// capture isn't what the numbers being captured are measuring.
+class FrameCapture {
+public:
+    struct Stats {
+        Uint64 frames = 0;    // offered by the render thread
+        Uint64 dropped = 0;   // no free buffer, or the readback failed
+        Uint64 written = 0;
+        Uint64 bytes = 0;     // encoded, in the file
+        float lastOverheadUs = 0.0f;
+    };
+
+    FrameCapture() = default;
+    ~FrameCapture() { stop(); }
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Every buffer and encoder output is allocated here, up front
+    bool start(const char* path, int width, int height, int buffers, int workers);
+    // Writes out whatever is still queued, then closes the file
+    void stop();
+    bool active() const { return !workers.empty(); }
+
+    // Render thread. A width x height RGBA32 buffer for this frame, tightly
+    // packed, or null if the workers are behind and the frame is dropped.
+    Uint32* beginFrame();
+    // Queues the buffer from beginFrame(); ok false if it couldn't be filled
+    void endFrame(bool ok);
+
+    Stats stats() const;
+    // Render-thread microseconds per offered frame
+    FrameTimings::Summary overhead() const { return FrameTimings::summarizeSamples(overheadUs); }
+
+    // Appends one QOI image of the pixels to out, which needs room for
+    // maxEncodedSize(); returns the bytes written
+    static size_t encodeQoi(const Uint32* pixels, int width, int height, Uint8* out);
+    static size_t maxEncodedSize(int width, int height);
+
+private:
+    struct Slot {
+        std::vector<Uint32> pixels;
+        Uint64 sequence;   // order in the file
+        Uint64 frame;
+        Uint64 timeUs;     // since start()
+    };
+
+    std::string path;
+    int width = 0;
+    int height = 0;
+    FILE* file = nullptr;
+    FILE* index = nullptr;
+
+    std::vector<Slot> slots;
+    std::vector<std::vector<Uint8>> encoded; // one per worker
+    std::vector<std::thread> workers;
+
+    // Guards everything below it up to the render-thread state
+    mutable std::mutex lock;
+    std::condition_variable queued;   // a frame is waiting, or stopping
+    std::condition_variable written;  // the next frame in order went out
+    std::vector<int> freeSlots;
+    std::vector<int> pending;         // ring of slots waiting to be encoded
+    size_t pendingHead = 0;
+    size_t pendingCount = 0;
+    Uint64 nextToWrite = 0;
+    Uint64 writtenFrames = 0;
+    Uint64 writtenBytes = 0;
+    bool stopping = false;
+
+    // Render thread only
+    int current = -1;
+    Uint64 frameStart = 0;
+    Uint64 startedAt = 0;
+    Uint64 nextSequence = 0;
+    Uint64 offered = 0;
+    Uint64 dropped = 0;
+    std::vector<float> overheadUs;
+
+    void workerLoop(int worker);
+    void finishFrame();
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <SDL.h>
+
+enum class PacingMode {
+    VSYNC,    // let SDL_RenderPresent block on the display
+    CAPPED,   // hold a target frame time with the sleep/spin pacer
+    UNCAPPED  // render as fast as possible
+};
+
+// Holds a target frame time using SDL_GetPerformanceCounter.
+// Sleeping alone is too coarse (SDL_Delay can overshoot by a millisecond or more,
+// worse on Windows), spinning alone burns a core. So we sleep in 1 ms steps while
+// the remaining time is comfortably larger than what a sleep has been observed
+// to cost, then spin out the rest.
+class FramePacer {
+public:
+    FramePacer();
+
+    void setMode(PacingMode mode, int targetHz);
+    PacingMode getMode() const { return mode; }
+    int getTargetHz() const { return targetHz; }
+
+    // Call once per frame after present; blocks until the frame's slot is over
+    // (CAPPED only) and returns the seconds elapsed since the previous call.
+    double endFrame();
+
+    static Uint64 now() { return SDL_GetPerformanceCounter(); }
+    static double toSeconds(Uint64 ticks);
+
+private:
+    PacingMode mode = PacingMode::CAPPED;
+    int targetHz = 60;
+    Uint64 frequency = 0;
+    Uint64 targetTicks = 0;
+    Uint64 frameStart = 0;   // when the current frame slot began
+    Uint64 lastEnd = 0;
+
+    // What one SDL_Delay(1) really costs, as an exponentially weighted mean
+    // and variance: a plain average over the first SLEEP_WINDOW sleeps, then
+    // each new one weighted 1 / SLEEP_WINDOW so the estimate keeps tracking
+    // the scheduler without the variance growing with the session
+    static constexpr Uint64 SLEEP_WINDOW = 1000;
+    double sleepMean = 0.002;
+    double sleepVariance = 0.0;
+    Uint64 sleepSamples = 1;
+
+    void sleepUntil(Uint64 deadline);
+};
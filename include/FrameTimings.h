@@ -0,0 +1,47 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+
+enum FrameStage {
+    STAGE_INPUT,    // event pump + sampling buttons
+    STAGE_UPDATE,   // all fixed ticks run this frame
+    STAGE_RENDER,   // building the batch and submitting it
+    STAGE_CAPTURE,  // reading the frame back for FrameCapture (0 when off)
+    STAGE_PRESENT,  // SDL_RenderPresent
+    STAGE_FRAME,    // whole frame, pacing excluded
+    STAGE_COUNT
+};
+
+// Per-stage frame times collected over a run, reported as percentiles.
+// Samples are kept in full (a float per stage per frame) so the numbers are
+// exact rather than bucketed.
+class FrameTimings {
+public:
+    struct Summary {
+        int frames = 0;
+        double meanUs = 0.0;
+        double p50Us = 0.0;
+        double p95Us = 0.0;
+        double p99Us = 0.0;
+        double maxUs = 0.0;
+    };
+
+    void reserve(size_t frames);
+    void clear();
+
+    void record(FrameStage stage, Uint64 startTicks, Uint64 endTicks);
+
+    Summary summarize(FrameStage stage) const;
+    // Same percentiles over any list of microsecond samples
+    static Summary summarizeSamples(const std::vector<float>& values);
+    static const char* stageName(FrameStage stage);
+
+    void print() const;
+    bool writeCsv(const char* path) const;
+    bool writeJson(const char* path) const;
+    // Picks the format from the extension (.csv, otherwise JSON)
+    bool write(const char* path) const;
+
+private:
+    std::vector<float> samples[STAGE_COUNT]; // microseconds
+};
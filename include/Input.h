@@ -0,0 +1,83 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <vector>
+#include "FrameTimings.h"
+
+// Game buttons as one bitmask per tick. The simulation only ever sees these,
+// never raw keys, so a scripted scenario can stand in for the keyboard.
+enum InputButton : Uint16 {
+    BUTTON_UP    = 1 << 0,
+    BUTTON_DOWN  = 1 << 1,
+    BUTTON_LEFT  = 1 << 2,
+    BUTTON_RIGHT = 1 << 3,
+    BUTTON_FOCUS = 1 << 4, // slow movement + show hurtbox
+    BUTTON_SHOOT = 1 << 5, // also confirms in menus
+    BUTTON_BOMB  = 1 << 6,
+    BUTTON_PAUSE = 1 << 7
+};
+
+// Keys bound to buttons, driven only by SDL key events (the main loop is the
+// one place that polls). Besides what is held it keeps every press and
+// release since the last sample, so a tap that goes down and up between two
+// ticks still reaches the simulation for one tick. The buttons are atomic, so
+// a simulation thread can sample() while the main loop feeds events.
+class ActionMap {
+public:
+    ActionMap(); // WASD/arrows, LShift focus, Z shoot, X bomb, Esc pause
+
+    void bind(SDL_Scancode key, Uint16 buttons);
+    // Returns true if the event was a bound key going down or up
+    bool handleEvent(const SDL_Event& e);
+    // Everything let go, e.g. when the window loses focus
+    void releaseAll();
+
+    // Buttons for one tick: held now, plus anything tapped since the last
+    // sample. Edges are then taken tick to tick from these (see handleInput),
+    // which keeps them in the recorded stream.
+    Uint16 sample();
+    // What sample() would return, without consuming anything
+    Uint16 peek() const { return held.load(std::memory_order_relaxed) | tapped.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int BUTTON_BITS = 16;
+
+    Uint16 bindings[SDL_NUM_SCANCODES];
+    Uint8 keyDown[SDL_NUM_SCANCODES];
+    Uint8 holdCount[BUTTON_BITS] = {}; // keys currently down per button
+
+    std::atomic<Uint16> held{ 0 };
+    std::atomic<Uint16> tapped{ 0 }; // pressed since the last sample, held or not
+};
+
+// Time from a key event to the SDL_RenderPresent that first shows its
+// effect. Events are pending until the simulation (or a late latch) reads
+// the buttons, then the next present completes them.
+class InputLatency {
+public:
+    InputLatency(); // reserves room so recording a key doesn't allocate
+
+    // SDL event timestamps are milliseconds on the SDL_GetTicks clock; the
+    // part after the event reaches us is timed with the performance counter
+    void keyEvent(Uint32 eventTimestamp);
+    void sampled();
+    // Only events polled up to upTo (performance counter), for a simulation
+    // that read its buttons on another thread at that time
+    void sampled(Uint64 upTo);
+    void presented();
+    // Events not read yet (e.g. queued on the title screen) are dropped
+    void discardPending() { pending.clear(); }
+    void clear();
+
+    FrameTimings::Summary summarize() const { return FrameTimings::summarizeSamples(samples); }
+    void print() const;
+
+private:
+    struct Event {
+        float ageUs;     // already old when we polled it
+        Uint64 polledAt; // performance counter
+    };
+    std::vector<Event> pending;
+    std::vector<Event> awaitingPresent;
+    std::vector<float> samples; // microseconds
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+
+// Every tick's InputButton mask from the moment a game starts, enough to
+// replay the run exactly. Stored as runs: each run is a LEB128 varint tick
+// count followed by a varint of the mask XORed with the previous run's mask,
+// so holding a direction for a second costs two or three bytes.
+//
+// File: RecordingHeader, then header.byteCount bytes of runs.
+class InputRecording {
+public:
+    static constexpr Uint32 MAGIC = 0x43455244; // "DREC"
+    static constexpr Uint32 VERSION = 1;
+
+    struct RecordingHeader {
+        Uint32 magic;
+        Uint32 version;
+        Uint32 scenarioId;   // BenchScenario::id(), 0 for none
+        Uint32 tickCount;
+        Uint64 finalHash;    // Engine::simulationHash() after the last tick
+        Uint32 byteCount;
+        Uint32 stageHash;    // Stage::nameHash(), 0 for none
+    };
+
+    // Steps through the recording one tick at a time
+    class Reader {
+    public:
+        explicit Reader(const InputRecording& recording) : recording(&recording) {}
+        bool done() const { return tick >= recording->tickCount(); }
+        Uint16 next();
+
+    private:
+        const InputRecording* recording;
+        size_t offset = 0;
+        Uint32 tick = 0;
+        Uint32 runLeft = 0;
+        Uint16 mask = 0;
+    };
+
+    void clear();
+    void push(Uint16 buttons);
+
+    Uint32 tickCount() const { return ticks; }
+    Uint32 scenarioId = 0;
+    Uint32 stageHash = 0;
+    Uint64 finalHash = 0;
+
+    // Flushes the open run; call once after the last push
+    void finish();
+
+    bool save(const char* path) const;
+    bool load(const char* path);
+    size_t encodedSize() const { return bytes.size(); }
+
+private:
+    std::vector<Uint8> bytes;
+    Uint32 ticks = 0;
+    Uint16 lastMask = 0;     // mask of the last flushed run
+    Uint16 openMask = 0;
+    Uint32 openLength = 0;
+
+    void writeVarint(Uint32 v);
+};
@@ -0,0 +1,159 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "Profiler.h"
+
+// One unit of work. Jobs live wherever the code that submits them lives
+// (usually its stack frame) and that code waits on counter before the job
+// goes out of scope, so the scheduler never allocates.
+struct Job {
+    void (*run)(Job& job) = nullptr;
+    void* context = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+    std::atomic<int>* counter = nullptr; // decremented when run() returns
+};
+
+// Chase-Lev deque of fixed capacity: the owning thread pushes and pops at
+// the bottom, any other thread steals from the top
+class WorkStealingDeque {
+public:
+    static constexpr size_t CAPACITY = 4096;
+
+    bool push(Job* job);
+    Job* pop();
+    Job* steal();
+
+private:
+    std::atomic<Sint64> top{ 0 };
+    std::atomic<Sint64> bottom{ 0 };
+    std::atomic<Job*> items[CAPACITY] = {};
+};
+
+// Fixed pool of worker threads. Each thread, and the one thread outside the
+// pool that drives the simulation, owns a deque; idle threads steal from the
+// others. Work is always split into chunks whose size the caller picks, never
+// by thread count, so results come out the same on 1 thread or 16.
+class JobSystem {
+public:
+    JobSystem() = default;
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Total threads including the caller; 1 runs everything inline
+    void start(int threads);
+    void stop();
+    int threadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+    void submit(Job& job);
+    // Runs other jobs until counter drops to zero
+    void wait(const std::atomic<int>& counter);
+
+    // fn(begin, end) for every chunk of [0, count); returns when all are done.
+    // Chunk boundaries depend only on count and chunkSize.
+    template<typename Fn>
+    void parallelFor(size_t count, size_t chunkSize, Fn&& fn);
+
+private:
+    static constexpr int MAX_JOBS_PER_FOR = 64;
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques; // [0] is the external thread's
+    std::atomic<bool> stopping{ false };
+
+    // Idle workers sleep here instead of spinning between ticks
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<Uint64> workEpoch{ 0 };
+    std::atomic<int> sleepers{ 0 };
+
+    void workerLoop(int index);
+    Job* findJob(int self, Uint32& rng);
+    static void execute(Job& job);
+
+    template<typename Fn>
+    struct ForContext {
+        Fn* fn;
+        size_t count;
+        size_t chunkSize;
+    };
+};
+
+template<typename Fn>
+void JobSystem::parallelFor(size_t count, size_t chunkSize, Fn&& fn) {
+    if (count == 0) return;
+    if (chunkSize == 0) chunkSize = 1;
+    const size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+    if (chunks == 1 || workers.empty()) {
+        for (size_t begin = 0; begin < count; begin += chunkSize) {
+            fn(begin, begin + chunkSize < count ? begin + chunkSize : count);
+        }
+        return;
+    }
+
+    // Each job takes a contiguous run of chunks; fn still sees the same
+    // chunk boundaries however the runs are grouped
+    using F = typename std::remove_reference<Fn>::type;
+    ForContext<F> ctx = { &fn, count, chunkSize };
+    size_t jobCount = chunks < MAX_JOBS_PER_FOR ? chunks : MAX_JOBS_PER_FOR;
+    Job jobs[MAX_JOBS_PER_FOR];
+    std::atomic<int> remaining(static_cast<int>(jobCount));
+
+    for (size_t j = 0; j < jobCount; ++j) {
+        Job& job = jobs[j];
+        job.context = &ctx;
+        job.begin = chunks * j / jobCount;
+        job.end = chunks * (j + 1) / jobCount;
+        job.counter = &remaining;
+        job.run = [](Job& self) {
+            ForContext<F>& c = *static_cast<ForContext<F>*>(self.context);
+            for (size_t chunk = self.begin; chunk < self.end; ++chunk) {
+                size_t b = chunk * c.chunkSize;
+                size_t e = b + c.chunkSize < c.count ? b + c.chunkSize : c.count;
+                (*c.fn)(b, e);
+            }
+        };
+    }
+    // Keep the first run for ourselves; everything else is up for stealing
+    for (size_t j = 1; j < jobCount; ++j) submit(jobs[j]);
+    execute(jobs[0]);
+    wait(remaining);
+}
+
+// A fixed set of named tasks with dependencies, built once and run every
+// tick. Tasks whose dependencies are done are submitted as jobs; a task may
+// itself call parallelFor.
+class TaskGraph {
+public:
+    // Returns the task id to use in later deps lists. name must be a literal;
+    // it is used as the profiler zone.
+    int add(const char* name, std::function<void()> fn, std::initializer_list<int> deps = {});
+    void run(JobSystem& jobs);
+
+private:
+    struct Task {
+        const char* name;
+        std::function<void()> fn;
+        std::vector<int> successors;
+        int dependencyCount = 0;
+        std::atomic<int> pending{ 0 };
+        Job job;
+    };
+
+    std::vector<std::unique_ptr<Task>> tasks;
+    JobSystem* activeJobs = nullptr;
+    std::atomic<int> remaining{ 0 };
+
+    static void runTask(Job& job);
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <SDL.h>
+#include <cstddef>
+#include <vector>
+#include "Playfield.h"
+
+class StateWriter;
+class StateReader;
+
+// Everything needed to start one laser.
+struct LaserSpawn {
+    float x, y;
+    float speed;         // pixels per second, along the path
+    float angle;         // radians
+    float angularVel;    // radians per second, bends the path
+    float lifetime;      // seconds the head keeps going
+    float radius;        // half the beam's width
+    Uint32 color;        // 0xRRGGBBAA
+    Uint32 length;       // nodes kept behind the head, at most NODES_PER_LASER
+};
+
+// Curved lasers: a head that moves like a bullet and leaves one path node
+// per tick, with the body being every node still kept behind it. Nodes never
+// move once laid, so the body bends wherever the head turned. When the head
+// runs out of life or leaves the playfield it stops, and the tail keeps
+// dropping one node per tick until nothing is left.
+//
+// Nodes come out of one segment pool: a fixed block of NODES_PER_LASER per
+// laser, used as a ring, handed out and taken back through a free list, so
+// nothing is allocated after construction. Each laser keeps the bounding
+// box of its nodes for cheap rejection in the hit, graze and bomb tests.
+class LaserPool {
+public:
+    static constexpr size_t NODES_PER_LASER = 128;
+
+    explicit LaserPool(size_t capacity);
+
+    bool spawn(const LaserSpawn& l);
+    void clear();
+
+    // Move the heads, lay and drop nodes, and remove finished lasers
+    void update(float dt, const Playfield& bounds);
+
+    // Does a circle of radius moving from (x0, y0) to (x1, y1) this tick
+    // touch any laser? Swept capsule against each segment's capsule.
+    bool hits(float x0, float y0, float x1, float y1, float radius) const;
+    // Same test, counting each laser once the first time it passes within
+    // radius; returns how many did this time
+    size_t graze(float x0, float y0, float x1, float y1, float radius);
+    // Removes every laser with a node within radius of the center on the
+    // next update(); returns how many (bombs)
+    size_t killInRadius(float cx, float cy, float radius);
+
+    size_t size() const { return lasers.size(); }
+    size_t capacity() const { return maxLasers; }
+    // Nodes across every live laser
+    size_t nodeCount() const;
+
+    // A laser's nodes from tail to head, in two spans since the ring wraps:
+    // the first span count is returned, the rest starts at the block's front
+    struct Path {
+        const float* x;
+        const float* y;
+        size_t firstCount;
+        const float* wrapX;
+        const float* wrapY;
+        size_t count;
+        float radius;
+        Uint32 color;
+        float headDx, headDy;  // how far the head and tail moved this tick
+        float tailDx, tailDy;
+    };
+    Path path(size_t i) const;
+
+    // Live lasers and their nodes into a state image and back (see StateSnapshot.h)
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+private:
+    static constexpr Uint8 FLAG_GRAZED = 1;
+    static constexpr Uint8 FLAG_DEAD = 2;
+
+    struct Laser {
+        float x, y;          // head
+        float speed, angle, angularVel;
+        float life;
+        float radius;
+        Uint32 color;
+        Uint32 block;        // index into the segment pool
+        Uint16 first;        // oldest node in the ring
+        Uint16 count;
+        Uint16 length;
+        Uint8 flags;
+        Uint8 emitting;      // head still moving and laying nodes
+        float minX, minY, maxX, maxY; // of the nodes
+        float headDx, headDy;
+        float tailDx, tailDy;
+    };
+
+    size_t maxLasers;
+    std::vector<Laser> lasers;
+    std::vector<float> nodeX;    // maxLasers blocks of NODES_PER_LASER
+    std::vector<float> nodeY;
+    std::vector<Uint32> freeBlocks;
+
+    void updateBounds(Laser& l);
+    // Smallest squared distance from the segment (x0, y0)-(x1, y1) to any
+    // segment of the laser
+    float distanceSquared(const Laser& l, float x0, float y0, float x1, float y1) const;
+    bool boundsOverlap(const Laser& l, float minX, float minY, float maxX, float maxY, float margin) const {
+        return l.minX - margin <= maxX && l.maxX + margin >= minX &&
+               l.minY - margin <= maxY && l.maxY + margin >= minY;
+    }
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <SDL.h>
+#include <cstddef>
+#include "Playfield.h"
+
+class JobSystem;
+
+// How one emitter call shapes its particles. Speeds, lifetimes and sizes are
+// picked per particle; colors and radii are interpolated over each
+// particle's life, start to end.
+struct ParticlePreset {
+    float speedMin, speedMax;  // pixels per second
+    float lifeMin, lifeMax;    // seconds
+    float radiusStart;         // pixels
+    float radiusEnd;
+    Uint32 colorStart;         // 0xRRGGBBAA
+    Uint32 colorEnd;
+    float drag;                // fraction of velocity lost per second
+    float gravity;             // pixels per second^2, downwards
+};
+
+// Purely visual particles (bomb blasts, hits, trails) in a fixed-capacity
+// structure-of-arrays pool, same layout idea as BulletPool. update() moves
+// them, ages them and writes the current radius and color for drawing, 4 or
+// 8 per instruction, then swap-removes the dead. Nothing is allocated after
+// construction; spawns past capacity are dropped and counted.
+//
+// The simulation never reads them back, so the random spread doesn't need
+// to be (and isn't) part of a recording.
+class ParticleSystem {
+public:
+    explicit ParticleSystem(size_t capacity);
+    ~ParticleSystem();
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    // Random directions from one point
+    void burst(float x, float y, int count, const ParticlePreset& preset);
+    // Evenly spaced around a circle of the given radius, moving outwards
+    void ring(float x, float y, int count, float radius, const ParticlePreset& preset);
+    // Spread along a segment, drifting in random directions
+    void trail(float x0, float y0, float x1, float y1, int count, const ParticlePreset& preset);
+
+    void update(float dt, const Playfield& bounds);
+    // Same, with the kernel split into fixed blocks across the job system
+    void update(float dt, const Playfield& bounds, JobSystem& jobs);
+    void clear() { count = 0; }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return maxParticles; }
+    Uint64 droppedSpawns() const { return dropped; }
+
+    // Current state, as of the last update()
+    const float* posX() const { return x; }
+    const float* posY() const { return y; }
+    const float* velX() const { return vx; }
+    const float* velY() const { return vy; }
+    const float* radii() const { return radius; }
+    const Uint32* colors() const { return color; }
+
+private:
+    size_t maxParticles = 0;
+    size_t paddedCapacity = 0;
+    size_t count = 0;
+    Uint64 dropped = 0;
+    Uint32 rng = 0x9E3779B9u;
+    void* block = nullptr;     // single aligned allocation backing every array below
+
+    float* x = nullptr;
+    float* y = nullptr;
+    float* vx = nullptr;
+    float* vy = nullptr;
+    float* gravity = nullptr;
+    float* drag = nullptr;
+    float* life = nullptr;        // seconds left
+    float* invLifetime = nullptr; // 1 / starting life
+    float* radiusStart = nullptr;
+    float* radiusEnd = nullptr;
+    float* radius = nullptr;
+    Uint32* colorStart = nullptr;
+    Uint32* colorEnd = nullptr;
+    Uint32* color = nullptr;
+    Uint8* deadMask = nullptr;    // one bit per particle, filled by the kernel
+
+    // Particles per update job; a multiple of 8 so no two jobs share a
+    // deadMask byte
+    static constexpr size_t JOB_BLOCK = 8192;
+
+    float random01();
+    // Claims a slot and fills everything but position and velocity;
+    // returns false when full
+    bool emit(size_t& index, const ParticlePreset& preset);
+
+    bool integrate(size_t begin, size_t end, float dt, const Playfield& bounds);
+    void compact();
+    void moveParticle(size_t from, size_t to);
+
+    bool isDead(size_t i) const { return (deadMask[i >> 3] >> (i & 7)) & 1; }
+    void setDead(size_t i, bool dead) {
+        Uint8 bit = static_cast<Uint8>(1u << (i & 7));
+        if (dead) deadMask[i >> 3] |= bit;
+        else deadMask[i >> 3] &= static_cast<Uint8>(~bit);
+    }
+};
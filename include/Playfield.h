@@ -0,0 +1,25 @@
+#pragma once
+
+// Inner edges of the playfield (left half of the window, inside the walls).
+// Shared by player clamping, bullet culling and anything else that needs to
+// know where the game area ends.
+struct Playfield {
+    float left;
+    float top;
+    float right;
+    float bottom;
+
+    static constexpr int WALL_THICKNESS = 10;
+
+    static Playfield fromWindow(int width, int height) {
+        return {
+            static_cast<float>(WALL_THICKNESS),
+            static_cast<float>(WALL_THICKNESS),
+            static_cast<float>((width / 2) - WALL_THICKNESS), // leave room before divider
+            static_cast<float>(height - WALL_THICKNESS)
+        };
+    }
+
+    float width() const { return right - left; }
+    float height() const { return bottom - top; }
+};
@@ -0,0 +1,142 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Set to 0 (CMake option ENGINE_PROFILING) to compile every zone out
+#ifndef ENGINE_PROFILING
+#define ENGINE_PROFILING 1
+#endif
+
+struct ProfileEvent {
+    const char* name;  // string literal; zones are told apart by pointer
+    Uint64 start;      // performance counter ticks
+    Uint64 end;
+    Uint32 threadId;
+    Uint16 depth;      // nesting level on its thread
+};
+
+// Bounded single-producer/single-consumer ring. Each thread that opens a
+// zone gets its own, so recording is two counter reads and a store with no
+// locks; the profiler drains all rings once per frame. When a ring is full
+// new events are dropped (and counted) rather than overwriting unread ones.
+class ProfileRing {
+public:
+    static constexpr size_t CAPACITY = 1 << 14;
+
+    explicit ProfileRing(Uint32 threadId) : threadId(threadId) {}
+
+    void push(const ProfileEvent& e) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= CAPACITY) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[h & (CAPACITY - 1)] = e;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    template<typename Fn>
+    void drain(Fn&& fn) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        for (; t != h; ++t) fn(events[t & (CAPACITY - 1)]);
+        tail.store(t, std::memory_order_release);
+    }
+
+    const Uint32 threadId;
+    Uint16 depth = 0; // only touched by the owning thread
+    std::atomic<Uint64> dropped{ 0 };
+
+private:
+    ProfileEvent events[CAPACITY];
+    std::atomic<size_t> head{ 0 };
+    std::atomic<size_t> tail{ 0 };
+};
+
+// Collects zones from every thread, keeps a rolling per-zone history for
+// the overlay and can capture a stretch of frames as a Chrome trace
+// (chrome://tracing or ui.perfetto.dev).
+class Profiler {
+public:
+    static constexpr int MAX_ZONES = 64;
+    static constexpr int HISTORY = 120; // frames
+
+    struct Zone {
+        const char* name = nullptr;
+        Uint16 depth = 0;
+        float history[HISTORY] = {}; // ms per frame, summed over calls
+    };
+
+    static Profiler& get();
+
+    // The calling thread's ring, registered on first use
+    static ProfileRing& threadRing();
+
+    // Bracket each frame on the main thread
+    void beginFrame();
+    void endFrame();
+
+    int zoneCount() const { return static_cast<int>(zones.size()); }
+    const Zone& zone(int i) const { return zones[i]; }
+    float zoneAverageMs(int i) const;
+    float zoneMaxMs(int i) const;
+
+    // Frame work time in ms (beginFrame to endFrame, pacing excluded)
+    const float* frameHistory() const { return frameMs; }
+    // Index of the oldest entry in zone and frame histories
+    int historyStart() const { return historyHead; }
+    Uint64 droppedEvents() const;
+
+    void startCapture();
+    bool stopCapture(const char* path); // writes trace_event JSON
+    bool isCapturing() const { return capturing; }
+
+private:
+    Profiler() = default;
+
+    std::mutex ringsMutex; // only guards the list, never held while recording
+    std::vector<std::unique_ptr<ProfileRing>> rings;
+    std::atomic<Uint32> nextThreadId{ 0 };
+
+    std::vector<ProfileEvent> frameEvents;
+    std::vector<Zone> zones;
+    float frameMs[HISTORY] = {};
+    int historyHead = 0;
+    Uint64 frameStart = 0;
+
+    bool capturing = false;
+    Uint64 captureStart = 0;
+    std::vector<ProfileEvent> captured;
+
+    ProfileRing& registerThread();
+    int findZone(const char* name, Uint16 depth);
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : ring(Profiler::threadRing()), name(name), depth(ring.depth++), start(SDL_GetPerformanceCounter()) {}
+    ~ProfileScope() {
+        ring.depth--;
+        ring.push({ name, start, SDL_GetPerformanceCounter(), ring.threadId, depth });
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfileRing& ring;
+    const char* name;
+    Uint16 depth;
+    Uint64 start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#if ENGINE_PROFILING
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "SpriteBatch.h"
+
+class CircleRenderer;
+class TextRenderer;
+
+// Draw calls recorded as plain data, so one thread can describe a frame and
+// the thread that owns the SDL_Renderer can draw it later. Recording never
+// touches SDL. Everything that moves carries how far it moved over the last
+// tick, and replay() draws it at (x - dx * (1 - alpha), y - dy * (1 - alpha)),
+// the same interpolation the renderer used to do on live state.
+//
+// clear() keeps every buffer's capacity, so once a list has held a busy
+// frame, recording into it stops allocating.
+class RenderCommandList {
+public:
+    // Arrays to fill for a run of circles from beginCircles()
+    struct CircleRun {
+        float* x;
+        float* y;
+        float* dx;
+        float* dy;
+        float* radius;
+        Uint32* color;   // 0xRRGGBBAA
+    };
+    // One connected strip of a run from beginStrips(). Its nodes never move;
+    // only the two ends are drawn stepped back by what they moved.
+    struct Strip {
+        Uint32 nodes;
+        float radius;    // half the width
+        Uint32 color;    // 0xRRGGBBAA
+        float headDx, headDy;
+        float tailDx, tailDy;
+    };
+    // What to fill for a run of strips: one Strip each, and every strip's
+    // nodes back to back from tail to head
+    struct StripRun {
+        Strip* strips;
+        float* x;
+        float* y;
+    };
+
+    void clear();
+
+    // sprite must outlive the list; the game's sprites live as long as the engine
+    void sprite(const Sprite& sprite, const SDL_FRect& dst, float dx, float dy, Uint8 layer,
+                SDL_Color color = { 255, 255, 255, 255 });
+    void rect(const SDL_FRect& dst, Uint8 layer, SDL_Color color, SDL_BlendMode blend = SDL_BLENDMODE_NONE);
+    void circle(float x, float y, float dx, float dy, float radius, SDL_Color color, Uint8 layer);
+    // Centered lines have x in the middle; measuring waits for replay
+    void text(const char* str, int x, int y, SDL_Color color, Uint8 layer, bool centered = false);
+    // Room for count circles drawn straight from the circle atlas, one quad
+    // each and one draw call per run (bullets, particles, enemies)
+    CircleRun beginCircles(size_t count, SDL_BlendMode blend, Uint8 layer);
+    // Room for strips (lasers) with nodes between them, drawn through the
+    // middle column of a circle sprite so the beam gets the same soft edge
+    // as the bullets, and shares their draw call
+    StripRun beginStrips(size_t strips, size_t nodes, SDL_BlendMode blend, Uint8 layer);
+
+    // Draws everything in recording order into the batch
+    void replay(SpriteBatch& batch, CircleRenderer& circles, TextRenderer& text, float alpha) const;
+
+    size_t commandCount() const { return commands.size(); }
+    size_t circleCount() const { return circlesUsed; }
+
+private:
+    enum class Type : Uint8 {
+        SPRITE, RECT, CIRCLE, TEXT, CIRCLES, STRIPS
+    };
+
+    struct Command {
+        Type type;
+        Uint8 layer;
+        bool centered;
+        SDL_BlendMode blend;
+        SDL_Color color;
+        const Sprite* sprite;
+        SDL_FRect rect;    // SPRITE, RECT: destination; CIRCLE: x, y, radius; TEXT: x, y
+        float dx, dy;
+        Uint32 first;      // CIRCLES: first circle; STRIPS: first strip; TEXT: offset into chars
+        Uint32 count;
+        Uint32 firstNode;  // STRIPS
+    };
+
+    std::vector<Command> commands;
+    std::vector<char> chars;
+
+    // Circle runs, structure-of-arrays; sized to the largest frame so far
+    size_t circlesUsed = 0;
+    std::vector<float> circleX, circleY, circleDx, circleDy, circleRadius;
+    std::vector<Uint32> circleColor;
+
+    // Strip runs: their strips, then every strip's nodes
+    std::vector<Strip> strips;
+    size_t stripNodesUsed = 0;
+    std::vector<float> stripX, stripY;
+
+    void replayCircles(const Command& c, SpriteBatch& batch, const CircleRenderer& circles, float rewind) const;
+    void replayStrips(const Command& c, SpriteBatch& batch, const CircleRenderer& circles, float rewind) const;
+};
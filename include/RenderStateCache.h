@@ -0,0 +1,35 @@
+#pragma once
+#include <SDL.h>
+
+// Remembers the renderer state we last set so repeated identical
+// SDL_SetRenderDrawColor / blend mode calls are skipped. Anything that talks
+// to the renderer behind its back, or destroys a texture, must call invalidate().
+class RenderStateCache {
+public:
+    void attach(SDL_Renderer* renderer);
+    void invalidate();
+
+    void setDrawColor(SDL_Color color);
+    void setDrawBlendMode(SDL_BlendMode mode);
+    void setTextureBlendMode(SDL_Texture* texture, SDL_BlendMode mode);
+
+    SDL_Renderer* getRenderer() const { return renderer; }
+
+    // Calls made vs. calls skipped since resetStats()
+    int stateChanges = 0;
+    int stateChangesSkipped = 0;
+    void resetStats() { stateChanges = 0; stateChangesSkipped = 0; }
+
+private:
+    static constexpr int TEXTURE_SLOTS = 16;
+
+    SDL_Renderer* renderer = nullptr;
+    bool colorValid = false;
+    SDL_Color drawColor = { 0, 0, 0, 0 };
+    bool blendValid = false;
+    SDL_BlendMode drawBlend = SDL_BLENDMODE_NONE;
+
+    // Small direct-mapped cache of per-texture blend modes
+    SDL_Texture* textureKeys[TEXTURE_SLOTS] = {};
+    SDL_BlendMode textureBlend[TEXTURE_SLOTS] = {};
+};
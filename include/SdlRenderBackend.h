@@ -0,0 +1,39 @@
+#pragma once
+#include <SDL.h>
+
+class JobSystem;
+class RenderStateCache;
+
+// SpriteBatch's default backend: every run goes straight to
+// SDL_RenderGeometry, and textures and targets are plain SDL ones.
+class SdlRenderBackend {
+public:
+    bool init(SDL_Renderer* renderer, RenderStateCache& cache, int width, int height);
+    void cleanup() {}
+    void setJobs(JobSystem*) {}
+
+    // The GPU already has the pixels; nothing to keep
+    bool registerTexture(SDL_Texture*, SDL_Surface*) { return true; }
+    bool registerPixels(SDL_Texture*, const void*, int, int, int, bool) { return true; }
+
+    bool supportsTargets() const;
+    SDL_Texture* createTarget(int width, int height);
+    void destroyTexture(SDL_Texture* texture);
+    void setTarget(SDL_Texture* target);
+
+    void clear(SDL_Color color);
+    void drawGeometry(SDL_Texture* texture, SDL_BlendMode blend, const SDL_Vertex* vertices, int vertexCount,
+                      const int* indices, int indexCount);
+    // Everything is already with the renderer
+    void finish() {}
+    void present();
+    // What's been drawn to the window so far, as RGBA32 rows of width pixels.
+    // Waits for the GPU to get there, so capture pays for it, not present.
+    bool readPixels(Uint32* dst, int width, int height);
+
+    static const char* name() { return "sdl"; }
+
+private:
+    SDL_Renderer* renderer = nullptr;
+    RenderStateCache* cache = nullptr;
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <SDL.h>
+#include <vector>
+#include "RenderStateCache.h"
+#include "SdlRenderBackend.h"
+#include "CpuRenderBackend.h"
+
+// Draw order buckets. Lower layers are drawn first; inside a layer the batch
+// is free to reorder by texture and blend mode, so overlapping sprites that
+// must stack in a particular order need different layers.
+enum RenderLayer : Uint8 {
+    LAYER_BACKGROUND = 0,
+    LAYER_PLAYER,
+    LAYER_BULLETS,
+    LAYER_HURTBOX,
+    LAYER_HUD_BACK,   // backdrops for HUD text, e.g. the stage dialog box
+    LAYER_HUD,
+    LAYER_OVERLAY,
+    LAYER_OVERLAY_UI,
+    LAYER_DEBUG,
+    LAYER_COUNT
+};
+
+// A rectangle of some texture with its UVs already normalized
+struct Sprite {
+    SDL_Texture* texture = nullptr;
+    SDL_FRect uv = { 0.0f, 0.0f, 1.0f, 1.0f }; // x, y, w, h in 0..1
+    int width = 0;                              // source size in pixels
+    int height = 0;
+    SDL_BlendMode blend = SDL_BLENDMODE_BLEND;
+
+    static Sprite fromTexture(SDL_Texture* texture);
+};
+
+// Collects every quad of a frame, then submits them sorted by
+// (layer, texture, blend mode) so each run of identical state becomes one
+// draw call on the backend. Vertices stay in submission order; only the index
+// list is written in sorted order, and the sort itself is a counting sort
+// over the handful of distinct states seen this frame.
+//
+// Backend owns textures, render targets, clearing and presenting; both
+// backends are instantiated in SpriteBatch.cpp and the game uses whichever
+// ENGINE_CPU_RENDERER picks (see SpriteBatch below).
+template<typename Backend>
+class BasicSpriteBatch {
+public:
+    struct Stats {
+        int drawCalls = 0;
+        int quads = 0;
+        int vertices = 0;
+        int states = 0;       // distinct (layer, texture, blend) combinations
+    };
+
+    // width and height are the window's; the CPU backend sizes its
+    // framebuffer from them
+    bool init(SDL_Renderer* renderer, int width, int height, size_t expectedQuads);
+    void cleanup() { renderBackend.cleanup(); }
+
+    void draw(const Sprite& sprite, const SDL_FRect& dst, Uint8 layer, SDL_Color color = { 255, 255, 255, 255 });
+    void drawRect(const SDL_FRect& dst, Uint8 layer, SDL_Color color, SDL_BlendMode blend = SDL_BLENDMODE_NONE);
+    // Pre-built quad: v[0..3] = top-left, top-right, bottom-left, bottom-right
+    void drawQuad(SDL_Texture* texture, SDL_BlendMode blend, Uint8 layer, const SDL_Vertex* v);
+    // Hand out room for `count` quads in one go; fill 4 vertices per quad
+    SDL_Vertex* reserveQuads(SDL_Texture* texture, SDL_BlendMode blend, Uint8 layer, size_t count);
+
+    // Sort, submit and reset for the next frame
+    void flush();
+
+    Backend& backend() { return renderBackend; }
+    RenderStateCache& stateCache() { return cache; }
+    const Stats& lastFrameStats() const { return stats; }
+
+private:
+    struct State {
+        SDL_Texture* texture;
+        SDL_BlendMode blend;
+        Uint8 layer;
+    };
+
+    RenderStateCache cache;
+    Backend renderBackend;
+    Stats stats;
+
+    std::vector<SDL_Vertex> vertices;
+    std::vector<Uint16> quadState;  // state id per quad
+    std::vector<State> states;
+    int lastState = -1;
+
+    // flush() scratch, kept around so steady-state frames don't allocate
+    std::vector<int> indices;
+    std::vector<Uint32> stateCount;
+    std::vector<Uint16> stateRank;
+    std::vector<Uint16> rankOrder;
+
+    Uint16 findState(SDL_Texture* texture, SDL_BlendMode blend, Uint8 layer);
+    void submitRun(const State& state, size_t firstIndex, size_t indexCount);
+};
+
+#if ENGINE_CPU_RENDERER
+using RenderBackend = CpuRenderBackend;
+#else
+using RenderBackend = SdlRenderBackend;
+#endif
+using SpriteBatch = BasicSpriteBatch<RenderBackend>;
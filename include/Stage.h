@@ -0,0 +1,224 @@
+#pragma once
+#include <SDL.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "BulletPattern.h"
+#include "Playfield.h"
+#include "World.h"
+
+class StateWriter;
+class StateReader;
+
+// A stage is a text script of timed events, one per line, in time order;
+// '#' starts a comment:
+//
+//   stage <name>                            optional, first line
+//   <time> wave <count> <x> <y> <vx> <vy> <hp> [<dx> <dy>]
+//                                           count enemies, each offset by (dx, dy)
+//   <time> pattern <name> <x> <y> [<count> <dx>]
+//                                           pattern emitters in a row
+//   <time> dialog <ticks> <text...>         line of dialog shown for ticks
+//   <time> boss <hp> <x> <y> <name...>      the boss enemy
+//   <time> phase <pattern> <count> <name...>
+//                                           retires every emitter, then puts
+//                                           count new ones around the boss;
+//                                           skipped without a live boss
+//   <time> clear                            retires every emitter
+//   <time> end                              stage cleared
+//
+// Times are ticks since the stage started ("90"), seconds ("1.5s"), or
+// either one after the previous event ("+30", "+2s"). Positions and
+// velocities are pixels (per second) from the playfield's top-left corner.
+
+enum class StageEventType : Uint8 {
+    WAVE, PATTERN, DIALOG, BOSS, PHASE, CLEAR, END
+};
+
+struct StageEvent {
+    Uint32 tick;
+    Uint32 sequence;       // file order, set by the scheduler
+    StageEventType type;
+    int count;             // enemies or emitters; dialog duration in ticks
+    int hp;
+    int program;           // pattern id
+    float x, y;
+    float vx, vy;
+    float dx, dy;
+    char text[64];         // dialog line, boss or phase name
+};
+
+// Pending events in a timer wheel: one bucket per tick for the next
+// WHEEL_SLOTS ticks, each a FIFO list through a fixed pool, and a min-heap
+// for anything further out that moves onto the wheel as it comes in range.
+// advance() only ever looks at the current tick's bucket, so a tick costs
+// O(events due) however many are waiting, and nothing allocates after
+// construction.
+class StageScheduler {
+public:
+    static constexpr Uint32 WHEEL_SLOTS = 512;
+
+    explicit StageScheduler(size_t capacity);
+
+    // Drops everything; the next advance() dispatches tick
+    void reset(Uint32 tick);
+    // Events at or before the current tick go out on the next advance().
+    // Returns false when the pool is full.
+    bool schedule(const StageEvent& event);
+
+    // fn(event) for every event due this tick, in the order they were
+    // scheduled, then moves on to the next tick
+    template<typename Fn>
+    size_t advance(Fn&& fn);
+
+    Uint32 now() const { return currentTick; }
+    size_t pending() const { return pendingCount; }
+    bool full() const { return freeHead == NONE; }
+
+    // Just the pending events, in dispatch order, into a state image; loading
+    // puts them back in the same buckets and heap with the same sequences
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+private:
+    static constexpr Uint32 NONE = 0xFFFFFFFFu;
+
+    std::vector<StageEvent> pool;
+    std::vector<Uint32> nextIndex; // bucket lists and the free list
+    Uint32 freeHead = NONE;
+    Uint32 heads[WHEEL_SLOTS];
+    Uint32 tails[WHEEL_SLOTS];
+    std::vector<Uint32> overflow;  // heap of pool indices, earliest first
+    Uint32 currentTick = 0;
+    Uint32 nextSequence = 0;
+    size_t pendingCount = 0;
+
+    void append(Uint32 index);
+    void release(Uint32 index);
+    void migrateOverflow();
+    bool later(Uint32 a, Uint32 b) const;
+};
+
+template<typename Fn>
+size_t StageScheduler::advance(Fn&& fn) {
+    const Uint32 slot = currentTick & (WHEEL_SLOTS - 1);
+    Uint32 index = heads[slot];
+    heads[slot] = NONE;
+    tails[slot] = NONE;
+
+    // Everything on the wheel is within WHEEL_SLOTS ticks, so this bucket
+    // holds exactly the events due now
+    size_t dispatched = 0;
+    while (index != NONE) {
+        Uint32 next = nextIndex[index];
+        fn(static_cast<const StageEvent&>(pool[index]));
+        release(index);
+        index = next;
+        dispatched++;
+    }
+    currentTick++;
+    migrateOverflow();
+    return dispatched;
+}
+
+// Parses a stage script a line at a time through a small fixed buffer, so a
+// long stage costs the same to start as a short one
+class StageReader {
+public:
+    StageReader() = default;
+    ~StageReader();
+    StageReader(const StageReader&) = delete;
+    StageReader& operator=(const StageReader&) = delete;
+
+    // Reads up to the first event; false if the file can't be opened
+    bool open(const char* path, int ticksPerSecond);
+    void close();
+
+    // The next event, or false at the end of the script or on an error
+    bool next(const PatternLibrary& patterns, StageEvent& out);
+    bool failed() const { return !error.empty(); }
+    // "line N: ..." after a failed next()
+    const std::string& errorMessage() const { return error; }
+    const char* stageName() const { return name; }
+
+    // Where the next line starts in the file, and the parse state around it;
+    // loading seeks back there (reopening the file if it was closed since)
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+private:
+    static constexpr size_t BUFFER_SIZE = 4096;
+    static constexpr size_t MAX_LINE = 256;
+
+    std::FILE* file = nullptr;
+    std::string path;
+    long bufferOffset = 0;       // file position of buffer[0]
+    char buffer[BUFFER_SIZE];
+    size_t bufferPos = 0;
+    size_t bufferLen = 0;
+    char line[MAX_LINE];
+    int lineNumber = 0;
+    bool atEnd = true;
+    int ticksPerSecond = 60;
+    Uint32 lastTick = 0;
+    char name[64] = "";
+    std::string error;
+
+    bool readLine();
+    bool fail(const char* message);
+    bool parseTime(const char* token, Uint32& tick);
+};
+
+// Runs one stage: keeps the scheduler filled LOOKAHEAD_TICKS ahead of the
+// current tick from the reader and carries out whatever falls due
+class Stage {
+public:
+    static constexpr Uint32 LOOKAHEAD_TICKS = 240;
+    static constexpr size_t MAX_PENDING = 4096;
+
+    Stage() : scheduler(MAX_PENDING) {}
+
+    bool start(const char* path, const PatternLibrary& patterns, int ticksPerSecond);
+    void stop();
+    bool active() const { return running; }
+    // Reached 'end', or ran out of script with nothing left pending
+    bool finished() const { return cleared; }
+
+    // One tick of the stage, before the simulation's own update
+    void update(const PatternLibrary& patterns, EmitterPool& emitters, World& world, const Playfield& bounds);
+
+    Uint32 tick() const { return scheduler.now(); }
+    size_t pendingEvents() const { return scheduler.pending(); }
+    const char* name() const { return reader.stageName(); }
+    // FNV-1a of the stage name, for recordings; 0 when no stage is running
+    Uint32 nameHash() const;
+
+    // Null when nothing is being said
+    const char* dialog() const { return dialogTicks > 0 ? dialogText : nullptr; }
+    // Null outside a boss fight
+    const char* bossName(const World& world) const { return world.alive(boss) ? bossTitle : nullptr; }
+    const char* phaseName(const World& world) const { return world.alive(boss) ? phaseTitle : nullptr; }
+
+    // Scheduler, script position, dialog and boss into a state image and back
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+private:
+    StageReader reader;
+    StageScheduler scheduler;
+    StageEvent lookahead;        // read from the file but not yet in range
+    bool haveLookahead = false;
+    bool readerDone = true;
+    bool running = false;
+    bool cleared = false;
+
+    char dialogText[64] = "";
+    int dialogTicks = 0;
+    Entity boss;
+    char bossTitle[64] = "";
+    char phaseTitle[64] = "";
+
+    void fill(const PatternLibrary& patterns);
+    void dispatch(const StageEvent& event, const PatternLibrary& patterns, EmitterPool& emitters, World& world,
+                  const Playfield& bounds);
+};
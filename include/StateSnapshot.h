@@ -0,0 +1,124 @@
+#pragma once
+#include <SDL.h>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Simulation state as one flat byte image. Every system writes its plain
+// data straight out with memcpy and reads it back the same way, in the same
+// order; there are no field tags or versions inside, so an image is only
+// good for the build (and the engine) that wrote it. That is all rewind,
+// practice restarts and rollback need, and it keeps a 20k-bullet scene to a
+// few straight copies each way.
+
+// Appends to a buffer that keeps its capacity, so writing an image no
+// bigger than the last one doesn't allocate
+class StateWriter {
+public:
+    explicit StateWriter(std::vector<Uint8>& out) : out(out) { out.clear(); }
+
+    void write(const void* data, size_t bytes) {
+        const Uint8* p = static_cast<const Uint8*>(data);
+        out.insert(out.end(), p, p + bytes);
+    }
+    template<typename T>
+    void value(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "state is plain data");
+        write(&v, sizeof(T));
+    }
+    template<typename T>
+    void array(const T* data, size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "state is plain data");
+        write(data, count * sizeof(T));
+    }
+    // Pads to whole 32-bit words, which StateHistory works in
+    void finish() {
+        while (out.size() & 3) out.push_back(0);
+    }
+
+    size_t size() const { return out.size(); }
+
+private:
+    std::vector<Uint8>& out;
+};
+
+// Reads an image back in the order it was written. Running past the end
+// fills nothing and marks the reader failed.
+class StateReader {
+public:
+    StateReader(const Uint8* data, size_t size) : data(data), size(size) {}
+
+    bool read(void* dst, size_t bytes) {
+        if (bytes > size - pos) {
+            failed = true;
+            return false;
+        }
+        std::memcpy(dst, data + pos, bytes);
+        pos += bytes;
+        return true;
+    }
+    template<typename T>
+    bool value(T& v) { return read(&v, sizeof(T)); }
+    template<typename T>
+    bool array(T* dst, size_t count) { return read(dst, count * sizeof(T)); }
+
+    bool ok() const { return !failed; }
+
+private:
+    const Uint8* data;
+    size_t size;
+    size_t pos = 0;
+    bool failed = false;
+};
+
+// The last N images, newest on top. With delta on, each image is kept as
+// the XOR against the one pushed before it, run-length coded on zero words:
+// whatever didn't change between two snapshots (most of the world, emitters
+// and the stage, and bullets that haven't moved far) costs almost nothing.
+// pop() walks back from the newest image, which is always kept whole, so a
+// delta only ever has to be applied once and no keyframes are needed; the
+// oldest slot is simply overwritten when the ring is full.
+//
+// Slot buffers keep their size, so once every slot has held a busy scene's
+// delta, pushing stops allocating.
+class StateHistory {
+public:
+    explicit StateHistory(size_t slots = 0);
+
+    void resize(size_t slots); // drops everything
+    void setDelta(bool enabled);
+    void clear();
+
+    // image is a StateWriter buffer after finish()
+    void push(Uint32 tick, const std::vector<Uint8>& image);
+    // Newest image into out, removed from the history; false when empty
+    bool pop(std::vector<Uint8>& out, Uint32& tick);
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    size_t slotCount() const { return slots.size(); }
+    // Stored words across every slot, in bytes
+    size_t storedBytes() const;
+
+private:
+    struct Slot {
+        std::vector<Uint32> data;  // size only grows; used words at the front
+        size_t used = 0;
+        Uint32 tick = 0;
+        Uint32 words = 0;          // of the image itself
+        Uint32 previousWords = 0;  // of the one before it, for delta slots
+        bool delta = false;
+    };
+
+    std::vector<Slot> slots;
+    size_t head = 0;   // next slot to write
+    size_t count = 0;
+    bool useDelta = true;
+    // Whole copy of the newest image in delta mode: what the next push is
+    // XORed against and what pop() hands out
+    std::vector<Uint32> newest;
+    std::vector<Uint32> encoded; // scratch for the delta being pushed
+
+    static size_t encodeRuns(const Uint8* image, size_t words, Uint32* prev, size_t total, Uint32* out);
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <vector>
+#include "SpriteBatch.h"
+
+// The printable ASCII range of one font rasterized (white, blended) into a
+// single RGBA32 surface, and where each glyph landed in it. Nothing here
+// needs a renderer, so the asset loader builds it off the main thread.
+struct GlyphAtlas {
+    static constexpr int FIRST_GLYPH = 32;
+    static constexpr int LAST_GLYPH = 126;
+    static constexpr int GLYPH_COUNT = LAST_GLYPH - FIRST_GLYPH + 1;
+
+    struct Glyph {
+        SDL_Rect src = { 0, 0, 0, 0 }; // location in the atlas
+        int offsetX = 0;                // where the glyph cell starts relative to the pen
+        int advance = 0;
+    };
+
+    Glyph glyphs[GLYPH_COUNT];
+    int width = 0;
+    int height = 0;
+    int fontHeight = 0;
+    SDL_Surface* surface = nullptr;     // until it's been turned into a texture
+
+    bool build(TTF_Font* font);
+    void freeSurface();
+};
+
+// Draws text from a glyph atlas instead of going through TTF_Render* every frame.
+// The printable ASCII range of the font is rasterized once (white, blended) into
+// a single texture; each string is laid out once into cached quads which are
+// copied into the sprite batch, tinted through the vertex colors.
+//
+// The cache is a fixed table of slots picked by hash, each with room for
+// MAX_CACHED_CHARS reserved up front. A new string just overwrites its slot,
+// so changing counters re-lay out without touching the heap.
+class TextRenderer {
+public:
+    // Builds the atlas and uploads it here
+    bool init(SDL_Renderer* renderer, TTF_Font* font, SpriteBatch* batch);
+    // With an atlas built and uploaded elsewhere; the texture stays theirs
+    bool init(TTF_Font* font, const GlyphAtlas& glyphAtlas, SDL_Texture* texture, SpriteBatch* batch);
+    void cleanup();
+    // False until init(); drawing before that draws nothing
+    bool ready() const { return atlas != nullptr; }
+
+    void drawText(const char* text, int x, int y, SDL_Color color, Uint8 layer = LAYER_HUD);
+    void measureText(const char* text, int* w, int* h);
+    int lineHeight() const { return fontHeight; }
+
+private:
+    static constexpr int FIRST_GLYPH = GlyphAtlas::FIRST_GLYPH;
+    static constexpr int LAST_GLYPH = GlyphAtlas::LAST_GLYPH;
+    static constexpr int GLYPH_COUNT = GlyphAtlas::GLYPH_COUNT;
+    static constexpr size_t MAX_CACHED_LAYOUTS = 128; // power of two
+    static constexpr size_t MAX_CACHED_CHARS = 79;    // longer strings aren't cached
+
+    using Glyph = GlyphAtlas::Glyph;
+
+    struct TextLayout {
+        Uint64 key = 0;
+        char text[MAX_CACHED_CHARS + 1] = ""; // empty = slot unused
+        std::vector<SDL_Vertex> vertices;     // 4 per glyph, positioned relative to (0, 0)
+        int width = 0;
+        int height = 0;
+    };
+
+    SpriteBatch* batch = nullptr;
+    TTF_Font* font = nullptr;
+    SDL_Texture* atlas = nullptr;
+    bool ownsAtlas = false;
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+    int fontHeight = 0;
+    Glyph glyphs[GLYPH_COUNT];
+
+    TextLayout layouts[MAX_CACHED_LAYOUTS];
+    TextLayout scratchLayout;           // strings too long for a slot
+
+    void setup(TTF_Font* font, const GlyphAtlas& glyphAtlas, SDL_Texture* texture, SpriteBatch* batch);
+    const TextLayout& getLayout(const char* text);
+    void buildLayout(const char* text, TextLayout& layout);
+};
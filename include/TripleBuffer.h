@@ -0,0 +1,39 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+
+// Lock-free mailbox for handing the latest T from one producer thread to one
+// consumer thread. Three slots: the producer fills back() and publish()
+// swaps it with the middle slot; acquire() swaps the middle slot with
+// front() if anything was published since the last acquire. Neither side
+// waits or ever sees a slot the other one is using. The consumer always gets
+// the newest complete value; ones it never picked up are overwritten.
+template<typename T>
+class TripleBuffer {
+public:
+    // Producer side
+    T& back() { return slots[backIndex]; }
+    void publish() {
+        Uint8 previous = middle.exchange(static_cast<Uint8>(backIndex | FRESH), std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    // Consumer side; true if front() is new
+    bool acquire() {
+        // Only the producer can change the middle slot, and only to a fresher one
+        if (!(middle.load(std::memory_order_acquire) & FRESH)) return false;
+        Uint8 previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX_MASK;
+        return true;
+    }
+    const T& front() const { return slots[frontIndex]; }
+
+private:
+    static constexpr Uint8 INDEX_MASK = 3;
+    static constexpr Uint8 FRESH = 4;
+
+    T slots[3];
+    Uint8 backIndex = 0;
+    Uint8 frontIndex = 1;
+    std::atomic<Uint8> middle{ 2 };
+};
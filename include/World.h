@@ -0,0 +1,281 @@
+#pragma once
+#include <SDL.h>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "Allocators.h"
+
+class StateWriter;
+class StateReader;
+
+// Archetype entity-component storage. Every distinct set of component types
+// is an archetype; its entities live in fixed 16 KiB chunks, each chunk
+// holding one packed array per component. Systems walk those arrays
+// linearly through a Query, so thousands of enemies or shots are a few
+// tight loops rather than a pointer chase per object.
+//
+// Chunks come from one pool per World, so a chunk emptied by one archetype
+// (shots, say) is reused by the next one that grows instead of going back
+// to the heap.
+//
+// Components are plain structs (trivially copyable, copied with memcpy).
+// Adding or removing a component moves the entity to another archetype;
+// destroying one swap-removes it, so arrays never have holes. Don't change
+// structure inside a query: use destroyLater() and flushDestroyed().
+
+struct Entity {
+    Uint32 index = 0xFFFFFFFFu;
+    Uint32 generation = 0;
+
+    bool valid() const { return index != 0xFFFFFFFFu; }
+    bool operator==(const Entity& o) const { return index == o.index && generation == o.generation; }
+    bool operator!=(const Entity& o) const { return !(*this == o); }
+};
+
+using ComponentMask = Uint64;
+
+class ComponentRegistry {
+public:
+    static constexpr int MAX_COMPONENTS = 64; // one bit each in ComponentMask
+
+    // Ids are handed out on first use
+    template<typename T>
+    static int id() {
+        static_assert(std::is_trivially_copyable<T>::value, "components must be plain data");
+        static_assert(alignof(T) <= 16, "component arrays are 16-byte aligned");
+        static const int value = registerType(sizeof(T));
+        return value;
+    }
+    static size_t size(int id);
+
+private:
+    static int registerType(size_t size);
+};
+
+template<typename... Ts>
+ComponentMask componentMask() {
+    ComponentMask mask = 0;
+    int ids[] = { ComponentRegistry::id<Ts>()..., 0 };
+    for (size_t i = 0; i < sizeof...(Ts); ++i) mask |= ComponentMask(1) << ids[i];
+    return mask;
+}
+
+class Archetype {
+public:
+    static constexpr size_t CHUNK_BYTES = 16 * 1024;
+
+    struct Chunk {
+        Uint8* data = nullptr;
+        Uint32 count = 0;
+    };
+
+    Archetype(ComponentMask mask, BlockPool& chunkPool);
+    ~Archetype();
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    ComponentMask mask() const { return componentBits; }
+    size_t size() const { return entityCount; }
+    Uint32 capacityPerChunk() const { return chunkCapacity; }
+    // All chunks but the last are full
+    size_t chunkCount() const { return chunks.size(); }
+    Chunk& chunk(size_t i) { return chunks[i]; }
+
+    Entity* entities(const Chunk& c) const { return reinterpret_cast<Entity*>(c.data); }
+    // nullptr if this archetype doesn't have the component
+    void* column(const Chunk& c, int componentId) const {
+        int col = columnOf[componentId];
+        return col < 0 ? nullptr : c.data + offsets[col];
+    }
+    template<typename T>
+    T* array(const Chunk& c) const {
+        return static_cast<T*>(column(c, ComponentRegistry::id<T>()));
+    }
+    const std::vector<int>& componentIds() const { return ids; }
+
+private:
+    friend class World;
+
+    ComponentMask componentBits;
+    std::vector<int> ids;        // ascending
+    std::vector<size_t> offsets; // byte offset of each id's array in a chunk
+    std::vector<size_t> sizes;
+    Sint8 columnOf[ComponentRegistry::MAX_COMPONENTS];
+    Uint32 chunkCapacity = 0;
+
+    BlockPool& pool;
+    std::vector<Chunk> chunks;   // emptied chunks go back to the pool
+    size_t entityCount = 0;
+
+    // Appends a row, returning where it went; component data is left unset
+    void pushRow(Entity e, Uint32& chunkIndex, Uint32& row);
+    // Moves the very last row into the hole; returns the entity that moved
+    // (invalid if the removed row was the last one)
+    Entity swapRemove(Uint32 chunkIndex, Uint32 row);
+};
+
+class World {
+public:
+    World();
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    template<typename... Ts>
+    Entity create(const Ts&... components);
+    void destroy(Entity e);
+    // Safe inside a query; takes effect in flushDestroyed()
+    void destroyLater(Entity e) { pendingDestroy.push_back(e); }
+    void flushDestroyed();
+    // Destroys every entity; archetypes and chunk memory stay for reuse
+    void clear();
+
+    // Every entity and its components into a state image and back. Only the
+    // used rows of each chunk are written. Archetypes are never removed, so
+    // the image refers to them by address and only loads into the World that
+    // wrote it. Not inside a query.
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+    bool alive(Entity e) const {
+        return e.index < records.size() && records[e.index].generation == e.generation && records[e.index].archetype;
+    }
+    size_t size() const { return liveCount; }
+
+    template<typename T>
+    T* get(Entity e);
+    template<typename T>
+    bool has(Entity e) const { return alive(e) && (records[e.index].archetype->mask() & componentMask<T>()); }
+    template<typename T>
+    void add(Entity e, const T& value);
+    template<typename T>
+    void remove(Entity e);
+
+    // Archetypes are only ever appended, so queries can pick up new ones
+    // incrementally
+    size_t archetypeCount() const { return archetypes.size(); }
+    Archetype& archetype(size_t i) { return *archetypes[i]; }
+
+private:
+    struct Record {
+        Archetype* archetype = nullptr;
+        Uint32 chunk = 0;
+        Uint32 row = 0;
+        Uint32 generation = 0;
+    };
+
+    static constexpr size_t CHUNKS_PER_SLAB = 16;
+
+    BlockPool chunkPool;               // outlives the archetypes
+    std::vector<Record> records;       // by entity index
+    std::vector<Uint32> freeIndices;
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::vector<Entity> pendingDestroy;
+    size_t liveCount = 0;
+
+    Archetype& findOrCreate(ComponentMask mask);
+    Entity allocateEntity();
+    void place(Entity e, Archetype& arch);
+    void removeRow(Record& record);
+    void migrate(Entity e, ComponentMask newMask);
+};
+
+// A cached list of the archetypes holding all of Ts. Each call only scans
+// archetypes created since the last one.
+template<typename... Ts>
+class Query {
+public:
+    Query() : mask(componentMask<Ts...>()) {}
+
+    // fn(count, entities, Ts* arrays...) once per non-empty chunk
+    template<typename Fn>
+    void forEachChunk(World& world, Fn&& fn);
+    // fn(entity, Ts&...) for every match, in storage order
+    template<typename Fn>
+    void forEach(World& world, Fn&& fn);
+    size_t count(World& world);
+
+private:
+    ComponentMask mask;
+    std::vector<Archetype*> matches;
+    size_t scanned = 0;
+    const World* cachedWorld = nullptr;
+
+    void refresh(World& world);
+};
+
+template<typename... Ts>
+Entity World::create(const Ts&... components) {
+    Archetype& arch = findOrCreate(componentMask<Ts...>());
+    Entity e = allocateEntity();
+    place(e, arch);
+    const Record& r = records[e.index];
+    Archetype::Chunk& c = arch.chunk(r.chunk);
+    // Expand over the pack: copy each value into its column
+    int dummy[] = { (std::memcpy(arch.array<Ts>(c) + r.row, &components, sizeof(Ts)), 0)..., 0 };
+    (void)dummy;
+    return e;
+}
+
+template<typename T>
+T* World::get(Entity e) {
+    if (!alive(e)) return nullptr;
+    const Record& r = records[e.index];
+    T* column = r.archetype->template array<T>(r.archetype->chunk(r.chunk));
+    return column ? column + r.row : nullptr;
+}
+
+template<typename T>
+void World::add(Entity e, const T& value) {
+    if (!alive(e)) return;
+    if (!has<T>(e)) migrate(e, records[e.index].archetype->mask() | componentMask<T>());
+    *get<T>(e) = value;
+}
+
+template<typename T>
+void World::remove(Entity e) {
+    if (!has<T>(e)) return;
+    migrate(e, records[e.index].archetype->mask() & ~componentMask<T>());
+}
+
+template<typename... Ts>
+void Query<Ts...>::refresh(World& world) {
+    if (cachedWorld != &world) {
+        matches.clear();
+        scanned = 0;
+        cachedWorld = &world;
+    }
+    for (; scanned < world.archetypeCount(); ++scanned) {
+        Archetype& arch = world.archetype(scanned);
+        if ((arch.mask() & mask) == mask) matches.push_back(&arch);
+    }
+}
+
+template<typename... Ts>
+template<typename Fn>
+void Query<Ts...>::forEachChunk(World& world, Fn&& fn) {
+    refresh(world);
+    for (Archetype* arch : matches) {
+        for (size_t i = 0; i < arch->chunkCount(); ++i) {
+            Archetype::Chunk& c = arch->chunk(i);
+            if (c.count > 0) fn(static_cast<size_t>(c.count), arch->entities(c), arch->template array<Ts>(c)...);
+        }
+    }
+}
+
+template<typename... Ts>
+template<typename Fn>
+void Query<Ts...>::forEach(World& world, Fn&& fn) {
+    forEachChunk(world, [&fn](size_t n, Entity* entities, Ts*... arrays) {
+        for (size_t i = 0; i < n; ++i) fn(entities[i], arrays[i]...);
+    });
+}
+
+template<typename... Ts>
+size_t Query<Ts...>::count(World& world) {
+    refresh(world);
+    size_t total = 0;
+    for (Archetype* arch : matches) total += arch->size();
+    return total;
+}
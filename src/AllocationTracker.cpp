@@ -0,0 +1,162 @@
+#include "AllocationTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<Uint64> allocationCount{ 0 };
+std::atomic<Uint64> freeCount{ 0 };
+std::atomic<Uint64> allocatedBytes{ 0 };
+
+#if ENGINE_TRACK_ALLOCATIONS
+
+void countAllocation(size_t bytes) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void countFree() {
+    freeCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+SDL_malloc_func sdlMalloc = nullptr;
+SDL_calloc_func sdlCalloc = nullptr;
+SDL_realloc_func sdlRealloc = nullptr;
+SDL_free_func sdlFree = nullptr;
+
+void* SDLCALL trackedMalloc(size_t size) {
+    countAllocation(size);
+    return sdlMalloc(size);
+}
+
+void* SDLCALL trackedCalloc(size_t count, size_t size) {
+    countAllocation(count * size);
+    return sdlCalloc(count, size);
+}
+
+void* SDLCALL trackedRealloc(void* mem, size_t size) {
+    void* p = sdlRealloc(mem, size);
+    // Shrinking or growing in place isn't a new allocation
+    if (!mem || p != mem) countAllocation(size);
+    if (mem && p != mem && p) countFree();
+    return p;
+}
+
+void SDLCALL trackedFree(void* mem) {
+    if (mem) countFree();
+    sdlFree(mem);
+}
+
+void* allocate(size_t size) {
+    if (size == 0) size = 1;
+    void* p = std::malloc(size);
+    if (p) countAllocation(size);
+    return p;
+}
+
+void* allocateAligned(size_t size, size_t alignment) {
+    if (size == 0) size = 1;
+#ifdef _MSC_VER
+    void* p = _aligned_malloc(size, alignment);
+#else
+    // aligned_alloc wants a size that's a multiple of the alignment
+    void* p = std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+    if (p) countAllocation(size);
+    return p;
+}
+
+void release(void* p) {
+    if (!p) return;
+    countFree();
+    std::free(p);
+}
+
+void releaseAligned(void* p) {
+    if (!p) return;
+    countFree();
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+#endif
+
+}
+
+void AllocationTracker::installSdlHooks() {
+#if ENGINE_TRACK_ALLOCATIONS
+    if (sdlMalloc) return;
+    SDL_GetMemoryFunctions(&sdlMalloc, &sdlCalloc, &sdlRealloc, &sdlFree);
+    if (SDL_SetMemoryFunctions(trackedMalloc, trackedCalloc, trackedRealloc, trackedFree) != 0) {
+        SDL_Log("Couldn't hook SDL's allocator: %s", SDL_GetError());
+    }
+#endif
+}
+
+AllocationCounts AllocationTracker::totals() {
+    AllocationCounts c;
+    c.allocations = allocationCount.load(std::memory_order_relaxed);
+    c.frees = freeCount.load(std::memory_order_relaxed);
+    c.bytes = allocatedBytes.load(std::memory_order_relaxed);
+    return c;
+}
+
+#if ENGINE_TRACK_ALLOCATIONS
+
+// Replacing these in one translation unit replaces them for the whole
+// program, the standard library included
+
+void* operator new(size_t size) {
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* p = allocateAligned(size, static_cast<size_t>(alignment));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    void* p = allocateAligned(size, static_cast<size_t>(alignment));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(p); }
+
+#endif
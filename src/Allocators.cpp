@@ -0,0 +1,100 @@
+#include "Allocators.h"
+
+namespace {
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+FrameArena::FrameArena(size_t bytes) {
+    blockSize = alignUp(bytes, 4096);
+    block = static_cast<Uint8*>(SDL_SIMDAlloc(blockSize));
+    if (!block) blockSize = 0;
+}
+
+FrameArena::~FrameArena() {
+    for (void* p : overflowBlocks) SDL_SIMDFree(p);
+    SDL_SIMDFree(block);
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    // The block itself is SIMD-aligned, so aligning the offset is enough
+    size_t current = offset.load(std::memory_order_relaxed);
+    for (;;) {
+        size_t start = alignUp(current, alignment);
+        size_t end = start + bytes;
+        if (end > blockSize) break;
+        if (offset.compare_exchange_weak(current, end, std::memory_order_relaxed)) return block + start;
+    }
+
+    // Doesn't fit: the heap covers this tick, reset() grows the block
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    void* p = SDL_SIMDAlloc(bytes > 0 ? bytes : 1);
+    if (p) {
+        overflowBlocks.push_back(p);
+        overflowBytes += alignUp(bytes, alignment);
+    }
+    return p;
+}
+
+void FrameArena::reset() {
+    size_t tickUsed = offset.load(std::memory_order_relaxed) + overflowBytes;
+    lastUsed = tickUsed;
+    if (tickUsed > peak) peak = tickUsed;
+
+    if (!overflowBlocks.empty()) {
+        for (void* p : overflowBlocks) SDL_SIMDFree(p);
+        overflowBlocks.clear();
+        overflowCount++;
+
+        // Some headroom so a slowly rising peak doesn't regrow every tick
+        size_t grown = alignUp(tickUsed + tickUsed / 4, 4096);
+        SDL_SIMDFree(block);
+        block = static_cast<Uint8*>(SDL_SIMDAlloc(grown));
+        blockSize = block ? grown : 0;
+        SDL_Log("Frame arena grown to %u KiB", static_cast<unsigned>(blockSize / 1024));
+    }
+    offset.store(0, std::memory_order_relaxed);
+    overflowBytes = 0;
+}
+
+BlockPool::BlockPool(size_t blockBytes, size_t blocksPerSlab)
+    : blockBytes(alignUp(blockBytes < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockBytes, 16)),
+      blocksPerSlab(blocksPerSlab > 0 ? blocksPerSlab : 1)
+{
+}
+
+BlockPool::~BlockPool() {
+    for (void* slab : slabs) SDL_SIMDFree(slab);
+}
+
+void BlockPool::addSlab() {
+    Uint8* slab = static_cast<Uint8*>(SDL_SIMDAlloc(blockBytes * blocksPerSlab));
+    if (!slab) return;
+    slabs.push_back(slab);
+    // Thread back to front so blocks come out in address order
+    for (size_t i = blocksPerSlab; i > 0; --i) {
+        FreeBlock* b = reinterpret_cast<FreeBlock*>(slab + (i - 1) * blockBytes);
+        b->next = freeList;
+        freeList = b;
+    }
+}
+
+void* BlockPool::acquire() {
+    if (!freeList) addSlab();
+    if (!freeList) return nullptr;
+    FreeBlock* b = freeList;
+    freeList = b->next;
+    inUse++;
+    return b;
+}
+
+void BlockPool::release(void* block) {
+    if (!block) return;
+    FreeBlock* b = static_cast<FreeBlock*>(block);
+    b->next = freeList;
+    freeList = b;
+    inUse--;
+}
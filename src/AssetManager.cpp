@@ -0,0 +1,325 @@
+#include "AssetManager.h"
+#include <SDL_image.h>
+#include <string>
+#include <utility>
+#include "FramePacer.h"
+#include "Profiler.h"
+
+namespace {
+
+const Sprite NO_SPRITE;
+const GlyphAtlas NO_GLYPHS;
+
+double millisecondsSince(Uint64 start) {
+    return FramePacer::toSeconds(FramePacer::now() - start) * 1000.0;
+}
+
+}
+
+AssetManager::Handle::Handle(AssetManager* owner, Uint32 index) : owner(owner), index(index) {
+    owner->retain(index);
+}
+
+AssetManager::Handle::Handle(const Handle& other) : owner(other.owner), index(other.index) {
+    if (owner) owner->retain(index);
+}
+
+AssetManager::Handle::Handle(Handle&& other) noexcept : owner(other.owner), index(other.index) {
+    other.owner = nullptr;
+}
+
+AssetManager::Handle& AssetManager::Handle::operator=(Handle other) noexcept {
+    std::swap(owner, other.owner);
+    std::swap(index, other.index);
+    return *this;
+}
+
+void AssetManager::Handle::reset() {
+    if (owner) owner->release(index);
+    owner = nullptr;
+}
+
+void AssetManager::start(SDL_Renderer* renderer, RenderBackend& backend, int loaderCount) {
+    stop();
+    this->renderer = renderer;
+    this->backend = &backend;
+    stopping = false;
+    if (loaderCount < 1) loaderCount = 1;
+    for (int i = 0; i < loaderCount; ++i) {
+        loaders.emplace_back(&AssetManager::loaderLoop, this);
+    }
+}
+
+void AssetManager::stop() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    queued.notify_all();
+    for (std::thread& t : loaders) t.join();
+    loaders.clear();
+
+    // Whatever was still queued is dropped with the rest
+    for (Uint32 i = 0; i < assets.size(); ++i) {
+        if (assets[i]) freeAsset(i);
+    }
+    assets.clear();
+    freeSlots.clear();
+    byKey.clear();
+    decodeQueue.clear();
+    uploadQueue.clear();
+    decoding = 0;
+    decodeMs = 0.0;
+    uploadMs = 0.0;
+    worstFrameUploadMs = 0.0;
+    uploadFrames = 0;
+}
+
+AssetManager::Handle AssetManager::loadImage(const char* path) {
+    return request(Kind::IMAGE, path, 0);
+}
+
+AssetManager::Handle AssetManager::loadFont(const char* path, int pointSize) {
+    return request(Kind::FONT, path, pointSize);
+}
+
+AssetManager::Handle AssetManager::request(Kind kind, const char* path, int pointSize) {
+    std::string key = path;
+    if (kind == Kind::FONT) key += "@" + std::to_string(pointSize);
+
+    auto it = byKey.find(key);
+    if (it != byKey.end()) return Handle(this, it->second);
+
+    std::unique_ptr<Asset> asset(new Asset());
+    asset->kind = kind;
+    asset->key = key;
+    asset->path = path;
+    asset->pointSize = pointSize;
+
+    Uint32 index;
+    {
+        // The loaders look slots up while this may be growing the table
+        std::lock_guard<std::mutex> guard(lock);
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+            assets[index] = std::move(asset);
+        } else {
+            index = static_cast<Uint32>(assets.size());
+            assets.push_back(std::move(asset));
+        }
+        decodeQueue.push_back(index);
+    }
+    byKey[key] = index;
+    queued.notify_one();
+    return Handle(this, index);
+}
+
+void AssetManager::loaderLoop() {
+    for (;;) {
+        Asset* asset;
+        Uint32 index;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            queued.wait(guard, [this] { return !decodeQueue.empty() || stopping; });
+            if (stopping) return;
+            index = decodeQueue.front();
+            decodeQueue.pop_front();
+            asset = assets[index].get();
+            decoding++;
+        }
+
+        Uint64 start = FramePacer::now();
+        decode(*asset);
+        asset->decodeMs = millisecondsSince(start);
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            decoding--;
+            decodeMs += asset->decodeMs;
+            uploadQueue.push_back(index);
+        }
+        decoded.notify_all();
+    }
+}
+
+void AssetManager::decode(Asset& asset) {
+    PROFILE_SCOPE("decodeAsset");
+    if (asset.kind == Kind::IMAGE) {
+        SDL_Surface* surface = IMG_Load(asset.path.c_str());
+        if (!surface) {
+            asset.error = IMG_GetError();
+            return;
+        }
+        // The CPU backend keeps RGBA32 copies; converting here saves it doing
+        // so on the main thread. Opaque images stay as they are so they don't
+        // pick up blending.
+        if (SDL_ISPIXELFORMAT_ALPHA(surface->format->format) && surface->format->format != SDL_PIXELFORMAT_RGBA32) {
+            SDL_Surface* rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+            if (rgba) {
+                SDL_FreeSurface(surface);
+                surface = rgba;
+            }
+        }
+        asset.surface = surface;
+        asset.decoded = true;
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(fontLock);
+    asset.font = TTF_OpenFont(asset.path.c_str(), asset.pointSize);
+    if (!asset.font) {
+        asset.error = TTF_GetError();
+        return;
+    }
+    if (!asset.glyphs.build(asset.font)) {
+        asset.error = "could not build the glyph atlas";
+        return;
+    }
+    asset.decoded = true;
+}
+
+void AssetManager::update(double budgetMs) {
+    PROFILE_SCOPE("uploadAssets");
+    Uint64 start = FramePacer::now();
+    bool uploaded = false;
+    for (;;) {
+        Uint32 index;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (uploadQueue.empty()) break;
+            index = uploadQueue.front();
+            uploadQueue.pop_front();
+        }
+        upload(index);
+        uploaded = true;
+        if (millisecondsSince(start) >= budgetMs) break;
+    }
+
+    if (uploaded) {
+        double ms = millisecondsSince(start);
+        uploadMs += ms;
+        if (ms > worstFrameUploadMs) worstFrameUploadMs = ms;
+        uploadFrames++;
+    }
+}
+
+void AssetManager::upload(Uint32 index) {
+    Asset& asset = *assets[index];
+    // Every handle went while it was loading
+    if (asset.refs == 0) {
+        freeAsset(index);
+        return;
+    }
+
+    if (!asset.decoded) {
+        SDL_Log("Failed to load %s: %s", asset.path.c_str(), asset.error.c_str());
+        asset.state = AssetState::FAILED;
+        return;
+    }
+
+    SDL_Surface* surface = asset.kind == Kind::IMAGE ? asset.surface : asset.glyphs.surface;
+    asset.texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (asset.texture) backend->registerTexture(asset.texture, surface);
+    if (asset.kind == Kind::IMAGE) {
+        SDL_FreeSurface(asset.surface);
+        asset.surface = nullptr;
+    } else {
+        asset.glyphs.freeSurface();
+    }
+    if (!asset.texture) {
+        SDL_Log("Failed to upload %s: %s", asset.path.c_str(), SDL_GetError());
+        asset.state = AssetState::FAILED;
+        return;
+    }
+    asset.sprite = Sprite::fromTexture(asset.texture);
+    asset.state = AssetState::READY;
+}
+
+void AssetManager::finish() {
+    if (loaders.empty()) return;
+    for (;;) {
+        update(1.0e9);
+        std::unique_lock<std::mutex> guard(lock);
+        if (decodeQueue.empty() && decoding == 0 && uploadQueue.empty()) return;
+        decoded.wait(guard, [this] { return !uploadQueue.empty(); });
+    }
+}
+
+void AssetManager::retain(Uint32 index) {
+    assets[index]->refs++;
+}
+
+void AssetManager::release(Uint32 index) {
+    // stop() may have freed it already
+    if (index >= assets.size() || !assets[index]) return;
+    Asset& asset = *assets[index];
+    if (--asset.refs > 0) return;
+    // Still with a loader or waiting to upload: upload() frees it instead
+    if (asset.state == AssetState::LOADING) return;
+    freeAsset(index);
+}
+
+void AssetManager::freeAsset(Uint32 index) {
+    std::unique_ptr<Asset> asset;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        asset = std::move(assets[index]);
+    }
+    if (asset->texture) backend->destroyTexture(asset->texture);
+    if (asset->surface) SDL_FreeSurface(asset->surface);
+    asset->glyphs.freeSurface();
+    if (asset->font) TTF_CloseFont(asset->font);
+
+    auto it = byKey.find(asset->key);
+    if (it != byKey.end() && it->second == index) byKey.erase(it);
+    freeSlots.push_back(index);
+}
+
+AssetState AssetManager::state(const Handle& handle) const {
+    const Asset* asset = find(handle);
+    return asset ? asset->state : AssetState::FAILED;
+}
+
+AssetManager::Progress AssetManager::progress() const {
+    Progress p;
+    for (const std::unique_ptr<Asset>& asset : assets) {
+        if (!asset || asset->refs == 0) continue;
+        p.requested++;
+        if (asset->state == AssetState::READY) p.ready++;
+        if (asset->state == AssetState::FAILED) p.failed++;
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        p.decodeMs = decodeMs;
+    }
+    p.uploadMs = uploadMs;
+    p.worstFrameUploadMs = worstFrameUploadMs;
+    p.uploadFrames = uploadFrames;
+    return p;
+}
+
+const AssetManager::Asset* AssetManager::find(const Handle& handle) const {
+    if (handle.owner != this || handle.index >= assets.size()) return nullptr;
+    return assets[handle.index].get();
+}
+
+const Sprite& AssetManager::sprite(const Handle& handle) const {
+    const Asset* asset = find(handle);
+    return asset && asset->state == AssetState::READY ? asset->sprite : NO_SPRITE;
+}
+
+SDL_Texture* AssetManager::texture(const Handle& handle) const {
+    const Asset* asset = find(handle);
+    return asset && asset->state == AssetState::READY ? asset->texture : nullptr;
+}
+
+TTF_Font* AssetManager::font(const Handle& handle) const {
+    const Asset* asset = find(handle);
+    return asset && asset->state == AssetState::READY ? asset->font : nullptr;
+}
+
+const GlyphAtlas& AssetManager::glyphs(const Handle& handle) const {
+    const Asset* asset = find(handle);
+    return asset && asset->state == AssetState::READY ? asset->glyphs : NO_GLYPHS;
+}
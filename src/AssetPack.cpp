@@ -0,0 +1,188 @@
+#include "AssetPack.h"
+#include <iostream>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetPack::~AssetPack() {
+    destroyTextures();
+    close();
+}
+
+bool AssetPack::open(const char* path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<const Uint8*>(view);
+    dataSize = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (view == MAP_FAILED) return false;
+    data = static_cast<const Uint8*>(view);
+    dataSize = static_cast<size_t>(st.st_size);
+#endif
+
+    header = reinterpret_cast<const pack::PackHeader*>(data);
+    if (!validate()) {
+        std::cerr << "Asset pack " << path << " is invalid or from another cooker version\n";
+        close();
+        return false;
+    }
+    pages = reinterpret_cast<const pack::PackPage*>(data + header->pageTableOffset);
+    sprites = reinterpret_cast<const pack::PackSprite*>(data + header->spriteTableOffset);
+    return true;
+}
+
+void AssetPack::close() {
+    if (!data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    munmap(const_cast<Uint8*>(data), dataSize);
+#endif
+    data = nullptr;
+    dataSize = 0;
+    header = nullptr;
+    pages = nullptr;
+    sprites = nullptr;
+}
+
+bool AssetPack::validate() const {
+    if (dataSize < sizeof(pack::PackHeader)) return false;
+    if (header->magic != pack::MAGIC || header->version != pack::VERSION) return false;
+
+    Uint64 pageEnd = static_cast<Uint64>(header->pageTableOffset) + Uint64(header->pageCount) * sizeof(pack::PackPage);
+    Uint64 spriteEnd = static_cast<Uint64>(header->spriteTableOffset) + Uint64(header->spriteCount) * sizeof(pack::PackSprite);
+    if (pageEnd > dataSize || spriteEnd > dataSize) return false;
+
+    const pack::PackPage* p = reinterpret_cast<const pack::PackPage*>(data + header->pageTableOffset);
+    for (Uint32 i = 0; i < header->pageCount; ++i) {
+        Uint64 end = p[i].pixelOffset + Uint64(p[i].pitch) * p[i].height;
+        if (end > dataSize || p[i].pitch < p[i].width * 4) return false;
+    }
+    return true;
+}
+
+bool AssetPack::createTextures(SDL_Renderer* renderer, RenderBackend& backend) {
+    destroyTextures();
+    if (!header) return false;
+    this->backend = &backend;
+
+    // Pixels are premultiplied, which needs a custom blend mode. The software
+    // renderer doesn't do custom modes; there we un-premultiply once on upload.
+    SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    pageBlend = premultiplied;
+
+    for (Uint32 i = 0; i < header->pageCount; ++i) {
+        const pack::PackPage& page = pages[i];
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                                 static_cast<int>(page.width), static_cast<int>(page.height));
+        if (!texture) {
+            std::cerr << "Failed to create pack page texture! SDL_Error: " << SDL_GetError() << "\n";
+            destroyTextures();
+            return false;
+        }
+        pageTextures.push_back(texture);
+
+        const Uint8* pixels = data + page.pixelOffset;
+        backend.registerPixels(texture, pixels, static_cast<int>(page.width), static_cast<int>(page.height),
+                               static_cast<int>(page.pitch), true);
+        if (pageBlend == premultiplied && SDL_SetTextureBlendMode(texture, premultiplied) != 0) {
+            pageBlend = SDL_BLENDMODE_BLEND;
+        }
+
+        if (pageBlend == premultiplied) {
+            SDL_UpdateTexture(texture, NULL, pixels, static_cast<int>(page.pitch));
+        } else {
+            std::vector<Uint8> straight(static_cast<size_t>(page.width) * page.height * 4);
+            for (Uint32 y = 0; y < page.height; ++y) {
+                const Uint8* src = pixels + y * page.pitch;
+                Uint8* dst = &straight[static_cast<size_t>(y) * page.width * 4];
+                for (Uint32 x = 0; x < page.width * 4; x += 4) {
+                    Uint8 a = src[x + 3];
+                    for (int c = 0; c < 3; ++c) {
+                        dst[x + c] = a ? static_cast<Uint8>((src[x + c] * 255 + a / 2) / a) : 0;
+                    }
+                    dst[x + 3] = a;
+                }
+            }
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            SDL_UpdateTexture(texture, NULL, straight.data(), static_cast<int>(page.width * 4));
+        }
+    }
+    return true;
+}
+
+void AssetPack::destroyTextures() {
+    for (SDL_Texture* texture : pageTextures) {
+        if (texture) backend->destroyTexture(texture);
+    }
+    pageTextures.clear();
+}
+
+bool AssetPack::findSprite(const char* name, Sprite& out) const {
+    if (!header) return false;
+
+    // The cooker writes the table sorted by name
+    size_t lo = 0;
+    size_t hi = header->spriteCount;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = std::strncmp(sprites[mid].name, name, pack::NAME_LENGTH);
+        if (cmp == 0) {
+            const pack::PackSprite& s = sprites[mid];
+            if (s.page >= pageTextures.size()) return false;
+            out.texture = pageTextures[s.page];
+            out.uv = { s.u0, s.v0, s.u1 - s.u0, s.v1 - s.v0 };
+            out.width = s.w;
+            out.height = s.h;
+            out.blend = pageBlend;
+            return true;
+        }
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return false;
+}
@@ -0,0 +1,122 @@
+#include "BenchScenario.h"
+#include <cmath>
+#include "EntitySystems.h"
+
+const BenchScenario& BenchScenario::standard() {
+    static const BenchScenario scenario(1, {
+        // start  buttons                        ring  every  speed
+        { 0,     0,                              32,   10,    90.0f  },
+        { 120,   BUTTON_LEFT,                    128,  6,     110.0f },
+        { 180,   BUTTON_RIGHT,                   128,  6,     110.0f },
+        { 240,   BUTTON_LEFT | BUTTON_UP,        128,  6,     110.0f },
+        { 300,   BUTTON_RIGHT | BUTTON_DOWN,     128,  6,     110.0f },
+        { 360,   BUTTON_FOCUS | BUTTON_LEFT,     512,  4,     70.0f  },
+        { 600,   BUTTON_FOCUS | BUTTON_RIGHT,    512,  4,     70.0f  },
+        { 840,   BUTTON_FOCUS,                   512,  4,     70.0f  },
+    });
+    return scenario;
+}
+
+const BenchScenario& BenchScenario::boss() {
+    static const BenchScenario scenario(2, {
+        // start  buttons                        ring  every  speed   pattern    emitters
+        { 0,     0,                              0,    1,     0.0f,   "spiral",  64  },
+        { 120,   BUTTON_FOCUS | BUTTON_LEFT,     0,    1,     0.0f,   "fans",    96  },
+        { 300,   BUTTON_FOCUS | BUTTON_RIGHT,    0,    1,     0.0f,   "pulse",   128 },
+        { 480,   BUTTON_FOCUS,                   64,   20,    80.0f,  "sweeper", 160 },
+        { 720,   BUTTON_FOCUS | BUTTON_UP,       0,    1,     0.0f,   "spiral",  256 },
+    });
+    return scenario;
+}
+
+const BenchScenario& BenchScenario::swarm() {
+    static const BenchScenario scenario(3, {
+        // start  buttons                           ring  every  speed  pattern   emitters  enemies
+        { 0,     BUTTON_SHOOT,                      0,    1,     0.0f,  nullptr,  0,        512  },
+        { 240,   BUTTON_SHOOT | BUTTON_LEFT,        0,    1,     0.0f,  nullptr,  0,        1024 },
+        { 480,   BUTTON_SHOOT | BUTTON_RIGHT,       32,   30,    60.0f, nullptr,  0,        2048 },
+        { 720,   BUTTON_SHOOT | BUTTON_FOCUS,       0,    1,     0.0f,  "fans",   32,       4096 },
+    });
+    return scenario;
+}
+
+const BenchScenario& BenchScenario::lasers() {
+    static const BenchScenario scenario(4, {
+        // start  buttons                        ring  every  speed   pattern    emitters
+        { 0,     BUTTON_FOCUS,                   0,    1,     0.0f,   "curtain", 16 },
+        { 240,   BUTTON_FOCUS | BUTTON_LEFT,     0,    1,     0.0f,   "curtain", 16 },
+        { 480,   BUTTON_FOCUS | BUTTON_RIGHT,    48,   30,    80.0f,  "curtain", 8  },
+    });
+    return scenario;
+}
+
+const BenchScenario* BenchScenario::find(Uint32 id) {
+    if (id == standard().id()) return &standard();
+    if (id == boss().id()) return &boss();
+    if (id == swarm().id()) return &swarm();
+    if (id == lasers().id()) return &lasers();
+    return nullptr;
+}
+
+const BenchScenario::Phase& BenchScenario::phaseAt(int tick) const {
+    size_t i = 0;
+    while (i + 1 < phases.size() && phases[i + 1].startTick <= tick) ++i;
+    return phases[i];
+}
+
+Uint16 BenchScenario::buttonsAt(int tick) const {
+    return phases.empty() ? 0 : phaseAt(tick).buttons;
+}
+
+void BenchScenario::spawnAt(int tick, BulletPool& bullets, EmitterPool& emitters,
+                            const PatternLibrary& patterns, World& world, const Playfield& bounds) const {
+    if (phases.empty()) return;
+    const Phase& phase = phaseAt(tick);
+
+    if (tick == phase.startTick && phase.enemies > 0) {
+        // Packed rows across the top half, alternate ones drifting each way
+        const int columns = 32;
+        float spacing = bounds.width() / (columns + 1);
+        for (int i = 0; i < phase.enemies; ++i) {
+            int row = (i / columns) % 24;
+            float x = bounds.left + spacing * (i % columns + 1);
+            float y = bounds.top + 12.0f + row * 9.0f;
+            float vx = (row & 1) ? 14.0f : -14.0f;
+            EntitySystems::spawnEnemy(world, x, y, vx, 10.0f, 3);
+        }
+    }
+
+    if (tick == phase.startTick && phase.pattern && phase.emitters > 0) {
+        int program = patterns.find(phase.pattern);
+        float spacing = bounds.width() / (phase.emitters + 1);
+        for (int i = 0; i < phase.emitters && program >= 0; ++i) {
+            // Stagger the rows a little so they don't all fire from one line
+            float y = bounds.top + 30.0f + (i % 4) * 12.0f;
+            if (!emitters.spawn(patterns, program, bounds.left + spacing * (i + 1), y)) break;
+        }
+    }
+
+    if (phase.ringBullets <= 0 || (tick - phase.startTick) % phase.ringInterval != 0) return;
+
+    // Rings from the top centre, rotated a little each time so they spiral
+    const float twoPi = 6.28318530718f;
+    const float cx = (bounds.left + bounds.right) * 0.5f;
+    const float cy = bounds.top + bounds.height() * 0.2f;
+    const float offset = tick * 0.07f;
+
+    for (int i = 0; i < phase.ringBullets; ++i) {
+        float angle = offset + twoPi * i / phase.ringBullets;
+        BulletSpawn b;
+        b.x = cx;
+        b.y = cy;
+        b.vx = std::cos(angle) * phase.ringSpeed;
+        b.vy = std::sin(angle) * phase.ringSpeed;
+        b.ax = 0.0f;
+        b.ay = 0.0f;
+        b.angularVel = (i & 1) ? 0.3f : -0.3f;
+        b.lifetime = 8.0f;
+        b.radius = static_cast<float>(2 + (i % 4) * 2);
+        b.color = (i & 1) ? 0xFF6060FFu : 0x60A0FFFFu;
+        if (!bullets.spawn(b)) return; // pool full
+    }
+}
@@ -0,0 +1,496 @@
+#include "BulletPattern.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "JobSystem.h"
+#include "StateSnapshot.h"
+
+namespace {
+
+constexpr float DEG_TO_RAD = 0.01745329252f;
+
+struct OpInfo {
+    const char* name;
+    PatternOp op;
+    bool writesRegister;  // first argument is the destination register
+    int minArgs;
+    int maxArgs;          // operands after the destination
+};
+
+const OpInfo OPS[] = {
+    { "halt",   PatternOp::HALT,   false, 0, 0 },
+    { "set",    PatternOp::SET,    true,  1, 1 },
+    { "add",    PatternOp::ADD,    true,  2, 2 },
+    { "mul",    PatternOp::MUL,    true,  2, 2 },
+    { "sin",    PatternOp::SIN,    true,  1, 1 },
+    { "ramp",   PatternOp::RAMP,   true,  2, 2 },
+    { "wait",   PatternOp::WAIT,   false, 1, 1 },
+    { "loop",   PatternOp::LOOP,   false, 1, 1 },
+    { "end",    PatternOp::END,    false, 0, 0 },
+    { "ring",   PatternOp::RING,   false, 2, 3 },
+    { "fan",    PatternOp::FAN,    false, 3, 3 },
+    { "shot",   PatternOp::SHOT,   false, 2, 2 },
+    { "radius", PatternOp::RADIUS, false, 1, 1 },
+    { "color",  PatternOp::COLOR,  false, 1, 1 },
+    { "life",   PatternOp::LIFE,   false, 1, 1 },
+    { "accel",  PatternOp::ACCEL,  false, 1, 1 },
+    { "curve",  PatternOp::CURVE,  false, 1, 1 },
+    { "move",   PatternOp::MOVE,   false, 2, 2 },
+    { "laser",  PatternOp::LASER,  false, 3, 3 },
+};
+
+const OpInfo* findOp(const std::string& name) {
+    for (const OpInfo& info : OPS) {
+        if (name == info.name) return &info;
+    }
+    return nullptr;
+}
+
+bool parseRegister(const std::string& token, Uint8& reg) {
+    if (token.size() < 2 || token[0] != 'r') return false;
+    char* end = nullptr;
+    long n = std::strtol(token.c_str() + 1, &end, 10);
+    if (*end != '\0' || n < 0 || n >= EmitterPool::REGISTERS) return false;
+    reg = static_cast<Uint8>(n);
+    return true;
+}
+
+bool parseNumber(const std::string& token, float& value) {
+    char* end = nullptr;
+    value = std::strtof(token.c_str(), &end);
+    return end != token.c_str() && *end == '\0';
+}
+
+}
+
+bool PatternLibrary::compile(const char* source, std::string& error) {
+    std::vector<Program> newPrograms;
+    std::vector<PatternInstruction> newCode;
+    std::vector<Uint32> openLoops;
+    const Uint32 base = static_cast<Uint32>(instructions.size());
+
+    auto closeProgram = [&](int lineNo) {
+        if (newPrograms.empty()) return true;
+        if (!openLoops.empty()) {
+            error = "line " + std::to_string(lineNo) + ": pattern '" + newPrograms.back().name + "' has an unclosed loop";
+            return false;
+        }
+        newCode.push_back({ PatternOp::HALT, 0, 0, 0, { 0.0f, 0.0f, 0.0f } });
+        return true;
+    };
+
+    std::istringstream in(source);
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        lineNo++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+
+        std::istringstream words(line);
+        std::vector<std::string> tokens;
+        std::string word;
+        while (words >> word) tokens.push_back(word);
+        if (tokens.empty()) continue;
+
+        auto fail = [&](const std::string& what) {
+            error = "line " + std::to_string(lineNo) + ": " + what;
+            return false;
+        };
+
+        if (tokens[0] == "pattern") {
+            if (tokens.size() != 2) return fail("expected 'pattern <name>'");
+            if (!closeProgram(lineNo)) return false;
+            if (find(tokens[1].c_str()) >= 0) return fail("pattern '" + tokens[1] + "' is already defined");
+            for (const Program& p : newPrograms) {
+                if (p.name == tokens[1]) return fail("pattern '" + tokens[1] + "' is defined twice");
+            }
+            newPrograms.push_back({ tokens[1], base + static_cast<Uint32>(newCode.size()) });
+            continue;
+        }
+        if (newPrograms.empty()) return fail("instruction outside a pattern");
+
+        const OpInfo* info = findOp(tokens[0]);
+        if (!info) return fail("unknown instruction '" + tokens[0] + "'");
+
+        PatternInstruction inst = { info->op, 0, 0, 0, { 0.0f, 0.0f, 0.0f } };
+        size_t arg = 1;
+        if (info->writesRegister) {
+            if (tokens.size() < 2 || !parseRegister(tokens[1], inst.dst)) {
+                return fail("'" + tokens[0] + "' needs a destination register");
+            }
+            arg = 2;
+        }
+        int argCount = static_cast<int>(tokens.size() - arg);
+        if (argCount < info->minArgs || argCount > info->maxArgs) {
+            return fail("wrong number of operands for '" + tokens[0] + "'");
+        }
+        for (int i = 0; i < argCount; ++i) {
+            const std::string& t = tokens[arg + i];
+            Uint8 reg = 0;
+            if (info->op == PatternOp::COLOR) {
+                char* end = nullptr;
+                Uint32 rgba = static_cast<Uint32>(std::strtoul(t.c_str(), &end, 16));
+                if (t.size() != 8 || *end != '\0') return fail("color must be RRGGBBAA hex");
+                std::memcpy(&inst.operand[0], &rgba, sizeof(rgba));
+            } else if (parseRegister(t, reg)) {
+                inst.operand[i] = reg;
+                inst.regMask |= static_cast<Uint8>(1u << i);
+            } else if (!parseNumber(t, inst.operand[i])) {
+                return fail("bad operand '" + t + "'");
+            }
+        }
+
+        if (info->op == PatternOp::LOOP) {
+            if (openLoops.size() >= EmitterPool::MAX_LOOP_DEPTH) return fail("loops nested too deep");
+            openLoops.push_back(static_cast<Uint32>(newCode.size()));
+        } else if (info->op == PatternOp::END) {
+            if (openLoops.empty()) return fail("'end' without 'loop'");
+            openLoops.pop_back();
+        }
+        newCode.push_back(inst);
+    }
+    if (!closeProgram(lineNo)) return false;
+
+    programs.insert(programs.end(), newPrograms.begin(), newPrograms.end());
+    instructions.insert(instructions.end(), newCode.begin(), newCode.end());
+    return true;
+}
+
+bool PatternLibrary::loadFile(const char* path, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = std::string("could not open ") + path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return compile(text.str().c_str(), error);
+}
+
+int PatternLibrary::find(const char* name) const {
+    for (size_t i = 0; i < programs.size(); ++i) {
+        if (programs[i].name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+const char* PatternLibrary::builtinSource() {
+    return R"(
+# Rotating ring; two emitters with opposite spin make a lattice
+pattern spiral
+  color FF6080FF
+  radius 4
+  life 8
+  set r0 0
+  loop 400
+    ring 6 110 r0
+    add r0 r0 11
+    wait 3
+  end
+
+# Aimed fans that tighten over a few seconds
+pattern fans
+  color 60C0FFFF
+  radius 3
+  life 6
+  set r1 90
+  ramp r1 20 240
+  loop 60
+    fan 7 r1 160
+    wait 8
+  end
+
+# Slow dense rings whose speed swings back and forth
+pattern pulse
+  color FFD040FF
+  radius 6
+  life 8
+  curve 15
+  set r2 0
+  loop 120
+    sin r3 r2
+    mul r3 r3 40
+    add r3 r3 90
+    ring 24 r3 r2
+    add r2 r2 9
+    wait 10
+  end
+
+# Sweeping emitter spraying single shots downward
+pattern sweeper
+  color A0FF80FF
+  radius 2
+  life 6
+  accel 30
+  move 40 0
+  set r4 60
+  loop 3
+    loop 60
+      shot 140 r4
+      add r4 r4 1
+      wait 2
+    end
+    move -40 0
+    loop 60
+      shot 140 r4
+      add r4 r4 -1
+      wait 2
+    end
+    move 40 0
+  end
+
+# Pairs of lasers bending away from each other, swaying across the field
+pattern curtain
+  color FF60E0FF
+  radius 5
+  life 3
+  set r5 0
+  loop 24
+    sin r6 r5
+    mul r6 r6 40
+    add r6 r6 90
+    curve 45
+    laser 150 r6 96
+    curve -45
+    laser 150 r6 96
+    add r5 r5 30
+    wait 20
+  end
+)";
+}
+
+EmitterPool::EmitterPool(size_t capacity, size_t maxSpawnsPerTick) : capacity(capacity) {
+    emitters.reserve(capacity);
+    const size_t chunks = (capacity + JOB_CHUNK - 1) / JOB_CHUNK;
+    chunkSpawns.assign(chunks, SpawnBuffer<BulletSpawn>(maxSpawnsPerTick));
+    chunkLasers.assign(chunks, SpawnBuffer<LaserSpawn>(maxSpawnsPerTick));
+}
+
+bool EmitterPool::spawn(const PatternLibrary& library, int program, float x, float y) {
+    if (program < 0 || static_cast<size_t>(program) >= library.programCount()) return false;
+    if (emitters.size() >= capacity) return false;
+
+    Emitter e;
+    std::memset(&e, 0, sizeof(e));
+    e.x = x;
+    e.y = y;
+    e.radius = 4.0f;
+    e.life = 6.0f;
+    e.color = 0xFFFFFFFFu;
+    e.pc = library.entryPoint(program);
+    emitters.push_back(e);
+    return true;
+}
+
+void EmitterPool::update(const PatternLibrary& library, float dt, float targetX, float targetY, JobSystem& jobs) {
+    const PatternInstruction* code = library.code();
+    jobs.parallelFor(emitters.size(), JOB_CHUNK, [&](size_t begin, size_t end) {
+        ChunkOutput out = { chunkSpawns[begin / JOB_CHUNK], chunkLasers[begin / JOB_CHUNK] };
+        for (size_t i = begin; i < end; ++i) {
+            tick(emitters[i], code, dt, targetX, targetY, out);
+        }
+    });
+}
+
+size_t EmitterPool::flushSpawns(BulletPool& bullets, LaserPool& lasers) {
+    const size_t chunks = (emitters.size() + JOB_CHUNK - 1) / JOB_CHUNK;
+    size_t added = 0;
+    lastDropped = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        SpawnBuffer<BulletSpawn>& buffer = chunkSpawns[c];
+        added += bullets.spawnBatch(buffer.data(), buffer.size());
+        lastDropped += buffer.dropped();
+        buffer.clear();
+
+        SpawnBuffer<LaserSpawn>& staged = chunkLasers[c];
+        for (size_t i = 0; i < staged.size(); ++i) lasers.spawn(staged.data()[i]);
+        lastDropped += staged.dropped();
+        staged.clear();
+    }
+
+    // Stable removal, so chunk contents (and spawn order) don't depend on
+    // when other emitters finished
+    size_t kept = 0;
+    for (size_t i = 0; i < emitters.size(); ++i) {
+        if (!emitters[i].halted) {
+            if (kept != i) emitters[kept] = emitters[i];
+            ++kept;
+        }
+    }
+    emitters.resize(kept);
+    return added;
+}
+
+void EmitterPool::saveState(StateWriter& out) const {
+    out.value(emitters.size());
+    out.array(emitters.data(), emitters.size());
+}
+
+bool EmitterPool::loadState(StateReader& in) {
+    size_t n = 0;
+    if (!in.value(n) || n > capacity) return false;
+    // Within the reserved capacity, so this never allocates
+    emitters.resize(n);
+    return in.array(emitters.data(), n);
+}
+
+void EmitterPool::tick(Emitter& e, const PatternInstruction* code, float dt, float targetX, float targetY, ChunkOutput& out) {
+    if (e.halted) return;
+    e.x += e.vx * dt;
+    e.y += e.vy * dt;
+
+    for (int r = 0; r < e.rampCount;) {
+        e.regs[e.ramps[r].reg] += e.ramps[r].step;
+        if (--e.ramps[r].ticks == 0) {
+            e.ramps[r] = e.ramps[--e.rampCount];
+        } else {
+            ++r;
+        }
+    }
+
+    if (e.wait > 0) {
+        e.wait--;
+    } else if (!step(e, code, targetX, targetY, out)) {
+        e.halted = 1;
+    }
+}
+
+bool EmitterPool::step(Emitter& e, const PatternInstruction* code, float targetX, float targetY, ChunkOutput& out) {
+    auto emit = [&](float angleDeg, float speed) {
+        BulletSpawn* b = out.shots.push();
+        if (!b) return;
+        float a = angleDeg * DEG_TO_RAD;
+        float c = std::cos(a);
+        float s = std::sin(a);
+        b->x = e.x;
+        b->y = e.y;
+        b->vx = c * speed;
+        b->vy = s * speed;
+        b->ax = c * e.accel;
+        b->ay = s * e.accel;
+        b->angularVel = e.curve * DEG_TO_RAD;
+        b->lifetime = e.life;
+        b->radius = e.radius;
+        b->color = e.color;
+    };
+
+    for (int budget = MAX_OPS_PER_TICK; budget > 0; --budget) {
+        const PatternInstruction& in = code[e.pc++];
+        float a = (in.regMask & 1) ? e.regs[static_cast<int>(in.operand[0])] : in.operand[0];
+        float b = (in.regMask & 2) ? e.regs[static_cast<int>(in.operand[1])] : in.operand[1];
+        float c = (in.regMask & 4) ? e.regs[static_cast<int>(in.operand[2])] : in.operand[2];
+
+        switch (in.op) {
+        case PatternOp::HALT:
+            return false;
+        case PatternOp::SET:
+            e.regs[in.dst] = a;
+            break;
+        case PatternOp::ADD:
+            e.regs[in.dst] = a + b;
+            break;
+        case PatternOp::MUL:
+            e.regs[in.dst] = a * b;
+            break;
+        case PatternOp::SIN:
+            e.regs[in.dst] = std::sin(a * DEG_TO_RAD);
+            break;
+        case PatternOp::RAMP: {
+            Uint32 ticks = b >= 1.0f ? static_cast<Uint32>(b) : 1;
+            // A new ramp on the same register replaces the old one
+            int slot = 0;
+            while (slot < e.rampCount && e.ramps[slot].reg != in.dst) ++slot;
+            if (slot == e.rampCount) {
+                if (e.rampCount == MAX_RAMPS) break;
+                e.rampCount++;
+            }
+            e.ramps[slot].reg = in.dst;
+            e.ramps[slot].ticks = ticks;
+            e.ramps[slot].step = (a - e.regs[in.dst]) / ticks;
+            break;
+        }
+        case PatternOp::WAIT:
+            // This tick counts as the first one waited
+            e.wait = a > 1.0f ? static_cast<Uint32>(a) - 1 : 0;
+            return true;
+        case PatternOp::LOOP: {
+            Uint32 count = a >= 1.0f ? static_cast<Uint32>(a) : 0;
+            if (count == 0) {
+                // Skip to just past the matching end
+                int depth = 1;
+                while (depth > 0) {
+                    PatternOp op = code[e.pc++].op;
+                    if (op == PatternOp::LOOP) depth++;
+                    else if (op == PatternOp::END) depth--;
+                }
+            } else {
+                e.loops[e.loopDepth++] = { e.pc, count };
+            }
+            break;
+        }
+        case PatternOp::END:
+            if (--e.loops[e.loopDepth - 1].remaining > 0) {
+                e.pc = e.loops[e.loopDepth - 1].body;
+            } else {
+                e.loopDepth--;
+            }
+            break;
+        case PatternOp::RING: {
+            int count = static_cast<int>(a);
+            float spacing = count > 0 ? 360.0f / count : 0.0f;
+            for (int i = 0; i < count; ++i) emit(c + spacing * i, b);
+            break;
+        }
+        case PatternOp::FAN: {
+            int count = static_cast<int>(a);
+            float aim = std::atan2(targetY - e.y, targetX - e.x) / DEG_TO_RAD;
+            float first = count > 1 ? aim - b * 0.5f : aim;
+            float spacing = count > 1 ? b / (count - 1) : 0.0f;
+            for (int i = 0; i < count; ++i) emit(first + spacing * i, c);
+            break;
+        }
+        case PatternOp::SHOT:
+            emit(b, a);
+            break;
+        case PatternOp::RADIUS:
+            e.radius = a;
+            break;
+        case PatternOp::COLOR:
+            std::memcpy(&e.color, &in.operand[0], sizeof(e.color));
+            break;
+        case PatternOp::LIFE:
+            e.life = a;
+            break;
+        case PatternOp::ACCEL:
+            e.accel = a;
+            break;
+        case PatternOp::CURVE:
+            e.curve = a;
+            break;
+        case PatternOp::MOVE:
+            e.vx = a;
+            e.vy = b;
+            break;
+        case PatternOp::LASER: {
+            LaserSpawn* l = out.lasers.push();
+            if (!l) break;
+            l->x = e.x;
+            l->y = e.y;
+            l->speed = a;
+            l->angle = b * DEG_TO_RAD;
+            l->angularVel = e.curve * DEG_TO_RAD;
+            l->lifetime = e.life;
+            l->radius = e.radius;
+            l->color = e.color;
+            l->length = c >= 2.0f ? static_cast<Uint32>(c) : 2;
+            break;
+        }
+        }
+    }
+    // Out of budget: carry on from here next tick
+    return true;
+}
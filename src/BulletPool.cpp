@@ -0,0 +1,388 @@
+#include "BulletPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include "JobSystem.h"
+#include "StateSnapshot.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BULLET_KERNEL_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BULLET_KERNEL_SSE2 1
+#endif
+
+namespace {
+
+// Every array is padded to a multiple of this many floats so the kernel can
+// always run whole blocks; 8 covers one AVX register and two SSE registers
+constexpr size_t LANES = 8;
+constexpr size_t ALIGNMENT = 64;
+// State images carry the arrays in whole blocks of this many bullets, so a
+// few spawns or deaths don't shift every array after the first and the XOR
+// against the previous snapshot stays mostly zero
+constexpr size_t STATE_BLOCK = 256;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+BulletPool::BulletPool(size_t capacity)
+    : maxBullets(capacity), paddedCapacity(alignUp(capacity > 0 ? capacity : 1, LANES))
+{
+    const size_t floatBytes = alignUp(paddedCapacity * sizeof(float), ALIGNMENT);
+    const size_t colorBytes = alignUp(paddedCapacity * sizeof(Uint32), ALIGNMENT);
+    const size_t flagBytes = alignUp(paddedCapacity, ALIGNMENT);
+    const size_t maskBytes = alignUp(paddedCapacity / 8, ALIGNMENT);
+    const size_t total = floatBytes * 9 + colorBytes + flagBytes + maskBytes;
+
+    // SDL_SIMDAlloc gives us memory aligned for the widest vector unit present
+    block = SDL_SIMDAlloc(total);
+    if (!block) {
+        SDL_Log("BulletPool: failed to allocate %u bytes for %u bullets",
+                static_cast<unsigned>(total), static_cast<unsigned>(capacity));
+        maxBullets = 0;
+        return;
+    }
+    // Zero so the padding lanes past count never hold NaNs or denormals
+    std::memset(block, 0, total);
+
+    Uint8* p = static_cast<Uint8*>(block);
+    float** floatArrays[] = { &x, &y, &vx, &vy, &ax, &ay, &angularVel, &life, &radius };
+    for (float** arr : floatArrays) {
+        *arr = reinterpret_cast<float*>(p);
+        p += floatBytes;
+    }
+    color = reinterpret_cast<Uint32*>(p);
+    p += colorBytes;
+    flags = p;
+    p += flagBytes;
+    deadMask = p;
+}
+
+BulletPool::~BulletPool() {
+    if (block) SDL_SIMDFree(block);
+}
+
+const char* BulletPool::kernelName() {
+#if defined(BULLET_KERNEL_AVX2)
+    return "avx2";
+#elif defined(BULLET_KERNEL_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+bool BulletPool::spawn(const BulletSpawn& b) {
+    if (count >= maxBullets) return false;
+
+    size_t i = count++;
+    x[i] = b.x;
+    y[i] = b.y;
+    vx[i] = b.vx;
+    vy[i] = b.vy;
+    ax[i] = b.ax;
+    ay[i] = b.ay;
+    angularVel[i] = b.angularVel;
+    life[i] = b.lifetime;
+    radius[i] = b.radius;
+    color[i] = b.color;
+    flags[i] = 0;
+    return true;
+}
+
+size_t BulletPool::spawnBatch(const BulletSpawn* spawns, size_t n) {
+    if (n > maxBullets - count) n = maxBullets - count;
+
+    // One pass per array keeps the writes streaming instead of scattering
+    // a struct across eleven arrays per bullet
+    float* px = x + count;
+    float* py = y + count;
+    float* pvx = vx + count;
+    float* pvy = vy + count;
+    for (size_t i = 0; i < n; ++i) {
+        px[i] = spawns[i].x;
+        py[i] = spawns[i].y;
+        pvx[i] = spawns[i].vx;
+        pvy[i] = spawns[i].vy;
+    }
+    float* pax = ax + count;
+    float* pay = ay + count;
+    float* pw = angularVel + count;
+    float* plife = life + count;
+    for (size_t i = 0; i < n; ++i) {
+        pax[i] = spawns[i].ax;
+        pay[i] = spawns[i].ay;
+        pw[i] = spawns[i].angularVel;
+        plife[i] = spawns[i].lifetime;
+    }
+    float* pr = radius + count;
+    Uint32* pc = color + count;
+    for (size_t i = 0; i < n; ++i) {
+        pr[i] = spawns[i].radius;
+        pc[i] = spawns[i].color;
+    }
+    std::memset(flags + count, 0, n);
+
+    count += n;
+    return n;
+}
+
+size_t BulletPool::killInRadius(float cx, float cy, float reach, Uint32* killed) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i += 8) {
+        unsigned mask = 0;
+#if defined(BULLET_KERNEL_AVX2) || defined(BULLET_KERNEL_SSE2)
+        // Vector test, scalar kill: on a full screen most blocks are all misses
+        const __m128 vcx = _mm_set1_ps(cx);
+        const __m128 vcy = _mm_set1_ps(cy);
+        const __m128 vreach = _mm_set1_ps(reach);
+        const __m128 zero = _mm_setzero_ps();
+        for (size_t h = 0; h < 8; h += 4) {
+            size_t j = i + h;
+            __m128 dx = _mm_sub_ps(_mm_load_ps(x + j), vcx);
+            __m128 dy = _mm_sub_ps(_mm_load_ps(y + j), vcy);
+            __m128 r = _mm_add_ps(_mm_load_ps(radius + j), vreach);
+            __m128 hit = _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(r, r));
+            hit = _mm_and_ps(hit, _mm_cmpgt_ps(_mm_load_ps(life + j), zero));
+            mask |= static_cast<unsigned>(_mm_movemask_ps(hit)) << h;
+        }
+#else
+        for (size_t lane = 0; lane < 8; ++lane) {
+            size_t j = i + lane;
+            float dx = x[j] - cx;
+            float dy = y[j] - cy;
+            float r = radius[j] + reach;
+            mask |= static_cast<unsigned>(dx * dx + dy * dy <= r * r && life[j] > 0.0f) << lane;
+        }
+#endif
+        if (i + 8 > count) mask &= (1u << (count - i)) - 1u; // lanes past count hold stale data
+        while (mask) {
+            int lane = 0;
+            while (!((mask >> lane) & 1u)) ++lane;
+            mask &= mask - 1u;
+            size_t j = i + lane;
+            life[j] = 0.0f;
+            if (killed) killed[n] = static_cast<Uint32>(j);
+            n++;
+        }
+    }
+    return n;
+}
+
+void BulletPool::update(float dt, const Playfield& bounds) {
+    if (count == 0) return;
+    if (integrate(0, count, dt, bounds)) {
+        compact();
+    }
+}
+
+void BulletPool::update(float dt, const Playfield& bounds, JobSystem& jobs) {
+    if (count == 0) return;
+    std::atomic<bool> anyDead(false);
+    jobs.parallelFor(count, JOB_BLOCK, [&](size_t begin, size_t end) {
+        if (integrate(begin, end, dt, bounds)) anyDead.store(true, std::memory_order_relaxed);
+    });
+    // Compaction reorders the pool, so it stays on one thread
+    if (anyDead.load(std::memory_order_relaxed)) {
+        compact();
+    }
+}
+
+// The velocity rotation uses the small-angle series cos = 1 - t^2/2,
+// sin = t - t^3/6. At 60 Hz a full turn per second is t ~ 0.1 rad, where the
+// error is far below a pixel, and it keeps sin/cos out of the kernel.
+bool BulletPool::integrate(size_t begin, size_t end, float dt, const Playfield& bounds) {
+    bool anyDead = false;
+    const size_t blockEnd = alignUp(end, LANES);
+
+#if defined(BULLET_KERNEL_AVX2)
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 sixth = _mm256_set1_ps(1.0f / 6.0f);
+    const __m256 left = _mm256_set1_ps(bounds.left);
+    const __m256 right = _mm256_set1_ps(bounds.right);
+    const __m256 top = _mm256_set1_ps(bounds.top);
+    const __m256 bottom = _mm256_set1_ps(bounds.bottom);
+
+    for (size_t i = begin; i < blockEnd; i += 8) {
+        __m256 bvx = _mm256_add_ps(_mm256_load_ps(vx + i), _mm256_mul_ps(_mm256_load_ps(ax + i), vdt));
+        __m256 bvy = _mm256_add_ps(_mm256_load_ps(vy + i), _mm256_mul_ps(_mm256_load_ps(ay + i), vdt));
+
+        __m256 t = _mm256_mul_ps(_mm256_load_ps(angularVel + i), vdt);
+        __m256 t2 = _mm256_mul_ps(t, t);
+        __m256 c = _mm256_sub_ps(one, _mm256_mul_ps(half, t2));
+        __m256 s = _mm256_mul_ps(t, _mm256_sub_ps(one, _mm256_mul_ps(sixth, t2)));
+        __m256 nvx = _mm256_sub_ps(_mm256_mul_ps(bvx, c), _mm256_mul_ps(bvy, s));
+        __m256 nvy = _mm256_add_ps(_mm256_mul_ps(bvx, s), _mm256_mul_ps(bvy, c));
+        _mm256_store_ps(vx + i, nvx);
+        _mm256_store_ps(vy + i, nvy);
+
+        __m256 px = _mm256_add_ps(_mm256_load_ps(x + i), _mm256_mul_ps(nvx, vdt));
+        __m256 py = _mm256_add_ps(_mm256_load_ps(y + i), _mm256_mul_ps(nvy, vdt));
+        _mm256_store_ps(x + i, px);
+        _mm256_store_ps(y + i, py);
+
+        __m256 l = _mm256_sub_ps(_mm256_load_ps(life + i), vdt);
+        _mm256_store_ps(life + i, l);
+
+        __m256 r = _mm256_load_ps(radius + i);
+        __m256 dead = _mm256_cmp_ps(l, zero, _CMP_LE_OQ);
+        dead = _mm256_or_ps(dead, _mm256_cmp_ps(_mm256_add_ps(px, r), left, _CMP_LT_OQ));
+        dead = _mm256_or_ps(dead, _mm256_cmp_ps(_mm256_sub_ps(px, r), right, _CMP_GT_OQ));
+        dead = _mm256_or_ps(dead, _mm256_cmp_ps(_mm256_add_ps(py, r), top, _CMP_LT_OQ));
+        dead = _mm256_or_ps(dead, _mm256_cmp_ps(_mm256_sub_ps(py, r), bottom, _CMP_GT_OQ));
+
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(dead));
+        if (i + 8 > end) mask &= (1u << (end - i)) - 1u; // ignore padding lanes
+        deadMask[i >> 3] = static_cast<Uint8>(mask);
+        anyDead |= mask != 0;
+    }
+#elif defined(BULLET_KERNEL_SSE2)
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 sixth = _mm_set1_ps(1.0f / 6.0f);
+    const __m128 left = _mm_set1_ps(bounds.left);
+    const __m128 right = _mm_set1_ps(bounds.right);
+    const __m128 top = _mm_set1_ps(bounds.top);
+    const __m128 bottom = _mm_set1_ps(bounds.bottom);
+
+    for (size_t i = begin; i < blockEnd; i += 8) {
+        unsigned mask = 0;
+        for (size_t h = 0; h < 8; h += 4) {
+            size_t j = i + h;
+            __m128 bvx = _mm_add_ps(_mm_load_ps(vx + j), _mm_mul_ps(_mm_load_ps(ax + j), vdt));
+            __m128 bvy = _mm_add_ps(_mm_load_ps(vy + j), _mm_mul_ps(_mm_load_ps(ay + j), vdt));
+
+            __m128 t = _mm_mul_ps(_mm_load_ps(angularVel + j), vdt);
+            __m128 t2 = _mm_mul_ps(t, t);
+            __m128 c = _mm_sub_ps(one, _mm_mul_ps(half, t2));
+            __m128 s = _mm_mul_ps(t, _mm_sub_ps(one, _mm_mul_ps(sixth, t2)));
+            __m128 nvx = _mm_sub_ps(_mm_mul_ps(bvx, c), _mm_mul_ps(bvy, s));
+            __m128 nvy = _mm_add_ps(_mm_mul_ps(bvx, s), _mm_mul_ps(bvy, c));
+            _mm_store_ps(vx + j, nvx);
+            _mm_store_ps(vy + j, nvy);
+
+            __m128 px = _mm_add_ps(_mm_load_ps(x + j), _mm_mul_ps(nvx, vdt));
+            __m128 py = _mm_add_ps(_mm_load_ps(y + j), _mm_mul_ps(nvy, vdt));
+            _mm_store_ps(x + j, px);
+            _mm_store_ps(y + j, py);
+
+            __m128 l = _mm_sub_ps(_mm_load_ps(life + j), vdt);
+            _mm_store_ps(life + j, l);
+
+            __m128 r = _mm_load_ps(radius + j);
+            __m128 dead = _mm_cmple_ps(l, zero);
+            dead = _mm_or_ps(dead, _mm_cmplt_ps(_mm_add_ps(px, r), left));
+            dead = _mm_or_ps(dead, _mm_cmpgt_ps(_mm_sub_ps(px, r), right));
+            dead = _mm_or_ps(dead, _mm_cmplt_ps(_mm_add_ps(py, r), top));
+            dead = _mm_or_ps(dead, _mm_cmpgt_ps(_mm_sub_ps(py, r), bottom));
+            mask |= static_cast<unsigned>(_mm_movemask_ps(dead)) << h;
+        }
+        if (i + 8 > end) mask &= (1u << (end - i)) - 1u; // ignore padding lanes
+        deadMask[i >> 3] = static_cast<Uint8>(mask);
+        anyDead |= mask != 0;
+    }
+#else
+    for (size_t i = begin; i < blockEnd; i += 8) {
+        unsigned mask = 0;
+        for (size_t lane = 0; lane < 8; ++lane) {
+            size_t j = i + lane;
+            float bvx = vx[j] + ax[j] * dt;
+            float bvy = vy[j] + ay[j] * dt;
+
+            float t = angularVel[j] * dt;
+            float t2 = t * t;
+            float c = 1.0f - 0.5f * t2;
+            float s = t * (1.0f - (1.0f / 6.0f) * t2);
+            float nvx = bvx * c - bvy * s;
+            float nvy = bvx * s + bvy * c;
+            vx[j] = nvx;
+            vy[j] = nvy;
+
+            x[j] += nvx * dt;
+            y[j] += nvy * dt;
+            life[j] -= dt;
+
+            float r = radius[j];
+            bool dead = life[j] <= 0.0f ||
+                        x[j] + r < bounds.left || x[j] - r > bounds.right ||
+                        y[j] + r < bounds.top || y[j] - r > bounds.bottom;
+            mask |= static_cast<unsigned>(dead) << lane;
+        }
+        if (i + 8 > end) mask &= (1u << (end - i)) - 1u; // ignore padding lanes
+        deadMask[i >> 3] = static_cast<Uint8>(mask);
+        anyDead |= mask != 0;
+    }
+#endif
+
+    return anyDead;
+}
+
+void BulletPool::moveBullet(size_t from, size_t to) {
+    x[to] = x[from];
+    y[to] = y[from];
+    vx[to] = vx[from];
+    vy[to] = vy[from];
+    ax[to] = ax[from];
+    ay[to] = ay[from];
+    angularVel[to] = angularVel[from];
+    life[to] = life[from];
+    radius[to] = radius[from];
+    color[to] = color[from];
+    flags[to] = flags[from];
+}
+
+// Swap-remove every flagged bullet. Order changes, but deterministically,
+// which is all the simulation needs.
+void BulletPool::compact() {
+    size_t n = count;
+    size_t i = 0;
+    while (i < n) {
+        // Skip whole blocks with nothing dead in them
+        if ((i & 7) == 0 && i + 8 <= n && deadMask[i >> 3] == 0) {
+            i += 8;
+            continue;
+        }
+        if (!isDead(i)) {
+            ++i;
+            continue;
+        }
+        --n;
+        if (i != n) {
+            moveBullet(n, i);
+            setDead(i, isDead(n));
+        }
+    }
+    count = n;
+}
+
+void BulletPool::saveState(StateWriter& out) const {
+    const size_t n = std::min(alignUp(count, STATE_BLOCK), paddedCapacity);
+    out.value(count);
+    out.value(n);
+    const float* floatArrays[] = { x, y, vx, vy, ax, ay, angularVel, life, radius };
+    for (const float* arr : floatArrays) out.array(arr, n);
+    out.array(color, n);
+    out.array(flags, n);
+}
+
+bool BulletPool::loadState(StateReader& in) {
+    size_t savedCount = 0;
+    size_t n = 0;
+    if (!in.value(savedCount) || !in.value(n) || savedCount > n || n > paddedCapacity) return false;
+    float* floatArrays[] = { x, y, vx, vy, ax, ay, angularVel, life, radius };
+    for (float* arr : floatArrays) in.array(arr, n);
+    in.array(color, n);
+    in.array(flags, n);
+    count = savedCount;
+    return in.ok();
+}
@@ -0,0 +1,237 @@
+#include "CircleRenderer.h"
+#include <iostream>
+#include <cmath>
+
+namespace {
+
+float clamp01(float v) {
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+// Coverage of a filled disc, or of a ring when innerRadius > 0, for the pixel
+// whose center is (px, py). A 1 px linear ramp across the edge is plenty at
+// bullet sizes and much cheaper to generate than supersampling.
+Uint8 coverage(float px, float py, float center, float radius, float innerRadius) {
+    float dx = px - center;
+    float dy = py - center;
+    float d = std::sqrt(dx * dx + dy * dy);
+    float a = clamp01(radius + 0.5f - d);
+    if (innerRadius > 0.0f) {
+        float inner = clamp01(d - innerRadius + 0.5f);
+        if (inner < a) a = inner;
+    }
+    return static_cast<Uint8>(a * 255.0f + 0.5f);
+}
+
+// White RGBA pixels with coverage in alpha, drawn into a (size x size) block
+void rasterize(Uint8* pixels, int pitch, int size, float radius, float innerRadius) {
+    const float center = size * 0.5f;
+    for (int y = 0; y < size; ++y) {
+        Uint8* row = pixels + y * pitch;
+        for (int x = 0; x < size; ++x) {
+            Uint8* p = row + x * 4;
+            p[0] = 255;
+            p[1] = 255;
+            p[2] = 255;
+            p[3] = coverage(x + 0.5f, y + 0.5f, center, radius, innerRadius);
+        }
+    }
+}
+
+int spriteSize(int radius) {
+    return radius * 2 + 2; // 1 px margin each side for the AA edge
+}
+
+}
+
+bool CircleRenderer::init(SDL_Renderer* renderer, SpriteBatch* batch) {
+    this->renderer = renderer;
+    this->batch = batch;
+
+    // Shelf-pack every radius into one atlas, smallest first
+    const int atlasWidth = 512;
+    const int padding = 1;
+    SDL_Rect placement[MAX_CACHED_RADIUS + 1] = {};
+    int penX = padding;
+    int penY = padding;
+    int shelfHeight = 0;
+    for (int r = 1; r <= MAX_CACHED_RADIUS; ++r) {
+        int size = spriteSize(r);
+        if (penX + size + padding > atlasWidth) {
+            penX = padding;
+            penY += shelfHeight + padding;
+            shelfHeight = 0;
+        }
+        placement[r] = { penX, penY, size, size };
+        penX += size + padding;
+        if (size > shelfHeight) shelfHeight = size;
+    }
+    const int atlasHeight = penY + shelfHeight + padding;
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) {
+        std::cerr << "Failed to create circle atlas surface! SDL_Error: " << SDL_GetError() << "\n";
+        return false;
+    }
+    SDL_FillRect(surface, NULL, 0);
+
+    Uint8* pixels = static_cast<Uint8*>(surface->pixels);
+    for (int r = 1; r <= MAX_CACHED_RADIUS; ++r) {
+        const SDL_Rect& rc = placement[r];
+        rasterize(pixels + rc.y * surface->pitch + rc.x * 4, surface->pitch, rc.w, static_cast<float>(r), 0.0f);
+    }
+
+    circleAtlas = SDL_CreateTextureFromSurface(renderer, surface);
+    if (circleAtlas) batch->backend().registerTexture(circleAtlas, surface);
+    SDL_FreeSurface(surface);
+    if (!circleAtlas) {
+        std::cerr << "Failed to create circle atlas texture! SDL_Error: " << SDL_GetError() << "\n";
+        return false;
+    }
+    SDL_SetTextureBlendMode(circleAtlas, SDL_BLENDMODE_BLEND);
+
+    const float invW = 1.0f / atlasWidth;
+    const float invH = 1.0f / atlasHeight;
+    for (int r = 1; r <= MAX_CACHED_RADIUS; ++r) {
+        const SDL_Rect& rc = placement[r];
+        Sprite& sprite = circleSprites[r];
+        sprite.texture = circleAtlas;
+        sprite.uv = { rc.x * invW, rc.y * invH, rc.w * invW, rc.h * invH };
+        sprite.width = rc.w;
+        sprite.height = rc.h;
+        sprite.blend = SDL_BLENDMODE_BLEND;
+    }
+    circleSprites[0] = circleSprites[1];
+    return true;
+}
+
+void CircleRenderer::cleanup() {
+    for (Sprite& sprite : ringSprites) {
+        if (sprite.texture) batch->backend().destroyTexture(sprite.texture);
+    }
+    ringSprites.clear();
+    ringKeys.clear();
+    if (circleAtlas) {
+        batch->backend().destroyTexture(circleAtlas);
+        circleAtlas = nullptr;
+    }
+}
+
+const Sprite& CircleRenderer::circleSprite(int radius) const {
+    if (radius < 1) radius = 1;
+    if (radius > MAX_CACHED_RADIUS) radius = MAX_CACHED_RADIUS;
+    return circleSprites[radius];
+}
+
+const Sprite* CircleRenderer::findRing(int radius, int thickness) {
+    for (size_t i = 0; i < ringKeys.size(); ++i) {
+        if (ringKeys[i].radius == radius && ringKeys[i].thickness == thickness) return &ringSprites[i];
+    }
+
+    // First use of this ring: rasterize and upload it once
+    int size = spriteSize(radius);
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) return nullptr;
+    rasterize(static_cast<Uint8*>(surface->pixels), surface->pitch, size,
+              static_cast<float>(radius), static_cast<float>(radius - thickness));
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture) batch->backend().registerTexture(texture, surface);
+    SDL_FreeSurface(surface);
+    if (!texture) return nullptr;
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    Sprite sprite;
+    sprite.texture = texture;
+    sprite.width = size;
+    sprite.height = size;
+    ringKeys.push_back({ radius, thickness });
+    ringSprites.push_back(sprite);
+    return &ringSprites.back();
+}
+
+void CircleRenderer::fillCircle(float cx, float cy, float radius, SDL_Color color, Uint8 layer) {
+    if (radius <= 0.0f) return;
+    if (backend == CircleBackend::SCANLINE) {
+        fillCircleSpans(cx, cy, radius, color, layer);
+        return;
+    }
+
+    // Nearest cached radius, scaled to the exact size; past the cache the
+    // largest one is stretched
+    int r = static_cast<int>(radius + 0.5f);
+    const Sprite& sprite = circleSprite(r);
+    float scale = radius / static_cast<float>(r < 1 ? 1 : (r > MAX_CACHED_RADIUS ? MAX_CACHED_RADIUS : r));
+    float half = sprite.width * 0.5f * scale;
+    batch->draw(sprite, { cx - half, cy - half, half * 2.0f, half * 2.0f }, layer, color);
+}
+
+void CircleRenderer::ring(float cx, float cy, float radius, float thickness, SDL_Color color, Uint8 layer) {
+    if (radius <= 0.0f || thickness <= 0.0f) return;
+    if (thickness >= radius) {
+        fillCircle(cx, cy, radius, color, layer);
+        return;
+    }
+    if (backend == CircleBackend::SCANLINE) {
+        ringSpans(cx, cy, radius, thickness, color, layer);
+        return;
+    }
+
+    int r = static_cast<int>(radius + 0.5f);
+    int t = static_cast<int>(thickness + 0.5f);
+    if (t < 1) t = 1;
+    const Sprite* sprite = findRing(r, t);
+    if (!sprite) {
+        ringSpans(cx, cy, radius, thickness, color, layer);
+        return;
+    }
+    float half = sprite->width * 0.5f;
+    batch->draw(*sprite, { cx - half, cy - half, half * 2.0f, half * 2.0f }, layer, color);
+}
+
+// One span per pixel row: the row's center decides the half-width
+void CircleRenderer::fillCircleSpans(float cx, float cy, float radius, SDL_Color color, Uint8 layer) {
+    const int top = static_cast<int>(std::floor(cy - radius));
+    const int bottom = static_cast<int>(std::ceil(cy + radius));
+    const float r2 = radius * radius;
+
+    for (int y = top; y < bottom; ++y) {
+        float dy = (y + 0.5f) - cy;
+        float d2 = r2 - dy * dy;
+        if (d2 < 0.0f) continue;
+        float hw = std::sqrt(d2);
+        float x0 = std::floor(cx - hw + 0.5f);
+        float x1 = std::floor(cx + hw + 0.5f);
+        if (x1 <= x0) continue;
+        batch->drawRect({ x0, static_cast<float>(y), x1 - x0, 1.0f }, layer, color);
+    }
+}
+
+void CircleRenderer::ringSpans(float cx, float cy, float radius, float thickness, SDL_Color color, Uint8 layer) {
+    const int top = static_cast<int>(std::floor(cy - radius));
+    const int bottom = static_cast<int>(std::ceil(cy + radius));
+    const float r2 = radius * radius;
+    const float inner = radius - thickness;
+    const float inner2 = inner * inner;
+
+    for (int y = top; y < bottom; ++y) {
+        float dy = (y + 0.5f) - cy;
+        float d2 = r2 - dy * dy;
+        if (d2 < 0.0f) continue;
+        float hw = std::sqrt(d2);
+        float x0 = std::floor(cx - hw + 0.5f);
+        float x1 = std::floor(cx + hw + 0.5f);
+        if (x1 <= x0) continue;
+
+        float id2 = inner2 - dy * dy;
+        if (id2 <= 0.0f) {
+            // Row passes above/below the hole: one span
+            batch->drawRect({ x0, static_cast<float>(y), x1 - x0, 1.0f }, layer, color);
+            continue;
+        }
+        float ihw = std::sqrt(id2);
+        float i0 = std::floor(cx - ihw + 0.5f);
+        float i1 = std::floor(cx + ihw + 0.5f);
+        if (i0 > x0) batch->drawRect({ x0, static_cast<float>(y), i0 - x0, 1.0f }, layer, color);
+        if (x1 > i1) batch->drawRect({ i1, static_cast<float>(y), x1 - i1, 1.0f }, layer, color);
+    }
+}
@@ -0,0 +1,120 @@
+#include "CollisionGrid.h"
+#include <cmath>
+#include "JobSystem.h"
+
+CollisionGrid::CollisionGrid(const Playfield& bounds, float cellSize, size_t maxItems)
+    : bounds(bounds), cellSize(cellSize), invCellSize(1.0f / cellSize), maxItems(maxItems)
+{
+    cols = static_cast<int>(std::ceil(bounds.width() / cellSize));
+    rows = static_cast<int>(std::ceil(bounds.height() / cellSize));
+    if (cols < 1) cols = 1;
+    if (rows < 1) rows = 1;
+
+    // Everything is sized up front; build() never allocates
+    cellOf.resize(maxItems);
+    cellStart.resize(static_cast<size_t>(cols) * rows + 1);
+    sortedIndex.resize(maxItems);
+    sortedX.resize(maxItems);
+    sortedY.resize(maxItems);
+    sortedR.resize(maxItems);
+
+    const size_t blocks = (maxItems + JOB_BLOCK - 1) / JOB_BLOCK;
+    blockCursor.resize(blocks * cols * rows);
+    blockMaxRadius.resize(blocks);
+}
+
+void CollisionGrid::build(const float* x, const float* y, const float* radius, size_t count) {
+    if (count > maxItems) count = maxItems;
+    itemCount = count;
+    maxRadius = 0.0f;
+
+    const size_t cellCount = static_cast<size_t>(cols) * rows;
+    Uint32* start = cellStart.data();
+    for (size_t c = 0; c <= cellCount; ++c) start[c] = 0;
+
+    // Count. Items outside the field land in the nearest edge cell, so
+    // queries near the walls still see them.
+    for (size_t i = 0; i < count; ++i) {
+        Uint32 cell = static_cast<Uint32>(cellRow(y[i]) * cols + cellColumn(x[i]));
+        cellOf[i] = cell;
+        start[cell + 1]++;
+        if (radius[i] > maxRadius) maxRadius = radius[i];
+    }
+
+    // Prefix sum: start[c] becomes the first slot of cell c
+    for (size_t c = 1; c <= cellCount; ++c) start[c] += start[c - 1];
+
+    // Scatter, using start[] as a write cursor. Afterwards every cursor has
+    // advanced to the next cell's start, so shift back by one cell.
+    for (size_t i = 0; i < count; ++i) {
+        Uint32 slot = start[cellOf[i]]++;
+        sortedIndex[slot] = static_cast<Uint32>(i);
+        sortedX[slot] = x[i];
+        sortedY[slot] = y[i];
+        sortedR[slot] = radius[i];
+    }
+    for (size_t c = cellCount; c > 0; --c) start[c] = start[c - 1];
+    start[0] = 0;
+}
+
+void CollisionGrid::build(const float* x, const float* y, const float* radius, size_t count, JobSystem& jobs) {
+    if (count > maxItems) count = maxItems;
+    itemCount = count;
+    maxRadius = 0.0f;
+
+    const size_t cellCount = static_cast<size_t>(cols) * rows;
+    const size_t blocks = (count + JOB_BLOCK - 1) / JOB_BLOCK;
+
+    // Count per block
+    jobs.parallelFor(count, JOB_BLOCK, [&](size_t begin, size_t end) {
+        const size_t block = begin / JOB_BLOCK;
+        Uint32* counts = &blockCursor[block * cellCount];
+        for (size_t c = 0; c < cellCount; ++c) counts[c] = 0;
+        float blockMax = 0.0f;
+        for (size_t i = begin; i < end; ++i) {
+            Uint32 cell = static_cast<Uint32>(cellRow(y[i]) * cols + cellColumn(x[i]));
+            cellOf[i] = cell;
+            counts[cell]++;
+            if (radius[i] > blockMax) blockMax = radius[i];
+        }
+        blockMaxRadius[block] = blockMax;
+    });
+
+    // Prefix sum over (cell, block): within a cell, block 0's items come
+    // first, exactly where the serial scatter would put them
+    Uint32* start = cellStart.data();
+    Uint32 running = 0;
+    for (size_t c = 0; c < cellCount; ++c) {
+        start[c] = running;
+        for (size_t b = 0; b < blocks; ++b) {
+            Uint32& cursor = blockCursor[b * cellCount + c];
+            Uint32 n = cursor;
+            cursor = running;
+            running += n;
+        }
+    }
+    start[cellCount] = running;
+    for (size_t b = 0; b < blocks; ++b) {
+        if (blockMaxRadius[b] > maxRadius) maxRadius = blockMaxRadius[b];
+    }
+
+    jobs.parallelFor(count, JOB_BLOCK, [&](size_t begin, size_t end) {
+        Uint32* cursor = &blockCursor[(begin / JOB_BLOCK) * cellCount];
+        for (size_t i = begin; i < end; ++i) {
+            Uint32 slot = cursor[cellOf[i]]++;
+            sortedIndex[slot] = static_cast<Uint32>(i);
+            sortedX[slot] = x[i];
+            sortedY[slot] = y[i];
+            sortedR[slot] = radius[i];
+        }
+    });
+}
+
+bool CollisionGrid::overlapsAny(float cx, float cy, float radius) const {
+    bool hit = false;
+    queryCircle(cx, cy, radius, [&](size_t) {
+        hit = true;
+        return false;
+    });
+    return hit;
+}
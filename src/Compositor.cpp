@@ -0,0 +1,120 @@
+#include "Compositor.h"
+#include "Profiler.h"
+
+bool Compositor::init(SDL_Renderer* renderer, SpriteBatch* batch, int width, int height) {
+    this->renderer = renderer;
+    this->batch = batch;
+    this->width = width;
+    this->height = height;
+    rateStart = SDL_GetTicks();
+
+    if (!batch->backend().supportsTargets()) {
+        SDL_Log("Render targets not supported; drawing every layer live");
+        return true;
+    }
+    for (Layer& layer : layers) {
+        layer.texture = batch->backend().createTarget(width, height);
+        if (!layer.texture) {
+            SDL_Log("Failed to create layer texture: %s", SDL_GetError());
+            cleanup();
+            return false;
+        }
+        // Set by hand: the CPU backend's target handles aren't window-sized
+        layer.sprite = Sprite();
+        layer.sprite.texture = layer.texture;
+        layer.sprite.width = width;
+        layer.sprite.height = height;
+        layer.dirty = true;
+    }
+    return true;
+}
+
+void Compositor::cleanup() {
+    for (Layer& layer : layers) {
+        if (layer.texture) {
+            batch->backend().destroyTexture(layer.texture);
+            layer.texture = nullptr;
+        }
+        layer.sprite = Sprite();
+    }
+}
+
+void Compositor::setLayer(CompositeLayer layer, SDL_Rect area, bool opaque, Uint8 batchLayer, Builder builder) {
+    Layer& l = layers[layer];
+    l.opaque = opaque;
+    l.batchLayer = batchLayer;
+    l.builder = std::move(builder);
+    l.dirty = true;
+
+    l.dst = { static_cast<float>(area.x), static_cast<float>(area.y),
+              static_cast<float>(area.w), static_cast<float>(area.h) };
+    if (l.texture) {
+        l.sprite.uv = { l.dst.x / width, l.dst.y / height, l.dst.w / width, l.dst.h / height };
+        l.sprite.blend = opaque ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND;
+    }
+}
+
+void Compositor::setVisible(CompositeLayer layer, bool visible) {
+    layers[layer].visible = visible;
+}
+
+void Compositor::setLive(CompositeLayer layer, bool live) {
+    Layer& l = layers[layer];
+    if (l.live && !live) l.dirty = true;
+    l.live = live;
+}
+
+void Compositor::markAllDirty() {
+    for (Layer& layer : layers) layer.dirty = true;
+}
+
+void Compositor::rebuild(Layer& layer) {
+    PROFILE_SCOPE("layerRebuild");
+    RenderBackend& backend = batch->backend();
+    backend.setTarget(layer.texture);
+    backend.clear(layer.opaque ? SDL_Color{ 0, 0, 0, 255 } : SDL_Color{ 0, 0, 0, 0 });
+    layer.builder();
+    batch->flush();
+    backend.setTarget(nullptr);
+
+    layer.dirty = false;
+    layer.rebuilds++;
+}
+
+void Compositor::compose() {
+    PROFILE_SCOPE("compose");
+    Uint32 now = SDL_GetTicks();
+    if (now - rateStart >= 1000) {
+        for (Layer& layer : layers) {
+            layer.rebuildRate = layer.rebuilds;
+            layer.rebuilds = 0;
+        }
+        rateStart = now;
+    }
+
+    // All rebuilds first: each one flushes the batch into its own target
+    for (Layer& layer : layers) {
+        if (layer.visible && layer.dirty && !layer.live && layer.texture && layer.builder) {
+            rebuild(layer);
+        }
+    }
+
+    for (Layer& layer : layers) {
+        if (!layer.visible) continue;
+        if (layer.live || !layer.texture) {
+            if (layer.builder) layer.builder();
+        } else {
+            batch->draw(layer.sprite, layer.dst, layer.batchLayer);
+        }
+    }
+}
+
+const char* Compositor::layerName(CompositeLayer layer) {
+    switch (layer) {
+    case COMPOSITE_FRAME: return "frame";
+    case COMPOSITE_PLAYFIELD: return "field";
+    case COMPOSITE_HUD: return "hud";
+    case COMPOSITE_OVERLAY: return "overlay";
+    default: return "?";
+    }
+}
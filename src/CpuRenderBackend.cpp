@@ -0,0 +1,723 @@
+#include "CpuRenderBackend.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RASTER_KERNEL_AVX2 1
+#define RASTER_KERNEL_SIMD 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RASTER_KERNEL_SSE2 1
+#define RASTER_KERNEL_SIMD 1
+#endif
+
+namespace {
+
+// What a run's SDL blend mode turns into once everything is premultiplied.
+// The pack's custom premultiplied mode is plain "over" here.
+enum BlendOp : Uint8 {
+    OP_COPY,
+    OP_OVER,
+    OP_ADD,
+    OP_MOD
+};
+
+constexpr Uint32 WHITE = 0xFFFFFFFFu;
+
+Uint8 blendOp(SDL_BlendMode mode) {
+    switch (mode) {
+    case SDL_BLENDMODE_NONE: return OP_COPY;
+    case SDL_BLENDMODE_ADD: return OP_ADD;
+    case SDL_BLENDMODE_MOD: return OP_MOD;
+    default: return OP_OVER;
+    }
+}
+
+// a * b / 255, rounded, for a and b in 0..255
+inline Uint8 mul255(unsigned a, unsigned b) {
+    unsigned t = a * b + 128;
+    return static_cast<Uint8>((t + (t >> 8)) >> 8);
+}
+
+// Pixels are RGBA bytes in memory; scalar code goes through bytes so it
+// doesn't care about endianness
+Uint32 premultiply(SDL_Color c) {
+    Uint8 p[4] = { mul255(c.r, c.a), mul255(c.g, c.a), mul255(c.b, c.a), c.a };
+    Uint32 out;
+    std::memcpy(&out, p, 4);
+    return out;
+}
+
+int clampInt(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// First pixel whose center is at or right of f, kept in a sane range so
+// off-screen geometry can't overflow anything
+int pixelEdge(float f) {
+    float e = std::ceil(f - 0.5f);
+    if (e < -1048576.0f) return -1048576;
+    if (e > 1048576.0f) return 1048576;
+    return static_cast<int>(e);
+}
+
+Sint32 toFixed(double texels) {
+    double f = texels * 65536.0;
+    if (f < -2147483647.0) return -2147483647;
+    if (f > 2147483647.0) return 2147483647;
+    return static_cast<Sint32>(std::floor(f));
+}
+
+#if defined(RASTER_KERNEL_SIMD)
+
+// Eight 16-bit lanes holding 0..255 each
+inline __m128i mul255x8(__m128i a, __m128i b) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// Broadcast each pixel's alpha to its four lanes
+inline __m128i alphaX8(__m128i px) {
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+inline __m128i over4(__m128i s, __m128i d) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(255);
+    __m128i lo = mul255x8(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, alphaX8(_mm_unpacklo_epi8(s, zero))));
+    __m128i hi = mul255x8(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, alphaX8(_mm_unpackhi_epi8(s, zero))));
+    return _mm_adds_epu8(_mm_packus_epi16(lo, hi), s);
+}
+
+inline __m128i multiply4(__m128i s, __m128i d) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = mul255x8(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+    __m128i hi = mul255x8(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+    return _mm_packus_epi16(lo, hi);
+}
+
+#endif
+
+#if defined(RASTER_KERNEL_AVX2)
+
+// Same as above on 256 bits; unpack and pack both work per 128-bit half, so
+// pixel order comes back out unchanged
+inline __m256i mul255x16(__m256i a, __m256i b) {
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+inline __m256i alphaX16(__m256i px) {
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+inline __m256i over8(__m256i s, __m256i d) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi16(255);
+    __m256i lo = mul255x16(_mm256_unpacklo_epi8(d, zero),
+                           _mm256_sub_epi16(full, alphaX16(_mm256_unpacklo_epi8(s, zero))));
+    __m256i hi = mul255x16(_mm256_unpackhi_epi8(d, zero),
+                           _mm256_sub_epi16(full, alphaX16(_mm256_unpackhi_epi8(s, zero))));
+    return _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), s);
+}
+
+inline __m256i multiply8(__m256i s, __m256i d) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = mul255x16(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s, zero));
+    __m256i hi = mul255x16(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s, zero));
+    return _mm256_packus_epi16(lo, hi);
+}
+
+#endif
+
+// Multiplies n premultiplied pixels by a premultiplied tint
+void modulateSpan(Uint32* px, int n, Uint32 color) {
+    int i = 0;
+#if defined(RASTER_KERNEL_AVX2)
+    const __m256i c8 = _mm256_unpacklo_epi8(_mm256_set1_epi32(static_cast<int>(color)), _mm256_setzero_si256());
+    for (; i + 8 <= n; i += 8) {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px + i));
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i lo = mul255x16(_mm256_unpacklo_epi8(s, zero), c8);
+        __m256i hi = mul255x16(_mm256_unpackhi_epi8(s, zero), c8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px + i), _mm256_packus_epi16(lo, hi));
+    }
+#endif
+#if defined(RASTER_KERNEL_SIMD)
+    const __m128i c4 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), _mm_setzero_si128());
+    for (; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + i));
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lo = mul255x8(_mm_unpacklo_epi8(s, zero), c4);
+        __m128i hi = mul255x8(_mm_unpackhi_epi8(s, zero), c4);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(px + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    Uint8 c[4];
+    std::memcpy(c, &color, 4);
+    for (; i < n; ++i) {
+        Uint8* p = reinterpret_cast<Uint8*>(px + i);
+        for (int k = 0; k < 4; ++k) p[k] = mul255(p[k], c[k]);
+    }
+}
+
+void blendSpan(Uint8 op, Uint32* dst, const Uint32* src, int n) {
+    if (op == OP_COPY) {
+        std::memcpy(dst, src, static_cast<size_t>(n) * sizeof(Uint32));
+        return;
+    }
+
+    int i = 0;
+    if (op == OP_OVER) {
+#if defined(RASTER_KERNEL_AVX2)
+        for (; i + 8 <= n; i += 8) {
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), over8(s, d));
+        }
+#endif
+#if defined(RASTER_KERNEL_SIMD)
+        for (; i + 4 <= n; i += 4) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), over4(s, d));
+        }
+#endif
+        for (; i < n; ++i) {
+            const Uint8* s = reinterpret_cast<const Uint8*>(src + i);
+            Uint8* d = reinterpret_cast<Uint8*>(dst + i);
+            const unsigned inv = 255u - s[3];
+            for (int k = 0; k < 4; ++k) {
+                unsigned v = s[k] + mul255(d[k], inv);
+                d[k] = static_cast<Uint8>(v > 255 ? 255 : v);
+            }
+        }
+    } else if (op == OP_ADD) {
+#if defined(RASTER_KERNEL_AVX2)
+        for (; i + 8 <= n; i += 8) {
+            __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_adds_epu8(s, d));
+        }
+#endif
+#if defined(RASTER_KERNEL_SIMD)
+        for (; i + 4 <= n; i += 4) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_adds_epu8(s, d));
+        }
+#endif
+        for (; i < n; ++i) {
+            const Uint8* s = reinterpret_cast<const Uint8*>(src + i);
+            Uint8* d = reinterpret_cast<Uint8*>(dst + i);
+            for (int k = 0; k < 4; ++k) {
+                unsigned v = s[k] + d[k];
+                d[k] = static_cast<Uint8>(v > 255 ? 255 : v);
+            }
+        }
+    } else {
+        // Modulate keeps the destination alpha, as SDL's does
+        Uint32 alphaBits = 0;
+        reinterpret_cast<Uint8*>(&alphaBits)[3] = 255;
+#if defined(RASTER_KERNEL_AVX2)
+        const __m256i alpha8 = _mm256_set1_epi32(static_cast<int>(alphaBits));
+        for (; i + 8 <= n; i += 8) {
+            __m256i s = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), alpha8);
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), multiply8(s, d));
+        }
+#endif
+#if defined(RASTER_KERNEL_SIMD)
+        const __m128i alpha4 = _mm_set1_epi32(static_cast<int>(alphaBits));
+        for (; i + 4 <= n; i += 4) {
+            __m128i s = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), alpha4);
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), multiply4(s, d));
+        }
+#endif
+        for (; i < n; ++i) {
+            const Uint8* s = reinterpret_cast<const Uint8*>(src + i);
+            Uint8* d = reinterpret_cast<Uint8*>(dst + i);
+            for (int k = 0; k < 3; ++k) d[k] = mul255(d[k], s[k]);
+        }
+    }
+}
+
+bool sameColor(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+// SpriteBatch's quads, v = top-left, top-right, bottom-left, bottom-right,
+// with nothing rotated or skewed and one color
+bool isAxisAligned(const SDL_Vertex& tl, const SDL_Vertex& tr, const SDL_Vertex& bl, const SDL_Vertex& br) {
+    return tl.position.y == tr.position.y && bl.position.y == br.position.y &&
+           tl.position.x == bl.position.x && tr.position.x == br.position.x &&
+           tl.tex_coord.y == tr.tex_coord.y && bl.tex_coord.y == br.tex_coord.y &&
+           tl.tex_coord.x == bl.tex_coord.x && tr.tex_coord.x == br.tex_coord.x &&
+           sameColor(tl.color, tr.color) && sameColor(tl.color, bl.color) && sameColor(tl.color, br.color);
+}
+
+}
+
+CpuRenderBackend::~CpuRenderBackend() {
+    cleanup();
+}
+
+const char* CpuRenderBackend::kernelName() {
+#if defined(RASTER_KERNEL_AVX2)
+    return "avx2";
+#elif defined(RASTER_KERNEL_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+bool CpuRenderBackend::allocateImage(Image& image, int width, int height) {
+    if (width <= 0 || height <= 0) return false;
+    // Rows padded to 64 bytes so every row starts as aligned as the block
+    const int pitch = (width + 15) & ~15;
+    const size_t bytes = static_cast<size_t>(pitch) * height * sizeof(Uint32);
+    Uint32* pixels = static_cast<Uint32*>(SDL_SIMDAlloc(bytes));
+    if (!pixels) return false;
+    std::memset(pixels, 0, bytes);
+    image.pixels = pixels;
+    image.width = width;
+    image.height = height;
+    image.pitch = pitch;
+    return true;
+}
+
+void CpuRenderBackend::freeImage(Image& image) {
+    if (image.pixels) SDL_SIMDFree(image.pixels);
+    image = Image();
+}
+
+bool CpuRenderBackend::init(SDL_Renderer* renderer, RenderStateCache&, int width, int height) {
+    this->renderer = renderer;
+    if (!allocateImage(screen, width, height)) {
+        SDL_Log("CpuRenderBackend: failed to allocate a %dx%d framebuffer", width, height);
+        return false;
+    }
+    target = &screen;
+
+    if (renderer) {
+        upload = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, width, height);
+        if (!upload) {
+            SDL_Log("CpuRenderBackend: failed to create upload texture: %s", SDL_GetError());
+            freeImage(screen);
+            return false;
+        }
+        SDL_SetTextureBlendMode(upload, SDL_BLENDMODE_NONE);
+    }
+
+    const int tiles = ((width + TILE_SIZE - 1) / TILE_SIZE) * ((height + TILE_SIZE - 1) / TILE_SIZE);
+    tileCommands.resize(tiles);
+    for (std::vector<Uint32>& tile : tileCommands) tile.reserve(256);
+    commands.reserve(16384);
+    triangleVertices.reserve(1024);
+
+    SDL_Log("CPU rasterizer: %dx%d framebuffer, %s span kernel", width, height, kernelName());
+    return true;
+}
+
+void CpuRenderBackend::cleanup() {
+    commands.clear();
+    triangleVertices.clear();
+    // The SDL textures belong to whoever made them (or die with the renderer)
+    for (auto& entry : images) freeImage(entry.second);
+    images.clear();
+    freeImage(screen);
+    target = &screen;
+    if (upload) {
+        SDL_DestroyTexture(upload);
+        upload = nullptr;
+    }
+}
+
+bool CpuRenderBackend::registerTexture(SDL_Texture* texture, SDL_Surface* surface) {
+    if (!texture || !surface) return false;
+
+    SDL_Surface* rgba = surface;
+    if (surface->format->format != SDL_PIXELFORMAT_RGBA32) {
+        rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+        if (!rgba) {
+            SDL_Log("CpuRenderBackend: could not convert surface: %s", SDL_GetError());
+            return false;
+        }
+    }
+    if (SDL_MUSTLOCK(rgba)) SDL_LockSurface(rgba);
+    bool ok = registerPixels(texture, rgba->pixels, rgba->w, rgba->h, rgba->pitch, false);
+    if (SDL_MUSTLOCK(rgba)) SDL_UnlockSurface(rgba);
+    if (rgba != surface) SDL_FreeSurface(rgba);
+    return ok;
+}
+
+bool CpuRenderBackend::registerPixels(SDL_Texture* texture, const void* pixels, int width, int height, int pitch,
+                                      bool premultiplied) {
+    if (!texture || !pixels) return false;
+
+    auto it = images.find(texture);
+    if (it != images.end()) {
+        // Pending runs may still sample the old pixels
+        finish();
+        freeImage(it->second);
+    }
+    Image& image = images[texture];
+    if (!allocateImage(image, width, height)) {
+        images.erase(texture);
+        return false;
+    }
+
+    const Uint8* src = static_cast<const Uint8*>(pixels);
+    for (int y = 0; y < height; ++y) {
+        const Uint8* s = src + static_cast<size_t>(y) * pitch;
+        Uint8* d = reinterpret_cast<Uint8*>(image.pixels + static_cast<size_t>(y) * image.pitch);
+        if (premultiplied) {
+            std::memcpy(d, s, static_cast<size_t>(width) * 4);
+            continue;
+        }
+        for (int x = 0; x < width * 4; x += 4) {
+            const Uint8 a = s[x + 3];
+            d[x + 0] = mul255(s[x + 0], a);
+            d[x + 1] = mul255(s[x + 1], a);
+            d[x + 2] = mul255(s[x + 2], a);
+            d[x + 3] = a;
+        }
+    }
+    return true;
+}
+
+SDL_Texture* CpuRenderBackend::createTarget(int width, int height) {
+    if (!renderer) return nullptr;
+    SDL_Texture* handle = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, 1, 1);
+    if (!handle) return nullptr;
+    if (!allocateImage(images[handle], width, height)) {
+        images.erase(handle);
+        SDL_DestroyTexture(handle);
+        return nullptr;
+    }
+    return handle;
+}
+
+void CpuRenderBackend::destroyTexture(SDL_Texture* texture) {
+    if (!texture) return;
+    auto it = images.find(texture);
+    if (it != images.end()) {
+        finish();
+        if (target == &it->second) target = &screen;
+        freeImage(it->second);
+        images.erase(it);
+    }
+    SDL_DestroyTexture(texture);
+}
+
+void CpuRenderBackend::setTarget(SDL_Texture* texture) {
+    // What was recorded belongs to the old target
+    finish();
+    if (!texture) {
+        target = &screen;
+        return;
+    }
+    auto it = images.find(texture);
+    if (it == images.end()) {
+        SDL_Log("CpuRenderBackend: %p is not a target; drawing to the screen", static_cast<void*>(texture));
+        target = &screen;
+        return;
+    }
+    target = &it->second;
+}
+
+void CpuRenderBackend::clear(SDL_Color color) {
+    finish();
+    const Uint32 pc = premultiply(color);
+    for (int y = 0; y < target->height; ++y) {
+        Uint32* row = target->pixels + static_cast<size_t>(y) * target->pitch;
+        std::fill_n(row, target->width, pc);
+    }
+}
+
+void CpuRenderBackend::drawGeometry(SDL_Texture* texture, SDL_BlendMode blend, const SDL_Vertex* vertices,
+                                    int vertexCount, const int* indices, int indexCount) {
+    if (!vertices || vertexCount <= 0 || !target->pixels) return;
+
+    const Image* image = nullptr;
+    if (texture) {
+        auto it = images.find(texture);
+        if (it == images.end()) {
+            if (!warnedUnregistered) {
+                SDL_Log("CpuRenderBackend: texture %p was never registered; skipping it", static_cast<void*>(texture));
+                warnedUnregistered = true;
+            }
+            return;
+        }
+        image = &it->second;
+    }
+    const Uint8 op = blendOp(blend);
+
+    const int count = indices ? indexCount : vertexCount;
+    auto at = [&](int i) { return indices ? indices[i] : i; };
+    auto valid = [&](int index) { return index >= 0 && index < vertexCount; };
+
+    int i = 0;
+    for (; i + 6 <= count; i += 6) {
+        const int i0 = at(i), i1 = at(i + 1), i2 = at(i + 2);
+        const int i3 = at(i + 3), i4 = at(i + 4), i5 = at(i + 5);
+        if (!valid(i0) || !valid(i1) || !valid(i2) || !valid(i3) || !valid(i4) || !valid(i5)) continue;
+
+        // SpriteBatch's index pattern: (0, 1, 2) (2, 1, 3)
+        if (i3 == i2 && i4 == i1 && isAxisAligned(vertices[i0], vertices[i1], vertices[i2], vertices[i5])) {
+            const SDL_Vertex quad[4] = { vertices[i0], vertices[i1], vertices[i2], vertices[i5] };
+            addQuad(image, op, quad);
+            continue;
+        }
+        addTriangle(image, op, vertices[i0], vertices[i1], vertices[i2]);
+        addTriangle(image, op, vertices[i3], vertices[i4], vertices[i5]);
+    }
+    for (; i + 3 <= count; i += 3) {
+        const int i0 = at(i), i1 = at(i + 1), i2 = at(i + 2);
+        if (!valid(i0) || !valid(i1) || !valid(i2)) continue;
+        addTriangle(image, op, vertices[i0], vertices[i1], vertices[i2]);
+    }
+}
+
+void CpuRenderBackend::addQuad(const Image* image, Uint8 blend, const SDL_Vertex* v) {
+    float fx0 = v[0].position.x;
+    float fx1 = v[1].position.x;
+    float fy0 = v[0].position.y;
+    float fy1 = v[2].position.y;
+    const float texW = image ? static_cast<float>(image->width) : 0.0f;
+    const float texH = image ? static_cast<float>(image->height) : 0.0f;
+    float u0 = v[0].tex_coord.x * texW;
+    float u1 = v[1].tex_coord.x * texW;
+    float t0 = v[0].tex_coord.y * texH;
+    float t1 = v[2].tex_coord.y * texH;
+    // Mirrored quads: walk the texture backwards instead
+    if (fx1 < fx0) {
+        std::swap(fx0, fx1);
+        std::swap(u0, u1);
+    }
+    if (fy1 < fy0) {
+        std::swap(fy0, fy1);
+        std::swap(t0, t1);
+    }
+
+    Command c;
+    c.image = image;
+    c.color = premultiply(v[0].color);
+    c.blend = blend;
+    c.triangle = false;
+    c.x0 = std::max(pixelEdge(fx0), 0);
+    c.x1 = std::min(pixelEdge(fx1), target->width);
+    c.y0 = std::max(pixelEdge(fy0), 0);
+    c.y1 = std::min(pixelEdge(fy1), target->height);
+    if (c.x1 <= c.x0 || c.y1 <= c.y0) return;
+    if (c.color == 0 && blend != OP_COPY && blend != OP_MOD) return; // fully transparent
+
+    if (image) {
+        double du = (u1 - u0) / static_cast<double>(fx1 - fx0);
+        double dv = (t1 - t0) / static_cast<double>(fy1 - fy0);
+        c.u = toFixed(u0 + (c.x0 + 0.5 - fx0) * du);
+        c.v = toFixed(t0 + (c.y0 + 0.5 - fy0) * dv);
+        c.du = toFixed(du);
+        c.dv = toFixed(dv);
+        // Unscaled sprites whose UVs went through a float or two: take the
+        // straight-copy path anyway
+        if (std::abs(c.du - 0x10000) < 8) c.du = 0x10000;
+        if (std::abs(c.dv - 0x10000) < 8) c.dv = 0x10000;
+    } else {
+        c.u = c.v = c.du = c.dv = 0;
+        // An opaque fill blends to itself
+        if (blend == OP_OVER && v[0].color.a == 255) c.blend = OP_COPY;
+    }
+    commands.push_back(c);
+}
+
+void CpuRenderBackend::addTriangle(const Image* image, Uint8 blend, const SDL_Vertex& a, const SDL_Vertex& b,
+                                   const SDL_Vertex& c) {
+    const float texW = image ? static_cast<float>(image->width) : 0.0f;
+    const float texH = image ? static_cast<float>(image->height) : 0.0f;
+    const float minX = std::min(a.position.x, std::min(b.position.x, c.position.x));
+    const float maxX = std::max(a.position.x, std::max(b.position.x, c.position.x));
+    const float minY = std::min(a.position.y, std::min(b.position.y, c.position.y));
+    const float maxY = std::max(a.position.y, std::max(b.position.y, c.position.y));
+
+    Command cmd;
+    cmd.image = image;
+    cmd.color = premultiply(a.color); // flat: the first vertex's color
+    cmd.blend = blend;
+    cmd.triangle = true;
+    cmd.x0 = std::max(pixelEdge(minX), 0);
+    cmd.x1 = std::min(pixelEdge(maxX) + 1, target->width);
+    cmd.y0 = std::max(pixelEdge(minY), 0);
+    cmd.y1 = std::min(pixelEdge(maxY) + 1, target->height);
+    if (cmd.x1 <= cmd.x0 || cmd.y1 <= cmd.y0) return;
+    cmd.u = static_cast<Sint32>(triangleVertices.size());
+    cmd.v = cmd.du = cmd.dv = 0;
+
+    triangleVertices.push_back({ a.position.x, a.position.y, a.tex_coord.x * texW, a.tex_coord.y * texH });
+    triangleVertices.push_back({ b.position.x, b.position.y, b.tex_coord.x * texW, b.tex_coord.y * texH });
+    triangleVertices.push_back({ c.position.x, c.position.y, c.tex_coord.x * texW, c.tex_coord.y * texH });
+    commands.push_back(cmd);
+}
+
+void CpuRenderBackend::finish() {
+    if (commands.empty()) return;
+    PROFILE_SCOPE("rasterize");
+
+    const int tilesX = (target->width + TILE_SIZE - 1) / TILE_SIZE;
+    const int tilesY = (target->height + TILE_SIZE - 1) / TILE_SIZE;
+    const size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+    if (tileCommands.size() < tileCount) tileCommands.resize(tileCount);
+    for (size_t t = 0; t < tileCount; ++t) tileCommands[t].clear();
+
+    // Bin in submission order, so each tile replays its commands in order
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const Command& c = commands[i];
+        const int tx0 = c.x0 / TILE_SIZE;
+        const int tx1 = (c.x1 - 1) / TILE_SIZE;
+        const int ty0 = c.y0 / TILE_SIZE;
+        const int ty1 = (c.y1 - 1) / TILE_SIZE;
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                tileCommands[static_cast<size_t>(ty) * tilesX + tx].push_back(static_cast<Uint32>(i));
+            }
+        }
+    }
+
+    if (jobs) {
+        jobs->parallelFor(tileCount, 1, [this, tilesX](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) rasterizeTile(static_cast<int>(t), tilesX);
+        });
+    } else {
+        for (size_t t = 0; t < tileCount; ++t) rasterizeTile(static_cast<int>(t), tilesX);
+    }
+
+    commands.clear();
+    triangleVertices.clear();
+}
+
+void CpuRenderBackend::rasterizeTile(int tile, int tilesX) const {
+    const std::vector<Uint32>& list = tileCommands[tile];
+    if (list.empty()) return;
+
+    const int tileX0 = (tile % tilesX) * TILE_SIZE;
+    const int tileY0 = (tile / tilesX) * TILE_SIZE;
+    const int tileX1 = std::min(tileX0 + TILE_SIZE, target->width);
+    const int tileY1 = std::min(tileY0 + TILE_SIZE, target->height);
+
+    for (Uint32 index : list) {
+        const Command& c = commands[index];
+        const int x0 = std::max(c.x0, tileX0);
+        const int x1 = std::min(c.x1, tileX1);
+        const int y0 = std::max(c.y0, tileY0);
+        const int y1 = std::min(c.y1, tileY1);
+        if (x1 <= x0 || y1 <= y0) continue;
+        if (c.triangle) {
+            rasterizeTriangle(c, x0, x1, y0, y1);
+        } else {
+            rasterizeQuad(c, x0, x1, y0, y1);
+        }
+    }
+}
+
+void CpuRenderBackend::rasterizeQuad(const Command& c, int x0, int x1, int y0, int y1) const {
+    alignas(64) Uint32 span[TILE_SIZE];
+    const int n = x1 - x0;
+    const Image* image = c.image;
+
+    if (!image) {
+        std::fill_n(span, n, c.color);
+        for (int y = y0; y < y1; ++y) {
+            blendSpan(c.blend, target->pixels + static_cast<size_t>(y) * target->pitch + x0, span, n);
+        }
+        return;
+    }
+
+    const Sint64 uStart = c.u + static_cast<Sint64>(x0 - c.x0) * c.du;
+    const Sint64 uEnd = uStart + static_cast<Sint64>(n - 1) * c.du;
+    // Unscaled and inside the texture: blend straight from its row
+    const bool direct = c.du == 0x10000 && c.color == WHITE && (uStart >> 16) >= 0 && (uEnd >> 16) < image->width;
+
+    for (int y = y0; y < y1; ++y) {
+        const Sint64 v = c.v + static_cast<Sint64>(y - c.y0) * c.dv;
+        const int ty = clampInt(static_cast<int>(v >> 16), 0, image->height - 1);
+        const Uint32* row = image->pixels + static_cast<size_t>(ty) * image->pitch;
+        const Uint32* src = span;
+        if (direct) {
+            src = row + (uStart >> 16);
+        } else {
+            Sint64 u = uStart;
+            for (int i = 0; i < n; ++i, u += c.du) {
+                span[i] = row[clampInt(static_cast<int>(u >> 16), 0, image->width - 1)];
+            }
+            if (c.color != WHITE) modulateSpan(span, n, c.color);
+        }
+        blendSpan(c.blend, target->pixels + static_cast<size_t>(y) * target->pitch + x0, src, n);
+    }
+}
+
+// Barycentric walk over the bounding box; only the odd rotated or skewed
+// quad ends up here, so it stays scalar
+void CpuRenderBackend::rasterizeTriangle(const Command& c, int x0, int x1, int y0, int y1) const {
+    const TriangleVertex& a = triangleVertices[c.u];
+    const TriangleVertex& b = triangleVertices[c.u + 1];
+    const TriangleVertex& d = triangleVertices[c.u + 2];
+    const float area = (b.x - a.x) * (d.y - a.y) - (b.y - a.y) * (d.x - a.x);
+    if (area == 0.0f) return;
+    const float invArea = 1.0f / area;
+    const Image* image = c.image;
+
+    alignas(64) Uint32 span[TILE_SIZE];
+    for (int y = y0; y < y1; ++y) {
+        const float py = y + 0.5f;
+        int first = -1;
+        int count = 0;
+        for (int x = x0; x < x1; ++x) {
+            const float px = x + 0.5f;
+            const float wa = ((d.x - b.x) * (py - b.y) - (d.y - b.y) * (px - b.x)) * invArea;
+            const float wb = ((a.x - d.x) * (py - d.y) - (a.y - d.y) * (px - d.x)) * invArea;
+            const float wd = 1.0f - wa - wb;
+            if (wa < 0.0f || wb < 0.0f || wd < 0.0f) {
+                if (first >= 0) break; // convex: the row's span is over
+                continue;
+            }
+            if (first < 0) first = x;
+            if (image) {
+                const float u = wa * a.u + wb * b.u + wd * d.u;
+                const float v = wa * a.v + wb * b.v + wd * d.v;
+                const int tx = clampInt(static_cast<int>(std::floor(u)), 0, image->width - 1);
+                const int ty = clampInt(static_cast<int>(std::floor(v)), 0, image->height - 1);
+                span[count] = image->pixels[static_cast<size_t>(ty) * image->pitch + tx];
+            } else {
+                span[count] = c.color;
+            }
+            count++;
+        }
+        if (count == 0) continue;
+        if (image && c.color != WHITE) modulateSpan(span, count, c.color);
+        blendSpan(c.blend, target->pixels + static_cast<size_t>(y) * target->pitch + first, span, count);
+    }
+}
+
+void CpuRenderBackend::present() {
+    finish();
+    if (!renderer || !upload) return;
+    SDL_UpdateTexture(upload, nullptr, screen.pixels, screen.pitch * static_cast<int>(sizeof(Uint32)));
+    SDL_RenderCopy(renderer, upload, nullptr, nullptr);
+    SDL_RenderPresent(renderer);
+}
+
+bool CpuRenderBackend::readPixels(Uint32* dst, int width, int height) {
+    finish();
+    if (!screen.pixels || width > screen.width || height > screen.height) return false;
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(dst + static_cast<size_t>(y) * width, screen.pixels + static_cast<size_t>(y) * screen.pitch,
+                    width * sizeof(Uint32));
+    }
+    return true;
+}
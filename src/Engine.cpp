@@ -1,17 +1,78 @@
 #include "Engine.h"
 #include <iostream>
-#include <sstream>
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <SDL_image.h>
 
+namespace {
+
+// Particle presets: speed min/max, life min/max, radius start/end,
+// color start/end, drag, gravity
+const ParticlePreset BOMB_RING = { 380.0f, 420.0f, 0.45f, 0.55f, 3.0f, 1.0f, 0xFFFFFFFFu, 0x60C0FF00u, 1.5f, 0.0f };
+const ParticlePreset BOMB_SPARKS = { 60.0f, 320.0f, 0.4f, 1.0f, 3.0f, 0.5f, 0xFFE080FFu, 0xFF400000u, 2.0f, 0.0f };
+// Colors are filled in from each cleared bullet
+const ParticlePreset BULLET_DEBRIS = { 20.0f, 90.0f, 0.25f, 0.5f, 2.0f, 1.0f, 0, 0, 3.0f, 0.0f };
+const ParticlePreset ENEMY_POP = { 40.0f, 180.0f, 0.25f, 0.5f, 2.5f, 0.5f, 0xFFA060FFu, 0xE0404000u, 2.5f, 0.0f };
+const ParticlePreset PLAYER_HIT = { 120.0f, 160.0f, 0.3f, 0.4f, 2.0f, 1.0f, 0xFF6060FFu, 0xFF000000u, 1.0f, 0.0f };
+const ParticlePreset PLAYER_TRAIL = { 0.0f, 15.0f, 0.15f, 0.25f, 2.0f, 0.5f, 0x80C0FFA0u, 0x80C0FF00u, 0.0f, 40.0f };
+
+}
+
 Engine::Engine(const std::string& title, int width, int height)
     : title(title), width(width), height(height),
       window(nullptr), renderer(nullptr), isRunning(false),
-      rectX(100), rectY(100), rectSpeed(4),
-      font(nullptr), fpsTexture(nullptr), fpsTimerStart(0), frameCount(0), currentFPS(0),
+      entitySystems(Playfield::fromWindow(width, height)),
+      bullets(MAX_BULLETS),
+      lasers(MAX_LASERS),
+      particles(MAX_PARTICLES),
+      bombCleared(MAX_BULLETS),
+      emitters(MAX_EMITTERS, MAX_SPAWNS_PER_TICK),
+      bulletGrid(Playfield::fromWindow(width, height), COLLISION_CELL_SIZE, MAX_BULLETS),
+      frameArena(FRAME_ARENA_BYTES),
+      fpsTimerStart(0), frameCount(0), currentFPS(0),
       currentState(GameState::TITLE_SCREEN)
-{}
+{
+    // Compiled here rather than in init() so fast replay (no init) has them
+    std::string error;
+    if (!patterns.compile(PatternLibrary::builtinSource(), error)) {
+        SDL_Log("Built-in bullet patterns failed to compile: %s", error.c_str());
+    }
+    buildTickGraph();
+    player = EntitySystems::spawnPlayer(world, 100.0f, 100.0f);
+}
+
+void Engine::setThreadCount(int threads) {
+    if (threads <= 0) threads = SDL_GetCPUCount();
+    jobs.start(threads);
+    SDL_Log("Simulation jobs on %d thread%s", jobs.threadCount(), jobs.threadCount() == 1 ? "" : "s");
+}
+
+void Engine::setAssertNoAllocations(bool enabled) {
+    if (enabled && !AllocationTracker::enabled()) {
+        SDL_Log("Allocation checks need a build with ENGINE_TRACK_ALLOCATIONS; ignoring");
+        return;
+    }
+    assertNoAllocations = enabled;
+}
+
+void Engine::setFramePacing(PacingMode mode, int targetHz) {
+    pacer.setMode(mode, targetHz);
+    // Only vsync needs the renderer's cooperation; can be switched after init too
+    if (renderer) {
+        SDL_RenderSetVSync(renderer, mode == PacingMode::VSYNC ? 1 : 0);
+    }
+}
 
 bool Engine::init() {
+    initStart = FramePacer::now();
+    if (headless) {
+        // No display needed: the dummy driver still gives the window a
+        // framebuffer for the software renderer to draw into
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    }
+
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << "\n";
         return false;
@@ -26,14 +87,19 @@ bool Engine::init() {
                               SDL_WINDOWPOS_CENTERED,
                               SDL_WINDOWPOS_CENTERED,
                               width, height,
-                              SDL_WINDOW_SHOWN);
+                              headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN);
 
     if (!window) {
         std::cerr << "Window could not be created! SDL_Error: " << SDL_GetError() << "\n";
         return false;
     }
 
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 rendererFlags = headless ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED;
+    rendererFlags |= SDL_RENDERER_TARGETTEXTURE; // compositor layers
+    if (pacer.getMode() == PacingMode::VSYNC && !headless) {
+        rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+    renderer = SDL_CreateRenderer(window, -1, rendererFlags);
     if (!renderer) {
         std::cerr << "Renderer could not be created! SDL_Error: " << SDL_GetError() << "\n";
         return false;
@@ -44,47 +110,42 @@ bool Engine::init() {
         return false;
     }
 
-    playerTexture = IMG_LoadTexture(renderer, "assets/characters/LAMBDAPLAYERTEST.png");
-    if (!playerTexture) {
-        std::cerr << "Failed to load player sprite: " << IMG_GetError() << "\n";
+    if (!spriteBatch.init(renderer, width, height, MAX_BULLETS + 4096)) {
         return false;
     }
+    // Only the CPU backend uses these: tiles are rasterized after the tick
+    // graph is done with the threads
+    spriteBatch.backend().setJobs(&jobs);
+    SDL_Log("Render backend: %s", RenderBackend::name());
 
-    SDL_SetTextureColorMod(playerTexture, 255, 255, 255);
-    SDL_SetTextureAlphaMod(playerTexture, 255);
-
-    // Load font (you need a .ttf file, place it in your project folder or provide full path)
-    font = TTF_OpenFont("LCALLIG.ttf", 16);
-    if (!font) {
-        std::cerr << "Failed to load font! TTF_Error: " << TTF_GetError() << "\n";
-        //SDL_Delay(5000); //FOR DEBUGGING
+    if (!circles.init(renderer, &spriteBatch)) {
         return false;
     }
 
-    SDL_Surface* heartSurface = IMG_Load("assets/menusprites/HEALTH.png");
-    if (!heartSurface) {
-        SDL_Log("Failed to load heart: %s", IMG_GetError());
+    if (!compositor.init(renderer, &spriteBatch, width, height)) {
         return false;
     }
-    heartTexture = SDL_CreateTextureFromSurface(renderer, heartSurface);
-    SDL_FreeSurface(heartSurface);
-
-    SDL_Surface* bombSurface = IMG_Load("assets/menusprites/BOMB.png");
-    if (!bombSurface) {
-        SDL_Log("Failed to load bomb: %s", IMG_GetError());
-        return false;
+    setupLayers();
+
+    // Nothing waits on these: the title shows from the first frame and the
+    // text and sprites come in behind it (see streamAssets())
+    assets.start(renderer, spriteBatch.backend(), ASSET_LOADERS);
+    fontAsset = assets.loadFont("LCALLIG.ttf", 16);
+
+    Uint64 loadStart = SDL_GetPerformanceCounter();
+    if (loadPackedSprites()) {
+        double loadMs = 1000.0 * (SDL_GetPerformanceCounter() - loadStart) / SDL_GetPerformanceFrequency();
+        SDL_Log("Sprites loaded from assets.pack in %.2f ms", loadMs);
+        gameAssetsReady = true;
+    } else {
+        requestLooseSprites();
     }
-    bombTexture = SDL_CreateTextureFromSurface(renderer, bombSurface);
-    SDL_FreeSurface(bombSurface);
 
-    SDL_Surface* selectorSurface = IMG_Load("assets/menusprites/selector.png");
-    if (!selectorSurface) {
-        std::cerr << "Failed to load selector sprite: " << IMG_GetError() << "\n";
-        return false;
+    // Not fatal: the game runs the same without it
+    if (!capturePath.empty() &&
+        !capture.start(capturePath.c_str(), width, height, CAPTURE_BUFFERS, CAPTURE_WORKERS)) {
+        SDL_Log("Frame capture is off");
     }
-    selectorTexture = SDL_CreateTextureFromSurface(renderer, selectorSurface);
-    SDL_FreeSurface(selectorSurface);
-
 
     fpsTimerStart = SDL_GetTicks();
 
@@ -92,6 +153,93 @@ bool Engine::init() {
     return true;
 }
 
+// Pre-decoded atlas written by asset_cooker at build time: one mmap and one
+// texture upload per page, no PNG decoding
+bool Engine::loadPackedSprites() {
+    if (!assetPack.open("assets.pack")) {
+        return false;
+    }
+    if (!assetPack.createTextures(renderer, spriteBatch.backend())) {
+        assetPack.close();
+        return false;
+    }
+    if (!assetPack.findSprite("characters/LAMBDAPLAYERTEST", playerSprite) ||
+        !assetPack.findSprite("menusprites/HEALTH", heartSprite) ||
+        !assetPack.findSprite("menusprites/BOMB", bombSprite) ||
+        !assetPack.findSprite("menusprites/selector", selectorSprite)) {
+        SDL_Log("assets.pack is missing sprites, falling back to loose PNGs");
+        assetPack.destroyTextures();
+        assetPack.close();
+        return false;
+    }
+    return true;
+}
+
+// Old path, still used when there is no pack next to the executable. The
+// PNGs decode on the asset loaders; streamAssets() picks the sprites up.
+void Engine::requestLooseSprites() {
+    spriteAssets[0] = assets.loadImage("assets/characters/LAMBDAPLAYERTEST.png");
+    spriteAssets[1] = assets.loadImage("assets/menusprites/HEALTH.png");
+    spriteAssets[2] = assets.loadImage("assets/menusprites/BOMB.png");
+    spriteAssets[3] = assets.loadImage("assets/menusprites/selector.png");
+}
+
+// Main thread, every frame until everything is in: uploads what the loaders
+// finished, then hands the font to the text renderer and the sprites to the
+// game as they become ready. Without the font or a sprite there's no game
+// to play, so either failing quits, as it did when they loaded in init().
+void Engine::streamAssets() {
+    if (assetsReported) return;
+    assets.update(ASSET_UPLOAD_BUDGET_MS);
+
+    if (!text.ready()) {
+        AssetState fontState = assets.state(fontAsset);
+        if (fontState == AssetState::READY) {
+            text.init(assets.font(fontAsset), assets.glyphs(fontAsset), assets.texture(fontAsset), &spriteBatch);
+        } else if (fontState == AssetState::FAILED) {
+            SDL_Log("Failed to load the font; quitting");
+            isRunning = false;
+        }
+    }
+
+    if (!gameAssetsReady) {
+        bool ready = true;
+        for (const AssetManager::Handle& handle : spriteAssets) {
+            AssetState state = assets.state(handle);
+            if (state == AssetState::FAILED) {
+                SDL_Log("Failed to load the sprites; quitting");
+                isRunning = false;
+                return;
+            }
+            ready = ready && state == AssetState::READY;
+        }
+        if (ready) {
+            playerSprite = assets.sprite(spriteAssets[0]);
+            heartSprite = assets.sprite(spriteAssets[1]);
+            bombSprite = assets.sprite(spriteAssets[2]);
+            selectorSprite = assets.sprite(spriteAssets[3]);
+            // The sprites are set before anyone can see this and start a game
+            gameAssetsReady = true;
+        }
+    }
+
+    AssetManager::Progress progress = assets.progress();
+    if (progress.done() && text.ready() && gameAssetsReady) {
+        assetsReported = true;
+        SDL_Log("Assets streamed in %.1f ms after init(): %d ready, decode %.1f ms on %d loader threads, "
+                "upload %.1f ms over %d frames (worst %.2f ms)",
+                FramePacer::toSeconds(FramePacer::now() - initStart) * 1000.0, progress.ready, progress.decodeMs,
+                ASSET_LOADERS, progress.uploadMs, progress.uploadFrames, progress.worstFrameUploadMs);
+    }
+}
+
+// For callers that go straight into a game without the title: benchmarks,
+// scenarios and playback
+void Engine::finishLoading() {
+    assets.finish();
+    streamAssets();
+}
+
 void Engine::updateFPS() {
     frameCount++;
     Uint32 elapsed = SDL_GetTicks() - fpsTimerStart;
@@ -101,103 +249,137 @@ void Engine::updateFPS() {
         frameCount = 0;
         fpsTimerStart = SDL_GetTicks();
 
-        // Create new FPS texture
-        if (fpsTexture) {
-            SDL_DestroyTexture(fpsTexture);
-            fpsTexture = nullptr;
-        }
-
-        std::stringstream ss;
-        ss << "FPS: " << currentFPS;
-        fpsTexture = createTextTexture(ss.str(), { 255, 255, 255, 255 });
+        // Only the string changes; the glyphs come from the atlas
+        std::snprintf(fpsText, sizeof(fpsText), "FPS: %d", currentFPS);
 
         // Position top right
-        if (fpsTexture) {
-            int texW = 0;
-            int texH = 0;
-            SDL_QueryTexture(fpsTexture, NULL, NULL, &texW, &texH);
-            fpsRect = { width - texW - 10, 10, texW, texH };
-        }
+        int textW = 0;
+        int textH = 0;
+        text.measureText(fpsText, &textW, &textH);
+        fpsRect = { width - textW - 10, 10, textW, textH };
     }
 }
 
-SDL_Texture* Engine::createTextTexture(const std::string& text, SDL_Color color) {
-    SDL_Surface* surface = TTF_RenderText_Blended(font, text.c_str(), color);
-    if (!surface) {
-        std::cerr << "Failed to create text surface! TTF_Error: " << TTF_GetError() << "\n";
-        return nullptr;
-    }
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
-    return texture;
+void Engine::drawTextCentered(const char* str, int centerX, int y, SDL_Color color, Uint8 layer) {
+    int textW = 0;
+    text.measureText(str, &textW, NULL);
+    text.drawText(str, centerX - textW / 2, y, color, layer);
 }
 
 void Engine::renderFPS() {
-    if (fpsTexture) {
-        SDL_RenderCopy(renderer, fpsTexture, NULL, &fpsRect);
+    if (fpsText[0]) {
+        text.drawText(fpsText, fpsRect.x, fpsRect.y, { 255, 255, 255, 255 }, LAYER_DEBUG);
     }
 }
 
-void Engine::handleInput() {
-    SDL_Event e;
-    while (SDL_PollEvent(&e)) {
-        if (e.type == SDL_QUIT) {
-            isRunning = false;
-        }
+void Engine::renderStats() {
+    // Counters are from the previous flush; this frame's aren't known until we submit
+    const SpriteBatch::Stats& stats = spriteBatch.lastFrameStats();
+    char line[96];
+    SDL_Color yellow = { 255, 255, 0, 255 };
+    int y = fpsRect.y + text.lineHeight() + 4;
+
+    std::snprintf(line, sizeof(line), "Draw calls: %d  (%s backend)", stats.drawCalls, RenderBackend::name());
+    text.drawText(line, width / 2 + 20, y, yellow, LAYER_DEBUG);
+    std::snprintf(line, sizeof(line), "Quads: %d  Verts: %d", stats.quads, stats.vertices);
+    text.drawText(line, width / 2 + 20, y + text.lineHeight(), yellow, LAYER_DEBUG);
+    std::snprintf(line, sizeof(line), "State sets: %d  skipped: %d",
+                  spriteBatch.stateCache().stateChanges, spriteBatch.stateCache().stateChangesSkipped);
+    text.drawText(line, width / 2 + 20, y + text.lineHeight() * 2, yellow, LAYER_DEBUG);
+    std::snprintf(line, sizeof(line), "Layer rebuilds/s: %s %d  %s %d  %s %d  %s %d",
+                  Compositor::layerName(COMPOSITE_FRAME), compositor.rebuildsPerSecond(COMPOSITE_FRAME),
+                  Compositor::layerName(COMPOSITE_PLAYFIELD), compositor.rebuildsPerSecond(COMPOSITE_PLAYFIELD),
+                  Compositor::layerName(COMPOSITE_HUD), compositor.rebuildsPerSecond(COMPOSITE_HUD),
+                  Compositor::layerName(COMPOSITE_OVERLAY), compositor.rebuildsPerSecond(COMPOSITE_OVERLAY));
+    text.drawText(line, width / 2 + 20, y + text.lineHeight() * 3, yellow, LAYER_DEBUG);
+    FrameTimings::Summary latency = inputLatency.summarize();
+    std::snprintf(line, sizeof(line), "Input latency ms: p50 %.1f  p95 %.1f  p99 %.1f  (%d keys)",
+                  latency.p50Us / 1000.0, latency.p95Us / 1000.0, latency.p99Us / 1000.0, latency.frames);
+    text.drawText(line, width / 2 + 20, y + text.lineHeight() * 4, yellow, LAYER_DEBUG);
+    if (AllocationTracker::enabled()) {
+        std::snprintf(line, sizeof(line), "Heap allocs/frame: %llu (%llu bytes)",
+                      static_cast<unsigned long long>(lastFrameAllocations.allocations),
+                      static_cast<unsigned long long>(lastFrameAllocations.bytes));
+    } else {
+        std::snprintf(line, sizeof(line), "Heap allocs/frame: not tracked");
     }
+    text.drawText(line, width / 2 + 20, y + text.lineHeight() * 5, yellow, LAYER_DEBUG);
+    // The rest belongs to the simulation and comes from the snapshot
+    std::snprintf(line, sizeof(line), "Tick arena: %u / %u KiB (peak %u)",
+                  static_cast<unsigned>(shown->arenaUsed / 1024), static_cast<unsigned>(shown->arenaCapacity / 1024),
+                  static_cast<unsigned>(shown->arenaHighWater / 1024));
+    text.drawText(line, width / 2 + 20, y + text.lineHeight() * 6, yellow, LAYER_DEBUG);
+    std::snprintf(line, sizeof(line), "Particles: %u  dropped: %llu", static_cast<unsigned>(shown->particles),
+                  static_cast<unsigned long long>(shown->droppedParticles));
+    text.drawText(line, width / 2 + 20, y + text.lineHeight() * 7, yellow, LAYER_DEBUG);
+    std::snprintf(line, sizeof(line), "Sim %s: %llu repeated frames, %llu skipped ticks",
+                  simThread.joinable() ? "thread" : "inline", static_cast<unsigned long long>(framesDuplicated),
+                  static_cast<unsigned long long>(ticksDropped));
+    text.drawText(line, width / 2 + 20, y + text.lineHeight() * 8, yellow, LAYER_DEBUG);
+    std::snprintf(line, sizeof(line), "Rewind: %u snapshots, %u KiB", static_cast<unsigned>(shown->rewindSnapshots),
+                  static_cast<unsigned>(shown->rewindBytes / 1024));
+    text.drawText(line, width / 2 + 20, y + text.lineHeight() * 9, yellow, LAYER_DEBUG);
+    std::snprintf(line, sizeof(line), "Lasers: %u  nodes: %u", static_cast<unsigned>(shown->lasers),
+                  static_cast<unsigned>(shown->laserNodes));
+    text.drawText(line, width / 2 + 20, y + text.lineHeight() * 10, yellow, LAYER_DEBUG);
+    AssetManager::Progress assetProgress = assets.progress();
+    std::snprintf(line, sizeof(line), "Assets: %d / %d ready, upload worst frame %.2f ms", assetProgress.ready,
+                  assetProgress.requested, assetProgress.worstFrameUploadMs);
+    text.drawText(line, width / 2 + 20, y + text.lineHeight() * 11, yellow, LAYER_DEBUG);
+    if (capture.active()) {
+        FrameCapture::Stats c = capture.stats();
+        std::snprintf(line, sizeof(line), "Capture: %llu written, %llu dropped, %.0f us last frame",
+                      static_cast<unsigned long long>(c.written), static_cast<unsigned long long>(c.dropped),
+                      c.lastOverheadUs);
+        text.drawText(line, width / 2 + 20, y + text.lineHeight() * 12, yellow, LAYER_DEBUG);
+    }
+    spriteBatch.stateCache().resetStats();
+}
 
-    const Uint8* keystates = SDL_GetKeyboardState(NULL);
-
-    // Static variables for key states
-    static bool escPreviouslyDown = false;
-    static bool zPreviouslyDown = false;
-    static bool upPreviouslyDown = false;
-    static bool downPreviouslyDown = false;
-    static bool xKeyPreviouslyDown = false;
+void Engine::handleInput(Uint16 buttons) {
+    PROFILE_SCOPE("handleInput");
+    // Edges against the previous tick, so a held key only acts once
+    Uint16 pressed = buttons & ~prevButtons;
+    prevButtons = buttons;
+    heldButtons = buttons;
 
     // Detect ESC key press to toggle pause
-    bool escDown = keystates[SDL_SCANCODE_ESCAPE];
-    if (escDown && !escPreviouslyDown) {
+    if (pressed & BUTTON_PAUSE) {
         if (currentState == GameState::GAME_RUNNING) {
             currentState = GameState::PAUSED;
         } else if (currentState == GameState::PAUSED) {
             currentState = GameState::GAME_RUNNING;
         }
     }
-    escPreviouslyDown = escDown;
 
     if (currentState == GameState::PAUSED) {
         // Only allow pause menu navigation inputs here
 
-        bool zDown = keystates[SDL_SCANCODE_Z];
-        bool upDown = keystates[SDL_SCANCODE_W] || keystates[SDL_SCANCODE_UP];
-        bool downDown = keystates[SDL_SCANCODE_S] || keystates[SDL_SCANCODE_DOWN];
-
         // Navigate pause menu up
-        if (upDown && !upPreviouslyDown) {
+        if (pressed & BUTTON_UP) {
             pauseMenuSelection--;
-            if (pauseMenuSelection < 0) pauseMenuSelection = 1; // wrap around
+            if (pauseMenuSelection < 0) pauseMenuSelection = PAUSE_OPTIONS - 1; // wrap around
         }
-        upPreviouslyDown = upDown;
 
         // Navigate pause menu down
-        if (downDown && !downPreviouslyDown) {
+        if (pressed & BUTTON_DOWN) {
             pauseMenuSelection++;
-            if (pauseMenuSelection > 1) pauseMenuSelection = 0; // wrap around
+            if (pauseMenuSelection >= PAUSE_OPTIONS) pauseMenuSelection = 0; // wrap around
         }
-        downPreviouslyDown = downDown;
 
         // Select option
-        if (zDown && !zPreviouslyDown) {
+        if (pressed & BUTTON_SHOOT) {
             if (pauseMenuSelection == 0) {
                 // Title selected
                 currentState = GameState::TITLE_SCREEN;
             } else if (pauseMenuSelection == 1) {
                 // Continue selected
                 currentState = GameState::GAME_RUNNING;
+            } else if (pauseMenuSelection == 2) {
+                // Restart selected; loaded once this tick is over
+                restartPending = true;
             }
         }
-        zPreviouslyDown = zDown;
 
         // Do not process any other input while paused
         return;
@@ -205,35 +387,47 @@ void Engine::handleInput() {
 
     // GAME_RUNNING state input handling below
 
-    int currentSpeed = rectSpeed;
-    if (keystates[SDL_SCANCODE_LSHIFT]) {
-        currentSpeed = rectSpeed / 2;
+    Position& pos = *world.get<Position>(player);
+    PlayerState& state = *world.get<PlayerState>(player);
+
+    float currentSpeed = static_cast<float>(state.speed);
+    if (buttons & BUTTON_FOCUS) {
+        currentSpeed = static_cast<float>(state.speed / 2);
     }
-    if (keystates[SDL_SCANCODE_W] || keystates[SDL_SCANCODE_UP]) {
-        rectY -= currentSpeed;
+    if (buttons & BUTTON_UP) {
+        pos.y -= currentSpeed;
     }
-    if (keystates[SDL_SCANCODE_S] || keystates[SDL_SCANCODE_DOWN]) {
-        rectY += currentSpeed;
+    if (buttons & BUTTON_DOWN) {
+        pos.y += currentSpeed;
     }
-    if (keystates[SDL_SCANCODE_A] || keystates[SDL_SCANCODE_LEFT]) {
-        rectX -= currentSpeed;
+    if (buttons & BUTTON_LEFT) {
+        pos.x -= currentSpeed;
     }
-    if (keystates[SDL_SCANCODE_D] || keystates[SDL_SCANCODE_RIGHT]) {
-        rectX += currentSpeed;
+    if (buttons & BUTTON_RIGHT) {
+        pos.x += currentSpeed;
     }
 
     // Bomb key handling (X key)
-    bool xKeyDown = keystates[SDL_SCANCODE_X];
-    if (xKeyDown && !xKeyPreviouslyDown) {  // Just pressed
-        if (bombs > 0) {
-            bombs--;
-            std::cout << "Bomb used! Remaining: " << bombs << std::endl;
-            // TODO: trigger bomb effect here
+    if (pressed & BUTTON_BOMB) {
+        if (state.bombs > 0) {
+            state.bombs--;
+            triggerBomb(pos.x, pos.y);
         }
     }
-    xKeyPreviouslyDown = xKeyDown;
 
     clampPosition();
+
+    // Two streams of shots while Z is held
+    if (state.shotCooldown > 0) {
+        state.shotCooldown--;
+    }
+    if ((buttons & BUTTON_SHOOT) && state.shotCooldown == 0) {
+        state.shotCooldown = SHOT_INTERVAL_TICKS;
+        float x = pos.x;
+        float y = pos.y - 12.0f;
+        EntitySystems::spawnShot(world, x - 6.0f, y);
+        EntitySystems::spawnShot(world, x + 6.0f, y);
+    }
 }
 
 
@@ -243,138 +437,851 @@ void Engine::handleTitleInput(SDL_Event& e) {
         isRunning = false;
     }
     if (e.type == SDL_KEYDOWN) {
-        if (e.key.keysym.sym == SDLK_RETURN) {
-            // Start the game
-            currentState = GameState::GAME_RUNNING;
+        // Not before the font is in either: with the pack, the sprites are
+        // ready at once, and the game's text is laid out on the sim thread,
+        // which mustn't see text.init() still running on this one
+        if (e.key.keysym.sym == SDLK_RETURN && gameAssetsReady && text.ready()) {
+            // Started by whoever runs the simulation, at its next update
+            startRequested = true;
+        }
+        else if (e.key.keysym.sym == SDLK_ESCAPE) {
+            isRunning = false;
+        }
+    }
+}
+
+void Engine::startRecordedGame() {
+    startGame();
+    if (!recordPath.empty()) {
+        startRecording();
+    }
+}
+
+void Engine::startRecording() {
+    recording.clear();
+    recording.scenarioId = activeScenario ? activeScenario->id() : 0;
+    recording.stageHash = stage.nameHash();
+    recordingActive = true;
+}
+
+void Engine::startGame() {
+    currentState = GameState::GAME_RUNNING;
+    gameCount++;
+    gameTicks = 0;
+
+    // Everything the simulation reads starts from the same values every game,
+    // so a recording replays the same way. A fresh player entity brings its
+    // health, bombs and counters back to the defaults.
+    world.clear();
+
+    // Middle of the game area (left half), about 1/3 from the bottom
+    player = EntitySystems::spawnPlayer(world, static_cast<float>((width / 2) / 2),
+                                        static_cast<float>(height * 2 / 3));
+    clampPosition();  // clamp in case edges are exceeded
+    bullets.clear();
+    lasers.clear();
+    emitters.clear();
+    particles.clear();
+    playerHit = false;
+
+    pauseMenuSelection = 0;
+    prevButtons = 0;
+    heldButtons = 0;
+    actionMap.sample(); // drop taps left over from the title screen
+    scenarioTick = 0;
+    tickAccumulator = 0.0;
+    if (!stagePath.empty()) {
+        stage.start(stagePath.c_str(), patterns, SIM_HZ);
+    }
 
-            // Set player position to middle horizontally in game area:
-            // The game area width is width / 2
-            rectX = (width / 2) / 2; // middle of left half
+    // Nothing to interpolate from on the first tick
+    entitySystems.storePrevious(world);
 
-            // Set player Y to about 1/3 from bottom (height - 1/3 height)
-            rectY = static_cast<int>(height * 2 / 3); 
+    // Restart comes back here unless a practice checkpoint moves it on
+    saveState(checkpoint);
+    rewindHistory.clear();
+    restartPending = false;
+}
 
-            clampPosition();  // clamp in case edges are exceeded
+void Engine::simulateTick(Uint16 buttons) {
+    gameTicks++;
+    frameArena.reset();
+    entitySystems.storePrevious(world);
+    handleInput(buttons);  // one tick of input + movement (or pause menu navigation)
+    if (currentState == GameState::GAME_RUNNING) {
+        if (activeScenario) {
+            activeScenario->spawnAt(scenarioTick, bullets, emitters, patterns, world, playfieldBounds());
+            scenarioTick++;
         }
-        else if (e.key.keysym.sym == SDLK_ESCAPE) {
-            isRunning = false;
+        stage.update(patterns, emitters, world, playfieldBounds());
+        updateSimulation();
+        if (stage.finished() && currentState == GameState::GAME_RUNNING) {
+            // No results screen yet; back to the title like a game over
+            SDL_Log("Stage clear: %s", stage.name());
+            stage.stop();
+            currentState = GameState::TITLE_SCREEN;
         }
     }
 }
 
+Uint64 Engine::simulationHash() {
+    // FNV-1a over everything a tick can change
+    Uint64 hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t size) {
+        const Uint8* bytes = static_cast<const Uint8*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    int state = static_cast<int>(currentState);
+    size_t count = bullets.size();
+    size_t emitterCount = emitters.size();
+    size_t laserCount = lasers.size();
+    size_t entityCount = world.size();
+    mix(world.get<Position>(player), sizeof(Position));
+    mix(world.get<Health>(player), sizeof(Health));
+    mix(world.get<PlayerState>(player), sizeof(PlayerState));
+    mix(&entityCount, sizeof(entityCount));
+    hashQuery.forEachChunk(world, [&](size_t n, Entity*, Position* pos) {
+        mix(pos, n * sizeof(Position));
+    });
+    mix(&state, sizeof(state));
+    mix(&scenarioTick, sizeof(scenarioTick));
+    if (stage.active()) {
+        Uint32 stageTick = stage.tick();
+        mix(&stageTick, sizeof(stageTick));
+    }
+    mix(&count, sizeof(count));
+    mix(&emitterCount, sizeof(emitterCount));
+    mix(bullets.posX(), count * sizeof(float));
+    mix(bullets.posY(), count * sizeof(float));
+    // Only with lasers about, so recordings from before them still check out
+    if (laserCount > 0) mix(&laserCount, sizeof(laserCount));
+    for (size_t i = 0; i < laserCount; ++i) {
+        LaserPool::Path path = lasers.path(i);
+        mix(&path.count, sizeof(path.count));
+        mix(path.x, path.firstCount * sizeof(float));
+        mix(path.wrapX, (path.count - path.firstCount) * sizeof(float));
+        mix(path.y, path.firstCount * sizeof(float));
+        mix(path.wrapY, (path.count - path.firstCount) * sizeof(float));
+    }
+    return hash;
+}
+
+void Engine::saveState(std::vector<Uint8>& image) {
+    PROFILE_SCOPE("saveState");
+    StateWriter out(image);
+    out.value(STATE_MAGIC);
+    out.value(currentState);
+    out.value(gameTicks);
+    out.value(scenarioTick);
+    out.value(prevButtons);
+    out.value(heldButtons);
+    out.value(pauseMenuSelection);
+    out.value(playerHit);
+    out.value(player);
+    world.saveState(out);
+    bullets.saveState(out);
+    lasers.saveState(out);
+    emitters.saveState(out);
+    stage.saveState(out);
+    out.finish();
+}
+
+bool Engine::loadState(const std::vector<Uint8>& image) {
+    PROFILE_SCOPE("loadState");
+    StateReader in(image.data(), image.size());
+    Uint32 magic = 0;
+    if (!in.value(magic) || magic != STATE_MAGIC) return false;
+    in.value(currentState);
+    in.value(gameTicks);
+    in.value(scenarioTick);
+    in.value(prevButtons);
+    in.value(heldButtons);
+    in.value(pauseMenuSelection);
+    in.value(playerHit);
+    in.value(player);
+    bool ok = in.ok() && world.loadState(in) && bullets.loadState(in) && lasers.loadState(in) &&
+              emitters.loadState(in) && stage.loadState(in);
+    particles.clear();
+    return ok;
+}
+
+void Engine::setRewind(int seconds, bool delta) {
+    size_t slots = seconds > 0 ? static_cast<size_t>(seconds * SIM_HZ / REWIND_INTERVAL_TICKS) : 0;
+    rewindHistory.resize(slots);
+    rewindHistory.setDelta(delta);
+}
+
+bool Engine::rewindEnabled() const {
+    // A recording replays from the start with no way to jump back
+    return rewindHistory.slotCount() > 0 && !recordingActive && !playbackActive && !scenarioInput;
+}
+
+bool Engine::rewinding() const {
+    return rewindHeld && rewindEnabled() && currentState == GameState::GAME_RUNNING && !rewindHistory.empty();
+}
+
+void Engine::stepBack() {
+    Uint32 tick = 0;
+    if (!rewindHistory.pop(stateScratch, tick) || !loadState(stateScratch)) {
+        SDL_Log("Rewind snapshot could not be loaded");
+        rewindHistory.clear();
+    }
+}
+
+void Engine::setCheckpoint() {
+    if (recordingActive) {
+        SDL_Log("Checkpoints are for practice; not while recording");
+        return;
+    }
+    saveState(checkpoint);
+    SDL_Log("Checkpoint at tick %u (%u KiB)", gameTicks, static_cast<unsigned>(checkpoint.size() / 1024));
+}
+
+void Engine::restartFromCheckpoint() {
+    restartPending = false;
+    if (!loadState(checkpoint)) {
+        SDL_Log("Checkpoint could not be loaded");
+        return;
+    }
+    rewindHistory.clear();
+    // Only ever the start of the game while recording, so the run that
+    // replays is simply the one from here
+    if (recordingActive) {
+        startRecording();
+    }
+}
+
+void Engine::recordTo(const std::string& path) {
+    recordPath = path;
+}
+
+void Engine::finishRecording() {
+    recordingActive = false;
+    recording.finish();
+    recording.finalHash = simulationHash();
+    if (recording.save(recordPath.c_str())) {
+        SDL_Log("Recorded %u ticks in %u bytes to %s", recording.tickCount(),
+                static_cast<unsigned>(recording.encodedSize()), recordPath.c_str());
+    } else {
+        SDL_Log("Could not write recording %s", recordPath.c_str());
+    }
+}
+
+bool Engine::loadRecording(const char* path) {
+    if (!playback.load(path)) {
+        SDL_Log("Could not load recording %s", path);
+        return false;
+    }
+    if (playback.scenarioId != 0 && !BenchScenario::find(playback.scenarioId)) {
+        SDL_Log("Recording %s uses unknown scenario %u", path, playback.scenarioId);
+        return false;
+    }
+    activeScenario = BenchScenario::find(playback.scenarioId);
+    playbackReader = InputRecording::Reader(playback);
+    startGame();
+    if (playback.stageHash != stage.nameHash()) {
+        // Still plays, but the waves won't be the ones that were recorded
+        SDL_Log("Recording %s was made with a different stage (--stage)", path);
+    }
+    return true;
+}
+
+bool Engine::startPlayback(const char* path) {
+    finishLoading();
+    if (!loadRecording(path)) return false;
+    playbackActive = true;
+    return true;
+}
+
+void Engine::finishPlayback() {
+    playbackActive = false;
+    Uint64 hash = simulationHash();
+    SDL_Log("Playback finished after %u ticks: %s", playback.tickCount(),
+            hash == playback.finalHash ? "state matches the recording" : "STATE DIVERGED from the recording");
+    isRunning = false;
+}
+
+bool Engine::replayFast(const char* path) {
+    if (!loadRecording(path)) return false;
+
+    // Nothing but ticks: no window, no events, no rendering
+    Uint64 start = FramePacer::now();
+    while (!playbackReader.done()) {
+        Profiler::get().beginFrame();
+        {
+            PROFILE_SCOPE("tick");
+            simulateTick(playbackReader.next());
+        }
+        Profiler::get().endFrame();
+    }
+    double seconds = FramePacer::toSeconds(FramePacer::now() - start);
+
+    Uint64 hash = simulationHash();
+    bool match = hash == playback.finalHash;
+    Uint32 ticks = playback.tickCount();
+    SDL_Log("Replayed %u ticks (%.1f s of game time) in %.3f s: %.0f ticks/s, %.1fx real time",
+            ticks, ticks * SIM_DT, seconds, seconds > 0.0 ? ticks / seconds : 0.0,
+            seconds > 0.0 ? ticks * SIM_DT / seconds : 0.0);
+    SDL_Log("Final state hash %016llx, recorded %016llx: %s", static_cast<unsigned long long>(hash),
+            static_cast<unsigned long long>(playback.finalHash), match ? "match" : "MISMATCH");
+    return match;
+}
+
 void Engine::clampPosition() {
-    // Keep rectangle within game area with 10px walls
-    int leftLimit = 10;
-    int topLimit = 10;
-    int rightLimit = (width / 2) - 10; // leave room before divider
-    int bottomLimit = height - 10;
+    // Keep the hurtbox within game area with 10px walls
+    Playfield bounds = playfieldBounds();
+    Position& pos = *world.get<Position>(player);
+    float half = world.get<PlayerState>(player)->hurtboxSize * 0.5f;
+
+    if (pos.x - half < bounds.left) pos.x = bounds.left + half;
+    if (pos.y - half < bounds.top) pos.y = bounds.top + half;
+    if (pos.x + half > bounds.right) pos.x = bounds.right - half;
+    if (pos.y + half > bounds.bottom) pos.y = bounds.bottom - half;
+}
+
+void Engine::buildTickGraph() {
+    // Emitters only write their own chunk buffers, so they can run next to
+    // the integration; everything after spawning needs the final pool
+    int emit = tickGraph.add("emitters", [this] {
+        emitters.update(patterns, static_cast<float>(SIM_DT), aimX, aimY, jobs);
+    });
+    int integrate = tickGraph.add("bullets", [this] {
+        bullets.update(static_cast<float>(SIM_DT), playfieldBounds(), jobs);
+    });
+    // Lasers are a few hundred heads and a ring each; one job is plenty
+    int laser = tickGraph.add("lasers", [this] {
+        lasers.update(static_cast<float>(SIM_DT), playfieldBounds());
+    });
+    int spawn = tickGraph.add("spawn", [this] {
+        emitters.flushSpawns(bullets, lasers);
+    }, { emit, integrate, laser });
+    int grid = tickGraph.add("grid", [this] {
+        bulletGrid.build(bullets.posX(), bullets.posY(), bullets.radii(), bullets.size(), jobs);
+    }, { spawn });
+    // Enemies, shots and items never touch the bullet pool; only the player
+    // state is shared with the collision pass, so that waits for both
+    int entities = tickGraph.add("entities", [this] {
+        entitySystems.update(world, player, static_cast<float>(SIM_DT), frameArena);
+    });
+    tickGraph.add("collisions", [this] {
+        checkCollisions();
+    }, { grid, entities });
+    // Nothing else touches the particles while the graph runs; new ones are
+    // only added before it (bombs) and after it (spawnTickEffects)
+    tickGraph.add("particles", [this] {
+        particles.update(static_cast<float>(SIM_DT), playfieldBounds(), jobs);
+    });
+}
+
+void Engine::updateSimulation() {
+    // Read up front: the entity task may grow the world while emitters aim
+    const Position& pos = *world.get<Position>(player);
+    aimX = pos.x;
+    aimY = pos.y;
+    tickGraph.run(jobs);
+    spawnTickEffects();
+}
+
+void Engine::spawnTickEffects() {
+    const EntitySystems::Kill* kills = entitySystems.kills();
+    for (size_t i = 0; i < entitySystems.killCount(); ++i) {
+        particles.burst(kills[i].x, kills[i].y, 12, ENEMY_POP);
+    }
+
+    const Position& pos = *world.get<Position>(player);
+    const PrevPosition& prev = *world.get<PrevPosition>(player);
+    if (playerHit) {
+        particles.ring(pos.x, pos.y, 24, 4.0f, PLAYER_HIT);
+        playerHit = false;
+    }
+    // A faint trail at full speed; focused movement is meant to be precise
+    if (!(heldButtons & BUTTON_FOCUS) && (pos.x != prev.x || pos.y != prev.y)) {
+        particles.trail(prev.x, prev.y, pos.x, pos.y, 2, PLAYER_TRAIL);
+    }
+}
+
+void Engine::triggerBomb(float x, float y) {
+    PROFILE_SCOPE("bomb");
+    // Every bullet in reach goes in one pass; the pool drops them on this
+    // tick's update, before the grid is built, so none of them can still hit
+    Uint32* cleared = bombCleared.data();
+    size_t n = bullets.killInRadius(x, y, BOMB_RADIUS, cleared);
+    lasers.killInRadius(x, y, BOMB_RADIUS);
+
+    // Each cleared bullet breaks up in its own color
+    const float* bx = bullets.posX();
+    const float* by = bullets.posY();
+    const Uint32* bc = bullets.colors();
+    ParticlePreset debris = BULLET_DEBRIS;
+    for (size_t k = 0; k < n; ++k) {
+        Uint32 i = cleared[k];
+        debris.colorStart = bc[i];
+        debris.colorEnd = bc[i] & 0xFFFFFF00u;
+        particles.burst(bx[i], by[i], 2, debris);
+    }
+    particles.ring(x, y, 96, 8.0f, BOMB_RING);
+    particles.burst(x, y, 256, BOMB_SPARKS);
+}
 
-    if (rectX < leftLimit) rectX = leftLimit;
-    if (rectY < topLimit) rectY = topLimit;
-    if (rectX + hurtboxSize > rightLimit) rectX = rightLimit - hurtboxSize;
-    if (rectY + hurtboxSize > bottomLimit) rectY = bottomLimit - hurtboxSize;
+void Engine::checkCollisions() {
+    const Position& pos = *world.get<Position>(player);
+    const PrevPosition& prev = *world.get<PrevPosition>(player);
+    PlayerState& state = *world.get<PlayerState>(player);
+    Health& health = *world.get<Health>(player);
+
+    // Graze: every bullet inside the larger ring counts once
+    bulletGrid.queryCircle(pos.x, pos.y, grazeRadius, [&](size_t i) {
+        if (bullets.markGrazed(i)) state.grazeCount++;
+        return true;
+    });
+    // Lasers are long and thin, so they're tested along the whole move:
+    // a fast player can't step over one between two ticks
+    state.grazeCount += static_cast<int>(lasers.graze(prev.x, prev.y, pos.x, pos.y, grazeRadius));
+
+    if (state.invulnerableTicks > 0) {
+        state.invulnerableTicks--;
+        return;
+    }
+
+    bool hit = false;
+    bulletGrid.queryCircle(pos.x, pos.y, state.hurtboxSize * 0.5f, [&](size_t i) {
+        bullets.kill(i);
+        hit = true;
+        return false;
+    });
+    // Lasers stay; only the bullet that hit is used up
+    if (!hit) hit = lasers.hits(prev.x, prev.y, pos.x, pos.y, state.hurtboxSize * 0.5f);
+
+    playerHit = hit;
+    if (hit && !noDamage) {
+        health.hp--;
+        state.invulnerableTicks = HIT_INVULNERABLE_TICKS;
+        if (health.hp <= 0) {
+            // No game over screen yet; back to the title
+            currentState = GameState::TITLE_SCREEN;
+        }
+    }
 }
 
 void Engine::run() {
-    SDL_Event e;
+    double frameTime = 0.0;
+
+    if (useSimThread) {
+        // Something to draw before the first tick comes over
+        captureSnapshot(snapshots.back());
+        snapshots.publish();
+        acquireSnapshot();
+        // The job system takes work from one outside thread, and the
+        // simulation has it now; CPU raster tiles stay on this one
+        spriteBatch.backend().setJobs(nullptr);
+        simThreadRunning = true;
+        simThread = std::thread(&Engine::simulationLoop, this);
+    }
 
     while (isRunning) {
+        Profiler::get().beginFrame();
+        runFrame(frameTime);
+        Profiler::get().endFrame();
+
+        // Paused and title frames are paced too instead of spinning a core
+        frameTime = pacer.endFrame();
+    }
+
+    if (simThread.joinable()) {
+        simThreadRunning = false;
+        simThread.join();
+    }
+
+    inputLatency.print();
+    std::printf("Frames without a new tick: %llu, ticks never shown: %llu\n",
+                static_cast<unsigned long long>(framesDuplicated), static_cast<unsigned long long>(ticksDropped));
+}
+
+void Engine::simulationLoop() {
+    // Ticks at the simulation rate whatever the display does; the main
+    // thread shows the newest snapshot and interpolates toward it
+    FramePacer simPacer;
+    simPacer.setMode(PacingMode::CAPPED, SIM_HZ);
+    double frameTime = 0.0;
+    while (simThreadRunning) {
+        updateFrame(frameTime);
+        captureSnapshot(snapshots.back());
+        snapshots.publish();
+        frameTime = simPacer.endFrame();
+    }
+}
+
+void Engine::runScenario(const BenchScenario& scenario, int frames, FrameTimings& timings) {
+    // Exactly one tick per frame and no pacing, so every run does the same work
+    beginScenario(scenario);
+    frameTimings = &timings;
+    timings.reserve(static_cast<size_t>(frames));
+
+    for (int frame = 0; frame < frames && isRunning; ++frame) {
+        Profiler::get().beginFrame();
+        runFrame(SIM_DT);
+        Profiler::get().endFrame();
+    }
+
+    frameTimings = nullptr;
+    endScenario();
+}
+
+void Engine::beginScenario(const BenchScenario& scenario) {
+    finishLoading();
+    previousScenario = activeScenario;
+    activeScenario = &scenario;
+    scenarioInput = true;
+    startGame();
+    noDamage = true;
+}
+
+void Engine::stepScenario(int ticks) {
+    for (int i = 0; i < ticks && currentState == GameState::GAME_RUNNING; ++i) {
+        simulateTick(activeScenario->buttonsAt(scenarioTick));
+    }
+}
+
+void Engine::endScenario() {
+    noDamage = false;
+    scenarioInput = false;
+    activeScenario = previousScenario;
+}
+
+void Engine::runFrame(double frameTime) {
+    PROFILE_SCOPE("frame");
+    Uint64 frameStart = FramePacer::now();
+    AllocationCounts allocStart = AllocationTracker::totals();
+    bool runningAtStart = shownState() == GameState::GAME_RUNNING;
+
+    {
+        PROFILE_SCOPE("input");
         // Poll and handle all events
+        SDL_Event e;
         while (SDL_PollEvent(&e)) {
-            if (currentState == GameState::TITLE_SCREEN) {
-                handleTitleInput(e);
-            } else if (e.type == SDL_QUIT) {
-                isRunning = false;
-            }
-            // You can add other event-based input handling here if needed
+            processEvent(e);
         }
+    }
+    Uint64 inputEnd = FramePacer::now();
 
-        // After processing all events, update movement based on key state
-        if (currentState == GameState::GAME_RUNNING) {
-            handleInput();  // This uses SDL_GetKeyboardState and moves smoothly
+    streamAssets();
+    // With a simulation thread the ticks happen over there
+    if (!simThread.joinable()) {
+        updateFrame(frameTime);
+    }
+    Uint64 updateEnd = FramePacer::now();
+
+    drawFrame();
+    Uint64 renderEnd = FramePacer::now();
+
+    // Before present: the back buffer is undefined after it
+    captureFrame();
+    Uint64 captureEnd = FramePacer::now();
+
+    presentFrame();
+    Uint64 presentEnd = FramePacer::now();
+    inputLatency.presented();
+    if (!firstFramePresented) {
+        firstFramePresented = true;
+        SDL_Log("First frame presented %.1f ms after init()", FramePacer::toSeconds(presentEnd - initStart) * 1000.0);
+    }
+
+    updateFPS();
+
+    lastFrameAllocations = AllocationTracker::since(allocStart);
+    if (runningAtStart && shownState() == GameState::GAME_RUNNING) {
+        runningFrames++;
+        if (assertNoAllocations && runningFrames > ALLOC_WARMUP_FRAMES && lastFrameAllocations.allocations > 0) {
+            SDL_Log("%llu heap allocations (%llu bytes) in running frame %d",
+                    static_cast<unsigned long long>(lastFrameAllocations.allocations),
+                    static_cast<unsigned long long>(lastFrameAllocations.bytes), runningFrames);
+            std::abort();
         }
+    }
 
-        // Rendering
-        if (currentState == GameState::TITLE_SCREEN) {
-            renderTitleScreen();
-        } else if (currentState == GameState::GAME_RUNNING) {
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-            SDL_RenderClear(renderer);
+    if (frameTimings) {
+        frameTimings->record(STAGE_INPUT, frameStart, inputEnd);
+        frameTimings->record(STAGE_UPDATE, inputEnd, updateEnd);
+        frameTimings->record(STAGE_RENDER, updateEnd, renderEnd);
+        frameTimings->record(STAGE_CAPTURE, renderEnd, captureEnd);
+        frameTimings->record(STAGE_PRESENT, captureEnd, presentEnd);
+        frameTimings->record(STAGE_FRAME, frameStart, presentEnd);
+    }
+}
 
-            render();
-            renderFPS();
-        } else if (currentState == GameState::PAUSED) {
-            // Render game normally first (optional)
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-            SDL_RenderClear(renderer);
-            render();
-            renderFPS();
-
-            // Render pause overlay/menu on top
-            renderPauseMenu();
-
-            SDL_RenderPresent(renderer);
-            // Skip the normal present and delay at the end of loop
-            continue;
+void Engine::updateFrame(double frameTime) {
+    PROFILE_SCOPE("update");
+    if (startRequested.exchange(false) && currentState == GameState::TITLE_SCREEN) {
+        startRecordedGame();
+    }
+    if (checkpointRequested.exchange(false) && currentState == GameState::GAME_RUNNING) {
+        setCheckpoint();
+    }
+
+    // Step the simulation in fixed ticks for however much time has passed,
+    // so movement speed no longer depends on the frame rate
+    if (currentState == GameState::TITLE_SCREEN) {
+        tickAccumulator = 0.0;
+        // The recorded run ended on the title; its last frame may have had
+        // a few more ticks after that, which still count for the hash
+        if (playbackActive) {
+            while (!playbackReader.done()) simulateTick(playbackReader.next());
+            finishPlayback();
         }
+    } else {
+        if (frameTime > MAX_TICKS_PER_FRAME * SIM_DT) frameTime = MAX_TICKS_PER_FRAME * SIM_DT;
+        tickAccumulator += frameTime;
+
+        while (tickAccumulator >= SIM_DT) {
+            if (rewinding()) {
+                actionMap.sample(); // taps while rewinding don't carry over
+                stepBack();
+                tickAccumulator -= SIM_DT;
+                continue;
+            }
+            Uint16 buttons = 0;
+            if (playbackActive) {
+                if (playbackReader.done()) {
+                    finishPlayback();
+                    break;
+                }
+                buttons = playbackReader.next();
+            } else if (scenarioInput) {
+                buttons = activeScenario->buttonsAt(scenarioTick);
+            } else {
+                // Per tick, so a tap between two ticks still lands on one
+                buttons = actionMap.sample();
+                lastInputSample = FramePacer::now();
+            }
+            if (recordingActive) {
+                recording.push(buttons);
+            }
+            simulateTick(buttons);
+            tickAccumulator -= SIM_DT;
+
+            if (restartPending) {
+                restartFromCheckpoint();
+            } else if (rewindEnabled() && currentState == GameState::GAME_RUNNING &&
+                       gameTicks % REWIND_INTERVAL_TICKS == 0) {
+                saveState(stateScratch);
+                rewindHistory.push(gameTicks, stateScratch);
+            }
+        }
+    }
+    // Dying or quitting to the title ends the recorded run
+    if (recordingActive && currentState == GameState::TITLE_SCREEN) {
+        finishRecording();
+    }
+}
 
-        SDL_RenderPresent(renderer);
+void Engine::drawFrame() {
+    PROFILE_SCOPE("render");
+    if (!simThread.joinable()) {
+        // Same thread: hand over what the ticks just left behind
+        captureSnapshot(snapshots.back());
+        snapshots.publish();
+    }
+    acquireSnapshot();
 
-        updateFPS();
+    if (shown->state == GameState::TITLE_SCREEN) {
+        renderTitleScreen();
+    } else {
+        // Game view, with the pause overlay as one of its layers
+        spriteBatch.backend().clear({ 0, 0, 0, 255 });
+        render();
+        renderFPS();
+    }
+    if (showRenderStats) {
+        renderStats();
+    }
+    if (showProfiler) {
+        renderProfiler();
+    }
 
-        SDL_Delay(16);  // ~60 FPS
+    if (lateLatching()) {
+        renderLatchedPlayer();
     }
+
+    // Everything above only queued quads; this is where they hit the renderer
+    PROFILE_SCOPE("flush");
+    spriteBatch.flush();
 }
 
+void Engine::captureFrame() {
+    if (!capture.active()) return;
+    PROFILE_SCOPE("capture");
+    Uint32* pixels = capture.beginFrame();
+    if (pixels) {
+        capture.endFrame(spriteBatch.backend().readPixels(pixels, width, height));
+    }
+}
 
-void Engine::drawFilledCircle(int centerX, int centerY, int radius, SDL_Color color) {
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+void Engine::presentFrame() {
+    PROFILE_SCOPE("present");
+    spriteBatch.backend().present();
+}
 
-    for (int w = 0; w < radius * 2; w++) {
-        for (int h = 0; h < radius * 2; h++) {
-            int dx = radius - w; // horizontal offset from center
-            int dy = radius - h; // vertical offset from center
-            if ((dx*dx + dy*dy) <= (radius * radius)) {
-                SDL_RenderDrawPoint(renderer, centerX + dx, centerY + dy);
-            }
+void Engine::processEvent(SDL_Event& e) {
+    const GameState state = shownState();
+    if (state == GameState::TITLE_SCREEN) {
+        handleTitleInput(e);
+    } else if (e.type == SDL_QUIT) {
+        isRunning = false;
+    }
+    if (e.type == SDL_KEYDOWN && !e.key.repeat) {
+        handleDebugKey(e.key.keysym.scancode);
+    }
+    if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+        compositor.markAllDirty();
+    }
+    // Rewind isn't a game button: it never reaches the ticks or a recording
+    if ((e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) && e.key.keysym.scancode == SDL_SCANCODE_BACKSPACE) {
+        rewindHeld = e.type == SDL_KEYDOWN;
+    } else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_FOCUS_LOST) {
+        rewindHeld = false;
+    }
+    // The map follows keys on the title too, so held keys are right when a
+    // game starts; only in-game presses are timed
+    if (actionMap.handleEvent(e) && state != GameState::TITLE_SCREEN && (!shown || shown->keyboardInput)) {
+        inputLatency.keyEvent(e.key.timestamp);
+    }
+}
+
+void Engine::handleDebugKey(SDL_Scancode key) {
+    if (key == SDL_SCANCODE_F2) {
+        // Batch counters overlay
+        showRenderStats = !showRenderStats;
+    } else if (key == SDL_SCANCODE_F3) {
+        // Per-zone timings and frame graph
+        showProfiler = !showProfiler;
+    } else if (key == SDL_SCANCODE_F4) {
+        // First press starts a trace, second one writes it out
+        if (!Profiler::get().isCapturing()) {
+            Profiler::get().startCapture();
+            SDL_Log("Profiler capture started");
+        } else if (Profiler::get().stopCapture("profile_trace.json")) {
+            SDL_Log("Profiler capture written to profile_trace.json");
+        } else {
+            SDL_Log("Could not write profile_trace.json");
         }
+    } else if (key == SDL_SCANCODE_F5) {
+        // Practice checkpoint for Restart in the pause menu
+        checkpointRequested = true;
+    }
+}
+
+void Engine::renderProfiler() {
+    const Profiler& profiler = Profiler::get();
+    const float panelX = static_cast<float>(width / 2 + 10);
+    const float panelW = static_cast<float>(width / 2 - 20);
+    const float graphH = 48.0f;
+    const float graphY = static_cast<float>(height - 10) - graphH;
+    const int line = text.lineHeight();
+
+    int rows = profiler.zoneCount();
+    int maxRows = (static_cast<int>(graphY) - 250) / line - 1;
+    if (rows > maxRows) rows = maxRows;
+    if (rows < 0) rows = 0;
+    float panelY = graphY - (rows + 1) * line - 8.0f;
+
+    spriteBatch.drawRect({ panelX, panelY, panelW, graphY + graphH - panelY }, LAYER_DEBUG, { 0, 0, 0, 180 }, SDL_BLENDMODE_BLEND);
+
+    SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Color grey = { 170, 170, 170, 255 };
+    char row[96];
+    int x = static_cast<int>(panelX) + 4;
+    int y = static_cast<int>(panelY) + 4;
+    text.drawText("zone            avg ms   max ms", x, y, grey, LAYER_DEBUG);
+    for (int i = 0; i < rows; ++i) {
+        const Profiler::Zone& z = profiler.zone(i);
+        y += line;
+        std::snprintf(row, sizeof(row), "%*s%-*s %6.2f  %6.2f", z.depth * 2, "", 14 - z.depth * 2, z.name,
+                      profiler.zoneAverageMs(i), profiler.zoneMaxMs(i));
+        text.drawText(row, x, y, white, LAYER_DEBUG);
+    }
+
+    // Frame work time, oldest on the left. Full height is two frame budgets;
+    // the line marks one, anything past it is drawn red.
+    const float budgetMs = 1000.0f / SIM_HZ;
+    const float scale = graphH / (2.0f * budgetMs);
+    const float barW = panelW / Profiler::HISTORY;
+    const float* frames = profiler.frameHistory();
+    for (int i = 0; i < Profiler::HISTORY; ++i) {
+        float ms = frames[(profiler.historyStart() + i) % Profiler::HISTORY];
+        float h = ms * scale;
+        if (h > graphH) h = graphH;
+        SDL_Color c = ms > budgetMs ? SDL_Color{ 230, 60, 60, 255 } : SDL_Color{ 80, 200, 80, 255 };
+        spriteBatch.drawRect({ panelX + i * barW, graphY + graphH - h, barW, h }, LAYER_DEBUG, c);
     }
+    spriteBatch.drawRect({ panelX, graphY + graphH - budgetMs * scale, panelW, 1.0f }, LAYER_DEBUG, { 255, 255, 0, 255 });
 }
 
+
+
 void Engine::render() {
-    // Clear screen
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderClear(renderer);
+    PROFILE_SCOPE("renderWorld");
+    // The HUD only changes with these; redraw its layer when one does
+    if (shown->health != hudHealth || shown->bombs != hudBombs || shown->graze != hudGraze ||
+        shown->items != hudItems) {
+        hudHealth = shown->health;
+        hudBombs = shown->bombs;
+        hudGraze = shown->graze;
+        hudItems = shown->items;
+        compositor.markDirty(COMPOSITE_HUD);
+    }
+    // While paused the field holds still, so it's captured once and reused
+    compositor.setLive(COMPOSITE_PLAYFIELD, shown->state == GameState::GAME_RUNNING);
+
+    bool paused = shown->state == GameState::PAUSED;
+    compositor.setVisible(COMPOSITE_OVERLAY, paused);
+    if (paused && shown->pauseSelection != overlaySelection) {
+        overlaySelection = shown->pauseSelection;
+        compositor.markDirty(COMPOSITE_OVERLAY);
+    }
 
+    compositor.compose();
+}
+
+void Engine::setupLayers() {
+    const int panelX = width / 2;
+    compositor.setLayer(COMPOSITE_FRAME, { 0, 0, width, height }, true, LAYER_BACKGROUND,
+                        [this] { renderFrame(); });
+    compositor.setLayer(COMPOSITE_PLAYFIELD, { 0, 0, panelX, height }, false, LAYER_PLAYER,
+                        [this] { renderPlayfield(); });
+    compositor.setLayer(COMPOSITE_HUD, { panelX, 0, width - panelX, height }, true, LAYER_HUD,
+                        [this] { renderHud(); });
+    compositor.setLayer(COMPOSITE_OVERLAY, { 0, 0, width, height }, false, LAYER_OVERLAY,
+                        [this] { renderPauseMenu(); });
+}
+
+void Engine::renderFrame() {
     // Draw walls for game area
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // white walls
+    SDL_Color wallColor = { 255, 255, 255, 255 }; // white walls
+    float fw = static_cast<float>(width);
+    float fh = static_cast<float>(height);
 
     // Top wall
-    SDL_Rect topWall = { 0, 0, width / 2, 10 };
-    SDL_RenderFillRect(renderer, &topWall);
+    spriteBatch.drawRect({ 0.0f, 0.0f, fw / 2, 10.0f }, LAYER_BACKGROUND, wallColor);
 
     // Left wall
-    SDL_Rect leftWall = { 0, 0, 10, height };
-    SDL_RenderFillRect(renderer, &leftWall);
+    spriteBatch.drawRect({ 0.0f, 0.0f, 10.0f, fh }, LAYER_BACKGROUND, wallColor);
 
     // Bottom wall
-    SDL_Rect bottomWall = { 0, height - 10, width / 2, 10 };
-    SDL_RenderFillRect(renderer, &bottomWall);
+    spriteBatch.drawRect({ 0.0f, fh - 10.0f, fw / 2, 10.0f }, LAYER_BACKGROUND, wallColor);
 
     // Divider between game & menu
-    SDL_Rect divider = { width / 2 - 10, 0, 10, height }; // 10px wide
-    SDL_RenderFillRect(renderer, &divider);
+    spriteBatch.drawRect({ static_cast<float>(width / 2 - 10), 0.0f, 10.0f, fh }, LAYER_BACKGROUND, wallColor); // 10px wide
+}
 
+void Engine::renderHud() {
     // Draw "HP:" text in menu
     SDL_Color white = {255, 255, 255, 255};
-    SDL_Surface* hpSurface = TTF_RenderText_Solid(font, "HP:", white);
-    SDL_Texture* hpText = SDL_CreateTextureFromSurface(renderer, hpSurface);
-
-    SDL_Rect hpTextRect = { width/2 + 20, 100, hpSurface->w, hpSurface->h };
-    SDL_RenderCopy(renderer, hpText, NULL, &hpTextRect);
-
-    SDL_FreeSurface(hpSurface);
-    SDL_DestroyTexture(hpText);
+    SDL_Rect hpTextRect = { width/2 + 20, 100, 0, 0 };
+    text.measureText("HP:", &hpTextRect.w, &hpTextRect.h);
+    text.drawText("HP:", hpTextRect.x, hpTextRect.y, white);
 
     // Draw heart sprites next to HP:
     int heartWidth = 24;
@@ -382,9 +1289,12 @@ void Engine::render() {
     int heartX = hpTextRect.x + hpTextRect.w + 10; // offset after "HP:"
     int heartY = 100; // align with text
 
-    for (int i = 0; i < playerHealth; i++) {
-        SDL_Rect heartRect = { heartX + i * (heartWidth + 5), heartY, heartWidth, heartHeight };
-        SDL_RenderCopy(renderer, heartTexture, NULL, &heartRect);
+    for (int i = 0; i < hudHealth; i++) {
+        SDL_FRect heartRect = {
+            static_cast<float>(heartX + i * (heartWidth + 5)), static_cast<float>(heartY),
+            static_cast<float>(heartWidth), static_cast<float>(heartHeight)
+        };
+        spriteBatch.draw(heartSprite, heartRect, LAYER_HUD);
     }
 
     // --- Render Bomb Bar ---
@@ -395,162 +1305,360 @@ void Engine::render() {
     int bombSpacing = 5;
 
     // Draw label "Bombs:"
-    SDL_Surface* bombTextSurface = TTF_RenderText_Solid(font, "Bombs:", white);
-    SDL_Texture* bombTextTexture = SDL_CreateTextureFromSurface(renderer, bombTextSurface);
-    SDL_Rect bombTextRect = {bombX, bombY, bombTextSurface->w, bombTextSurface->h};
-    SDL_RenderCopy(renderer, bombTextTexture, NULL, &bombTextRect);
-    SDL_FreeSurface(bombTextSurface);
-    SDL_DestroyTexture(bombTextTexture);
+    text.drawText("Bombs:", bombX, bombY, white);
 
     // Draw bombs
-    for (int i = 0; i < bombs; i++) {
-        SDL_Rect destRect = {bombX + 80 + i * (bombWidth + bombSpacing), bombY, bombWidth, bombHeight};
-        SDL_RenderCopy(renderer, bombTexture, NULL, &destRect);
+    for (int i = 0; i < hudBombs; i++) {
+        SDL_FRect destRect = {
+            static_cast<float>(bombX + 80 + i * (bombWidth + bombSpacing)), static_cast<float>(bombY),
+            static_cast<float>(bombWidth), static_cast<float>(bombHeight)
+        };
+        spriteBatch.draw(bombSprite, destRect, LAYER_HUD);
     }
 
+    // Graze counter under the bomb bar
+    char grazeText[32];
+    std::snprintf(grazeText, sizeof(grazeText), "Graze: %d", hudGraze);
+    text.drawText(grazeText, bombX, bombY + bombHeight + 10, white);
+    std::snprintf(grazeText, sizeof(grazeText), "Items: %d", hudItems);
+    text.drawText(grazeText, bombX, bombY + bombHeight + 10 + text.lineHeight(), white);
+}
+
+void Engine::renderPlayfield() {
+    // Recorded by the simulation, drawn between its last two ticks
+    shown->playfield.replay(spriteBatch, circles, text, renderAlpha);
+}
+
+void Engine::recordPlayfield(RenderCommandList& list) {
+    PROFILE_SCOPE("recordPlayfield");
+    // Enemies, shots and items share the player's layer
+    entitySystems.draw(world, list, LAYER_PLAYER);
+
+    // Lasers first, so bullets on the same layer land on top of them
+    recordLasers(list);
+    recordBullets(list);
+    recordParticles(list);
+    recordStageText(list);
+}
+
+void Engine::recordStageText(RenderCommandList& list) {
+    if (!stage.active()) return;
+    Playfield bounds = playfieldBounds();
+    int centerX = static_cast<int>((bounds.left + bounds.right) * 0.5f);
+    SDL_Color white = { 255, 255, 255, 255 };
+
+    // Boss name and the current phase along the top of the field
+    if (const char* boss = stage.bossName(world)) {
+        int y = static_cast<int>(bounds.top) + 6;
+        list.text(boss, centerX, y, white, LAYER_HUD, true);
+        const char* phase = stage.phaseName(world);
+        if (phase && phase[0]) {
+            list.text(phase, centerX, y + text.lineHeight(), { 255, 200, 120, 255 }, LAYER_HUD, true);
+        }
+    }
+
+    // Dialog in a dimmed box at the bottom, the box on the HUD's backdrop layer
+    if (const char* line = stage.dialog()) {
+        float boxHeight = static_cast<float>(text.lineHeight() + 16);
+        SDL_FRect box = { bounds.left + 8.0f, bounds.bottom - boxHeight - 8.0f, bounds.width() - 16.0f, boxHeight };
+        list.rect(box, LAYER_HUD_BACK, { 0, 0, 0, 160 }, SDL_BLENDMODE_BLEND);
+        list.text(line, centerX, static_cast<int>(box.y) + 8, white, LAYER_HUD, true);
+    }
+}
+
+void Engine::captureSnapshot(FrameSnapshot& snapshot) {
+    PROFILE_SCOPE("snapshot");
+    snapshot.state = currentState;
+    snapshot.game = gameCount;
+    snapshot.tick = gameTicks;
+    snapshot.inputSampledAt = lastInputSample;
+    snapshot.keyboardInput = !scenarioInput && !playbackActive;
+    snapshot.latchPlayer = lateLatch && currentState == GameState::GAME_RUNNING && snapshot.keyboardInput;
+    snapshot.pauseSelection = pauseMenuSelection;
+
+    const Position& pos = *world.get<Position>(player);
+    const PrevPosition& prev = *world.get<PrevPosition>(player);
+    const PlayerState& state = *world.get<PlayerState>(player);
+    snapshot.player.x = pos.x;
+    snapshot.player.y = pos.y;
+    snapshot.player.dx = pos.x - prev.x;
+    snapshot.player.dy = pos.y - prev.y;
+    snapshot.player.speed = state.speed;
+    snapshot.player.hurtboxSize = state.hurtboxSize;
+    snapshot.player.focused = (heldButtons & BUTTON_FOCUS) != 0;
+    // Blink while invulnerable after a hit
+    snapshot.player.visible = state.invulnerableTicks == 0 || (state.invulnerableTicks / 4) % 2 == 0;
+    snapshot.health = world.get<Health>(player)->hp;
+    snapshot.bombs = state.bombs;
+    snapshot.graze = state.grazeCount;
+    snapshot.items = state.itemsCollected;
+
+    snapshot.particles = particles.size();
+    snapshot.droppedParticles = particles.droppedSpawns();
+    snapshot.arenaUsed = frameArena.used();
+    snapshot.arenaCapacity = frameArena.capacity();
+    snapshot.arenaHighWater = frameArena.highWater();
+    snapshot.rewindSnapshots = rewindHistory.size();
+    snapshot.rewindBytes = rewindHistory.storedBytes();
+    snapshot.lasers = lasers.size();
+    snapshot.laserNodes = lasers.nodeCount();
+
+    snapshot.playfield.clear();
+    if (currentState != GameState::TITLE_SCREEN) {
+        recordPlayfield(snapshot.playfield);
+        // Otherwise drawn at the very end of the frame by renderLatchedPlayer()
+        if (!snapshot.latchPlayer) {
+            const FrameSnapshot::Player& p = snapshot.player;
+            recordPlayer(snapshot.playfield, p.x, p.y, p.dx, p.dy, p.focused, p.visible);
+        }
+    }
+    snapshot.publishedAt = FramePacer::now();
+}
+
+void Engine::acquireSnapshot() {
+    bool fresh = snapshots.acquire();
+    shown = &snapshots.front();
+    if (fresh) {
+        // Keys read for the ticks in it are waiting for this present
+        inputLatency.sampled(shown->inputSampledAt);
+    }
+
+    if (shown->game != shownGame) {
+        shownGame = shown->game;
+        shownTick = shown->tick;
+        runningFrames = 0;
+        inputLatency.discardPending();
+    } else if (shown->state == GameState::GAME_RUNNING) {
+        if (shown->tick == shownTick) {
+            framesDuplicated++;
+        } else if (shown->tick > shownTick + 1) {
+            ticksDropped += shown->tick - shownTick - 1;
+        }
+        shownTick = shown->tick;
+    }
+
+    if (!simThread.joinable()) {
+        renderAlpha = currentState == GameState::GAME_RUNNING
+            ? static_cast<float>(tickAccumulator / SIM_DT)
+            : 1.0f;
+    } else {
+        // The snapshot is a tick old by the time the next one lands; move
+        // through that tick as time passes since it was published
+        double since = FramePacer::toSeconds(FramePacer::now() - shown->publishedAt) / SIM_DT;
+        renderAlpha = shown->state == GameState::GAME_RUNNING
+            ? static_cast<float>(since < 1.0 ? since : 1.0)
+            : 1.0f;
+    }
+}
+
+bool Engine::lateLatching() const {
+    // Only while the playfield is drawn live and the keyboard is in charge
+    return shown && shown->latchPlayer;
+}
+
+void Engine::renderLatchedPlayer() {
+    PROFILE_SCOPE("lateLatch");
+    // Whatever arrived while the frame was being built
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {
+        processEvent(e);
+    }
+    Uint16 latched = actionMap.peek();
+    inputLatency.sampled();
+
+    // Where the next tick will put the player with these buttons, as far
+    // along as the other sprites are between their ticks. This runs a tick
+    // ahead of the interpolated bullets, which is the point: movement shows
+    // up on this present rather than after the next tick.
+    const FrameSnapshot::Player& p = shown->player;
+    float speed = static_cast<float>((latched & BUTTON_FOCUS) ? p.speed / 2 : p.speed);
+    float dx = static_cast<float>(((latched & BUTTON_RIGHT) ? 1 : 0) - ((latched & BUTTON_LEFT) ? 1 : 0));
+    float dy = static_cast<float>(((latched & BUTTON_DOWN) ? 1 : 0) - ((latched & BUTTON_UP) ? 1 : 0));
+    float x = p.x + dx * speed * renderAlpha;
+    float y = p.y + dy * speed * renderAlpha;
+
+    Playfield bounds = playfieldBounds();
+    float half = p.hurtboxSize * 0.5f;
+    x = std::min(std::max(x, bounds.left + half), bounds.right - half);
+    y = std::min(std::max(y, bounds.top + half), bounds.bottom - half);
+
+    latchedPlayer.clear();
+    recordPlayer(latchedPlayer, x, y, 0.0f, 0.0f, (latched & BUTTON_FOCUS) != 0, p.visible);
+    latchedPlayer.replay(spriteBatch, circles, text, 1.0f);
+}
+
+void Engine::recordPlayer(RenderCommandList& list, float x, float y, float dx, float dy, bool focused,
+                          bool visible) {
     int spriteWidth = 32;
     int spriteHeight = 64;
-    int hurtboxSize = 5;
     int yOffset = 12;  // positive moves hurtbox up inside sprite
     int xOffset = 2;
 
-    SDL_Rect dest = {
-        rectX + hurtboxSize / 2 - spriteWidth / 2 + xOffset,
-        rectY + hurtboxSize / 2 - spriteHeight / 2 + yOffset,
-        spriteWidth,
-        spriteHeight
+    SDL_FRect dest = {
+        x - spriteWidth / 2 + xOffset,
+        y - spriteHeight / 2 + yOffset,
+        static_cast<float>(spriteWidth),
+        static_cast<float>(spriteHeight)
     };
 
-    SDL_RenderCopy(renderer, playerTexture, NULL, &dest);
+    if (visible) {
+        list.sprite(playerSprite, dest, dx, dy, LAYER_PLAYER);
+    }
 
+    // Draw hurtbox as layered circles, only while focused (left shift)
+    if (focused) {
+        // Same layer, so submission order is kept: outer to inner
+        list.circle(x, y, dx, dy, 5, {0, 0, 139, 255}, LAYER_HURTBOX);    // Dark blue outer circle
+        list.circle(x, y, dx, dy, 3, {173, 216, 230, 255}, LAYER_HURTBOX); // Light blue middle circle
+        list.circle(x, y, dx, dy, 1, {255, 255, 255, 255}, LAYER_HURTBOX); // White center circle
+    }
+}
 
-    // Draw hurtbox for debugging (optional)
-    //SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-    //SDL_Rect hurtbox = { rectX, rectY, hurtboxSize, hurtboxSize };
-    //SDL_RenderFillRect(renderer, &hurtbox);
-    // Draw hurtbox as layered circles instead of red rectangle
-    // Draw hurtbox only if left shift is pressed
-    const Uint8* keystates = SDL_GetKeyboardState(NULL);
-    if (keystates[SDL_SCANCODE_LSHIFT]) {
-        int cx = rectX + hurtboxSize / 2;
-        int cy = rectY + hurtboxSize / 2;
+void Engine::recordBullets(RenderCommandList& list) {
+    PROFILE_SCOPE("recordBullets");
+    size_t count = bullets.size();
+    if (count == 0) return;
+
+    // Stepped back along the velocity at replay instead of keeping a
+    // previous-position copy
+    const float dt = static_cast<float>(SIM_DT);
+    RenderCommandList::CircleRun run = list.beginCircles(count, circles.circleSprite(1).blend, LAYER_BULLETS);
+    const float* bvx = bullets.velX();
+    const float* bvy = bullets.velY();
+    std::memcpy(run.x, bullets.posX(), count * sizeof(float));
+    std::memcpy(run.y, bullets.posY(), count * sizeof(float));
+    std::memcpy(run.radius, bullets.radii(), count * sizeof(float));
+    std::memcpy(run.color, bullets.colors(), count * sizeof(Uint32));
+    for (size_t i = 0; i < count; ++i) {
+        run.dx[i] = bvx[i] * dt;
+        run.dy[i] = bvy[i] * dt;
+    }
+}
 
-        drawFilledCircle(cx, cy, 5, {0, 0, 139, 255});    // Dark blue outer circle
-        drawFilledCircle(cx, cy, 3, {173, 216, 230, 255}); // Light blue middle circle
-        drawFilledCircle(cx, cy, 1, {255, 255, 255, 255}); // White center circle
+void Engine::recordLasers(RenderCommandList& list) {
+    PROFILE_SCOPE("recordLasers");
+    size_t count = lasers.size();
+    if (count == 0) return;
+
+    RenderCommandList::StripRun run = list.beginStrips(count, lasers.nodeCount(), circles.circleSprite(1).blend,
+                                                       LAYER_BULLETS);
+    float* x = run.x;
+    float* y = run.y;
+    for (size_t i = 0; i < count; ++i) {
+        LaserPool::Path path = lasers.path(i);
+        run.strips[i] = { static_cast<Uint32>(path.count), path.radius, path.color,
+                          path.headDx, path.headDy, path.tailDx, path.tailDy };
+        const size_t wrapped = path.count - path.firstCount;
+        std::memcpy(x, path.x, path.firstCount * sizeof(float));
+        std::memcpy(x + path.firstCount, path.wrapX, wrapped * sizeof(float));
+        std::memcpy(y, path.y, path.firstCount * sizeof(float));
+        std::memcpy(y + path.firstCount, path.wrapY, wrapped * sizeof(float));
+        x += path.count;
+        y += path.count;
+    }
+}
+
+void Engine::recordParticles(RenderCommandList& list) {
+    PROFILE_SCOPE("recordParticles");
+    size_t count = particles.size();
+    if (count == 0) return;
+
+    // Same circle atlas as the bullets, added rather than blended so
+    // overlapping sparks brighten and their order doesn't matter
+    const float dt = static_cast<float>(SIM_DT);
+    RenderCommandList::CircleRun run = list.beginCircles(count, SDL_BLENDMODE_ADD, LAYER_BULLETS);
+    const float* pvx = particles.velX();
+    const float* pvy = particles.velY();
+    std::memcpy(run.x, particles.posX(), count * sizeof(float));
+    std::memcpy(run.y, particles.posY(), count * sizeof(float));
+    std::memcpy(run.radius, particles.radii(), count * sizeof(float));
+    std::memcpy(run.color, particles.colors(), count * sizeof(Uint32));
+    for (size_t i = 0; i < count; ++i) {
+        run.dx[i] = pvx[i] * dt;
+        run.dy[i] = pvy[i] * dt;
     }
 }
 
 void Engine::renderTitleScreen() {
     // Optional: clear with different background color for title screen
-    SDL_SetRenderDrawColor(renderer, 30, 30, 60, 255);
-    SDL_RenderClear(renderer);
+    spriteBatch.backend().clear({ 30, 30, 60, 255 });
 
     SDL_Color white = { 255, 255, 255, 255 };
 
-    SDL_Texture* titleTexture = createTextTexture("My SDL2 Game", white);
-    SDL_Texture* startTexture = createTextTexture("Press Enter to Start", white);
-    SDL_Texture* exitTexture = createTextTexture("Press ESC to Quit", white);
-
-    if (titleTexture && startTexture && exitTexture) {
-        int tw, th, sw, sh, ew, eh;
-        SDL_QueryTexture(titleTexture, NULL, NULL, &tw, &th);
-        SDL_QueryTexture(startTexture, NULL, NULL, &sw, &sh);
-        SDL_QueryTexture(exitTexture, NULL, NULL, &ew, &eh);
-
-        SDL_Rect titleRect = { (width - tw) / 2, height / 4, tw, th };
-        SDL_Rect startRect = { (width - sw) / 2, height / 2, sw, sh };
-        SDL_Rect exitRect = { (width - ew) / 2, height / 2 + 40, ew, eh };
-
-        SDL_RenderCopy(renderer, titleTexture, NULL, &titleRect);
-        SDL_RenderCopy(renderer, startTexture, NULL, &startRect);
-        SDL_RenderCopy(renderer, exitTexture, NULL, &exitRect);
+    // Text shows up once the font has streamed in; the bar is drawn
+    // without it, so there's something from the very first frame
+    drawTextCentered("My SDL2 Game", width / 2, height / 4, white);
+    if (gameAssetsReady && text.ready()) {
+        drawTextCentered("Press Enter to Start", width / 2, height / 2, white);
+    } else {
+        const float barWidth = 200.0f;
+        const float barX = (width - barWidth) / 2.0f;
+        const float barY = height / 2.0f + 8.0f;
+        SDL_FRect track = { barX, barY, barWidth, 4.0f };
+        SDL_FRect fill = { barX, barY, barWidth * assets.progress().fraction(), 4.0f };
+        spriteBatch.drawRect(track, LAYER_HUD, { 80, 80, 120, 255 });
+        spriteBatch.drawRect(fill, LAYER_HUD, white);
     }
-
-    if (titleTexture) SDL_DestroyTexture(titleTexture);
-    if (startTexture) SDL_DestroyTexture(startTexture);
-    if (exitTexture) SDL_DestroyTexture(exitTexture);
+    drawTextCentered("Press ESC to Quit", width / 2, height / 2 + 40, white);
 }
 
 void Engine::renderPauseMenu() {
+    PROFILE_SCOPE("renderPauseMenu");
     // First, draw a semi-transparent black overlay to dim the screen
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 150);  // 150 alpha for dimming
-    SDL_Rect screenRect = { 0, 0, width, height };
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    SDL_RenderFillRect(renderer, &screenRect);
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);  // reset blend mode
+    SDL_FRect screenRect = { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height) };
+    spriteBatch.drawRect(screenRect, LAYER_OVERLAY, { 0, 0, 0, 150 }, SDL_BLENDMODE_BLEND); // 150 alpha for dimming
 
     // Draw "PAUSED" near top center
     SDL_Color white = { 255, 255, 255, 255 };
-    SDL_Texture* pausedText = createTextTexture("PAUSED", white);
-    if (pausedText) {
-        int textW, textH;
-        SDL_QueryTexture(pausedText, NULL, NULL, &textW, &textH);
-        SDL_Rect pausedRect = { (width - textW) / 2, height / 6, textW, textH };
-        SDL_RenderCopy(renderer, pausedText, NULL, &pausedRect);
-        SDL_DestroyTexture(pausedText);
-    }
+    drawTextCentered("PAUSED", width / 2, height / 6, white, LAYER_OVERLAY_UI);
 
     // Menu options
-    const char* options[2] = { "Title", "Continue" };
+    const char* options[PAUSE_OPTIONS] = { "Title", "Continue", "Restart" };
     int menuStartY = height / 2;
     int spacing = 40;
 
-    for (int i = 0; i < 2; ++i) {
-        SDL_Texture* optionText = createTextTexture(options[i], white);
-        if (optionText) {
-            int textW, textH;
-            SDL_QueryTexture(optionText, NULL, NULL, &textW, &textH);
-            SDL_Rect optionRect = { (width - textW) / 2 + 20, menuStartY + i * spacing, textW, textH };
-            SDL_RenderCopy(renderer, optionText, NULL, &optionRect);
-            SDL_DestroyTexture(optionText);
-        }
+    for (int i = 0; i < PAUSE_OPTIONS; ++i) {
+        drawTextCentered(options[i], width / 2 + 20, menuStartY + i * spacing, white, LAYER_OVERLAY_UI);
     }
 
     // Draw selector sprite to the left of selected option
-    if (selectorTexture) {
+    if (selectorSprite.texture) {
         int selectorWidth = 32;
         int selectorHeight = 32;
         int selectorX = (width -  /* average option text width */ 100) / 2 - selectorWidth - 10;
-        int selectorY = menuStartY + pauseMenuSelection * spacing + 4;  // slight vertical offset to center
-        SDL_Rect selectorRect = { selectorX, selectorY, selectorWidth, selectorHeight };
-        SDL_RenderCopy(renderer, selectorTexture, NULL, &selectorRect);
+        int selectorY = menuStartY + overlaySelection * spacing + 4;  // slight vertical offset to center
+        SDL_FRect selectorRect = {
+            static_cast<float>(selectorX), static_cast<float>(selectorY),
+            static_cast<float>(selectorWidth), static_cast<float>(selectorHeight)
+        };
+        spriteBatch.draw(selectorSprite, selectorRect, LAYER_OVERLAY_UI);
     } else {
         // fallback white rectangle if selectorTexture missing
         int selectorX = (width / 2) - 50;
-        int selectorY = menuStartY + pauseMenuSelection * spacing + 5;
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-        SDL_Rect selectorRect = { selectorX, selectorY, 20, 20 };
-        SDL_RenderFillRect(renderer, &selectorRect);
+        int selectorY = menuStartY + overlaySelection * spacing + 5;
+        SDL_FRect selectorRect = { static_cast<float>(selectorX), static_cast<float>(selectorY), 20.0f, 20.0f };
+        spriteBatch.drawRect(selectorRect, LAYER_OVERLAY_UI, white);
     }
 }
 
 
 
 void Engine::cleanup() {
-    if (fpsTexture) {
-        SDL_DestroyTexture(fpsTexture);
-        fpsTexture = nullptr;
-    }
-    if (playerTexture) {
-        SDL_DestroyTexture(playerTexture);
-        playerTexture = nullptr;
-    }
-    if (font) {
-        TTF_CloseFont(font);
-        font = nullptr;
-    }
-    if (bombTexture) {
-        SDL_DestroyTexture(bombTexture);
-        bombTexture = nullptr;
-    }
-    if (selectorTexture) {
-        SDL_DestroyTexture(selectorTexture);
-        selectorTexture = nullptr;
+    if (recordingActive) {
+        finishRecording();
     }
+    capture.stop();
+    compositor.cleanup();
+    text.cleanup();
+    circles.cleanup();
+    assetPack.destroyTextures();
+    assetPack.close();
+    fontAsset.reset();
+    for (AssetManager::Handle& handle : spriteAssets) handle.reset();
+    assets.stop();
+    spriteBatch.cleanup();
     if (renderer) SDL_DestroyRenderer(renderer);
     if (window) SDL_DestroyWindow(window);
-    SDL_DestroyTexture(heartTexture);
     TTF_Quit();
     SDL_Quit();
     IMG_Quit();
@@ -0,0 +1,177 @@
+#include "EntitySystems.h"
+#include "Profiler.h"
+
+namespace {
+
+constexpr float CULL_MARGIN = 40.0f;
+constexpr float SHOT_SPEED = 600.0f;
+constexpr float ITEM_FALL_SPEED = 60.0f;
+
+}
+
+EntitySystems::EntitySystems(const Playfield& bounds)
+    : bounds(bounds), enemyGrid(bounds, 32.0f, MAX_ENEMIES)
+{
+}
+
+Entity EntitySystems::spawnPlayer(World& world, float x, float y) {
+    PlayerState state = {};
+    state.speed = 4;
+    state.hurtboxSize = 5;
+    state.bombs = 5;
+    state.maxBombs = 5;
+    return world.create(Position{ x, y }, PrevPosition{ x, y }, Health{ 3, 5 }, state);
+}
+
+Entity EntitySystems::spawnEnemy(World& world, float x, float y, float vx, float vy, int hp) {
+    return world.create(Position{ x, y }, PrevPosition{ x, y }, Velocity{ vx, vy }, Collider{ 8.0f },
+                        Health{ hp, hp }, Enemy{ 100 }, Tint{ 0xE04040FFu });
+}
+
+Entity EntitySystems::spawnShot(World& world, float x, float y) {
+    return world.create(Position{ x, y }, PrevPosition{ x, y }, Velocity{ 0.0f, -SHOT_SPEED }, Collider{ 3.0f },
+                        Shot{ 1 }, Tint{ 0xA0FFA0FFu });
+}
+
+Entity EntitySystems::spawnItem(World& world, float x, float y, ItemKind kind) {
+    Uint32 color = kind == ITEM_BOMB ? 0x60C0FFFFu : 0xFFD040FFu;
+    return world.create(Position{ x, y }, PrevPosition{ x, y }, Velocity{ 0.0f, ITEM_FALL_SPEED },
+                        Collider{ 4.0f }, Item{ kind }, Tint{ color });
+}
+
+void EntitySystems::storePrevious(World& world) {
+    previousQuery.forEachChunk(world, [](size_t n, Entity*, Position* pos, PrevPosition* prev) {
+        for (size_t i = 0; i < n; ++i) {
+            prev[i].x = pos[i].x;
+            prev[i].y = pos[i].y;
+        }
+    });
+}
+
+void EntitySystems::update(World& world, Entity player, float dt, FrameArena& scratch) {
+    PROFILE_SCOPE("entities");
+    dropTotal = 0;
+    killTotal = 0;
+    integrate(world, dt);
+    expire(world, dt);
+    resolveShots(world, scratch);
+    collectItems(world, player);
+    world.flushDestroyed();
+
+    for (size_t i = 0; i < dropTotal; ++i) spawnItem(world, dropList[i].x, dropList[i].y, dropList[i].kind);
+}
+
+void EntitySystems::integrate(World& world, float dt) {
+    const float left = bounds.left - CULL_MARGIN;
+    const float right = bounds.right + CULL_MARGIN;
+    const float top = bounds.top - CULL_MARGIN;
+    const float bottom = bounds.bottom + CULL_MARGIN;
+
+    motionQuery.forEachChunk(world, [&](size_t n, Entity* entities, Position* pos, Velocity* vel) {
+        for (size_t i = 0; i < n; ++i) {
+            pos[i].x += vel[i].x * dt;
+            pos[i].y += vel[i].y * dt;
+        }
+        // Anything that moves is gone once it's well outside the field
+        for (size_t i = 0; i < n; ++i) {
+            if (pos[i].x < left || pos[i].x > right || pos[i].y < top || pos[i].y > bottom) {
+                world.destroyLater(entities[i]);
+            }
+        }
+    });
+}
+
+void EntitySystems::expire(World& world, float dt) {
+    lifetimeQuery.forEachChunk(world, [&](size_t n, Entity* entities, Lifetime* life) {
+        for (size_t i = 0; i < n; ++i) {
+            life[i].seconds -= dt;
+            if (life[i].seconds <= 0.0f) world.destroyLater(entities[i]);
+        }
+    });
+}
+
+void EntitySystems::resolveShots(World& world, FrameArena& scratch) {
+    size_t capacity = enemyQuery.count(world);
+    if (capacity == 0) return;
+    if (capacity > MAX_ENEMIES) capacity = MAX_ENEMIES;
+
+    float* enemyX = scratch.allocate<float>(capacity);
+    float* enemyY = scratch.allocate<float>(capacity);
+    float* enemyR = scratch.allocate<float>(capacity);
+    Entity* enemyHandles = scratch.allocate<Entity>(capacity);
+    Health** enemyHealth = scratch.allocate<Health*>(capacity); // valid until the next structural change
+    if (!enemyX || !enemyY || !enemyR || !enemyHandles || !enemyHealth) return;
+
+    size_t enemies = 0;
+    enemyQuery.forEachChunk(world, [&](size_t n, Entity* entities, Position* pos, Collider* col, Health* hp, Enemy*) {
+        for (size_t i = 0; i < n && enemies < capacity; ++i) {
+            enemyX[enemies] = pos[i].x;
+            enemyY[enemies] = pos[i].y;
+            enemyR[enemies] = col[i].radius;
+            enemyHandles[enemies] = entities[i];
+            enemyHealth[enemies] = &hp[i];
+            enemies++;
+        }
+    });
+    enemyGrid.build(enemyX, enemyY, enemyR, enemies);
+    dropList = scratch.allocate<Drop>(enemies);
+    killList = scratch.allocate<Kill>(enemies);
+    if (!dropList || !killList) return;
+
+    shotQuery.forEachChunk(world, [&](size_t n, Entity* entities, Position* pos, Collider* col, Shot* shot) {
+        for (size_t i = 0; i < n; ++i) {
+            enemyGrid.queryCircle(pos[i].x, pos[i].y, col[i].radius, [&](size_t e) {
+                Health& hp = *enemyHealth[e];
+                if (hp.hp <= 0) return true; // already killed this tick
+                hp.hp -= shot[i].damage;
+                if (hp.hp <= 0) {
+                    world.destroyLater(enemyHandles[e]);
+                    // Every eighth kill drops a bomb instead of points
+                    ItemKind kind = (enemyHandles[e].index & 7) == 0 ? ITEM_BOMB : ITEM_POINT;
+                    dropList[dropTotal++] = { enemyX[e], enemyY[e], kind };
+                    killList[killTotal++] = { enemyX[e], enemyY[e] };
+                }
+                world.destroyLater(entities[i]);
+                return false;
+            });
+        }
+    });
+}
+
+void EntitySystems::collectItems(World& world, Entity player) {
+    Position* playerPos = world.get<Position>(player);
+    PlayerState* state = world.get<PlayerState>(player);
+    if (!playerPos || !state) return;
+
+    const float px = playerPos->x;
+    const float py = playerPos->y;
+    const float rr = PICKUP_RADIUS * PICKUP_RADIUS;
+    itemQuery.forEachChunk(world, [&](size_t n, Entity* entities, Position* pos, Item* item) {
+        for (size_t i = 0; i < n; ++i) {
+            float dx = pos[i].x - px;
+            float dy = pos[i].y - py;
+            if (dx * dx + dy * dy > rr) continue;
+            state->itemsCollected++;
+            if (item[i].kind == ITEM_BOMB && state->bombs < state->maxBombs) state->bombs++;
+            world.destroyLater(entities[i]);
+        }
+    });
+}
+
+void EntitySystems::draw(World& world, RenderCommandList& list, Uint8 layer) {
+    PROFILE_SCOPE("recordEntities");
+    size_t count = drawQuery.count(world);
+    if (count == 0) return;
+    RenderCommandList::CircleRun run = list.beginCircles(count, SDL_BLENDMODE_BLEND, layer);
+    size_t k = 0;
+    drawQuery.forEachChunk(world, [&](size_t n, Entity*, Position* pos, PrevPosition* prev, Collider* col, Tint* tint) {
+        for (size_t i = 0; i < n; ++i, ++k) {
+            run.x[k] = pos[i].x;
+            run.y[k] = pos[i].y;
+            run.dx[k] = pos[i].x - prev[i].x;
+            run.dy[k] = pos[i].y - prev[i].y;
+            run.radius[k] = col[i].radius;
+            run.color[k] = tint[i].color;
+        }
+    });
+}
@@ -0,0 +1,284 @@
+#include "FrameCapture.h"
+#include <cstring>
+#include "FramePacer.h"
+
+namespace {
+
+// QOI (qoiformat.org): a 14-byte header, then one op per pixel or run of
+// pixels, then an 8-byte end marker
+constexpr Uint8 QOI_OP_INDEX = 0x00;
+constexpr Uint8 QOI_OP_DIFF = 0x40;
+constexpr Uint8 QOI_OP_LUMA = 0x80;
+constexpr Uint8 QOI_OP_RUN = 0xc0;
+constexpr Uint8 QOI_OP_RGB = 0xfe;
+constexpr Uint8 QOI_OP_RGBA = 0xff;
+constexpr size_t QOI_HEADER_SIZE = 14;
+constexpr Uint8 QOI_END[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+// Frames the overhead samples have room for before they grow
+constexpr size_t EXPECTED_FRAMES = 60 * 60 * 10;
+
+void writeBigEndian(Uint8* p, Uint32 v) {
+    p[0] = static_cast<Uint8>(v >> 24);
+    p[1] = static_cast<Uint8>(v >> 16);
+    p[2] = static_cast<Uint8>(v >> 8);
+    p[3] = static_cast<Uint8>(v);
+}
+
+}
+
+size_t FrameCapture::maxEncodedSize(int width, int height) {
+    // Worst case is QOI_OP_RGBA for every pixel
+    return static_cast<size_t>(width) * height * 5 + QOI_HEADER_SIZE + sizeof(QOI_END);
+}
+
+size_t FrameCapture::encodeQoi(const Uint32* pixels, int width, int height, Uint8* out) {
+    Uint8* p = out;
+    std::memcpy(p, "qoif", 4);
+    writeBigEndian(p + 4, static_cast<Uint32>(width));
+    writeBigEndian(p + 8, static_cast<Uint32>(height));
+    p[12] = 4; // RGBA
+    p[13] = 0; // sRGB with linear alpha
+    p += QOI_HEADER_SIZE;
+
+    // Pixels are RGBA32, i.e. r, g, b, a in memory order whatever the CPU
+    Uint8 seen[64][4] = {};
+    Uint8 prev[4] = { 0, 0, 0, 255 };
+    int run = 0;
+    const Uint8* px = reinterpret_cast<const Uint8*>(pixels);
+    const size_t total = static_cast<size_t>(width) * height;
+    for (size_t i = 0; i < total; ++i, px += 4) {
+        if (std::memcmp(px, prev, 4) == 0) {
+            run++;
+            if (run == 62 || i + 1 == total) {
+                *p++ = static_cast<Uint8>(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *p++ = static_cast<Uint8>(QOI_OP_RUN | (run - 1));
+            run = 0;
+        }
+
+        const int slot = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+        if (std::memcmp(seen[slot], px, 4) == 0) {
+            *p++ = static_cast<Uint8>(QOI_OP_INDEX | slot);
+        } else {
+            std::memcpy(seen[slot], px, 4);
+            if (px[3] == prev[3]) {
+                const int vr = static_cast<Sint8>(px[0] - prev[0]);
+                const int vg = static_cast<Sint8>(px[1] - prev[1]);
+                const int vb = static_cast<Sint8>(px[2] - prev[2]);
+                const int vgr = vr - vg;
+                const int vgb = vb - vg;
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                    *p++ = static_cast<Uint8>(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+                    *p++ = static_cast<Uint8>(QOI_OP_LUMA | (vg + 32));
+                    *p++ = static_cast<Uint8>((vgr + 8) << 4 | (vgb + 8));
+                } else {
+                    *p++ = QOI_OP_RGB;
+                    *p++ = px[0];
+                    *p++ = px[1];
+                    *p++ = px[2];
+                }
+            } else {
+                *p++ = QOI_OP_RGBA;
+                std::memcpy(p, px, 4);
+                p += 4;
+            }
+        }
+        std::memcpy(prev, px, 4);
+    }
+
+    std::memcpy(p, QOI_END, sizeof(QOI_END));
+    p += sizeof(QOI_END);
+    return static_cast<size_t>(p - out);
+}
+
+bool FrameCapture::start(const char* path, int width, int height, int buffers, int workerCount) {
+    stop();
+    if (width <= 0 || height <= 0 || buffers <= 0 || workerCount <= 0) return false;
+
+    file = std::fopen(path, "wb");
+    if (!file) {
+        SDL_Log("Could not open %s for the capture", path);
+        return false;
+    }
+    std::string indexPath = std::string(path) + ".csv";
+    index = std::fopen(indexPath.c_str(), "w");
+    if (!index) {
+        SDL_Log("Could not open %s for the capture index", indexPath.c_str());
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    std::fprintf(index, "image,frame,time_us\n");
+
+    this->path = path;
+    this->width = width;
+    this->height = height;
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    slots.assign(buffers, Slot());
+    freeSlots.clear();
+    for (int i = 0; i < buffers; ++i) {
+        slots[i].pixels.assign(pixelCount, 0);
+        freeSlots.push_back(i);
+    }
+    pending.assign(buffers, -1);
+    pendingHead = 0;
+    pendingCount = 0;
+    encoded.assign(workerCount, std::vector<Uint8>(maxEncodedSize(width, height)));
+
+    nextToWrite = 0;
+    writtenFrames = 0;
+    writtenBytes = 0;
+    stopping = false;
+    current = -1;
+    nextSequence = 0;
+    offered = 0;
+    dropped = 0;
+    overheadUs.clear();
+    overheadUs.reserve(EXPECTED_FRAMES);
+    startedAt = FramePacer::now();
+
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&FrameCapture::workerLoop, this, i);
+    }
+    SDL_Log("Capturing %dx%d frames to %s (%d buffers, %d encoder thread%s)", width, height, path, buffers,
+            workerCount, workerCount == 1 ? "" : "s");
+    return true;
+}
+
+void FrameCapture::stop() {
+    if (!active()) return;
+    if (current >= 0) endFrame(false);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    queued.notify_all();
+    for (std::thread& t : workers) t.join();
+    workers.clear();
+
+    std::fclose(file);
+    std::fclose(index);
+    file = nullptr;
+    index = nullptr;
+
+    Stats s = stats();
+    FrameTimings::Summary cost = overhead();
+    std::printf("Capture: %llu of %llu frames to %s (%llu dropped), %.1f MiB\n",
+                static_cast<unsigned long long>(s.written), static_cast<unsigned long long>(s.frames), path.c_str(),
+                static_cast<unsigned long long>(s.dropped), s.bytes / (1024.0 * 1024.0));
+    std::printf("Capture overhead per frame: mean %.1f us, p50 %.1f, p95 %.1f, p99 %.1f, max %.1f\n",
+                cost.meanUs, cost.p50Us, cost.p95Us, cost.p99Us, cost.maxUs);
+
+    // The memory goes with the capture
+    slots.clear();
+    slots.shrink_to_fit();
+    encoded.clear();
+    encoded.shrink_to_fit();
+}
+
+FrameCapture::Stats FrameCapture::stats() const {
+    Stats s;
+    s.frames = offered;
+    s.dropped = dropped;
+    s.lastOverheadUs = overheadUs.empty() ? 0.0f : overheadUs.back();
+    std::lock_guard<std::mutex> guard(lock);
+    s.written = writtenFrames;
+    s.bytes = writtenBytes;
+    return s;
+}
+
+Uint32* FrameCapture::beginFrame() {
+    if (!active()) return nullptr;
+    frameStart = FramePacer::now();
+    offered++;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!freeSlots.empty()) {
+            current = freeSlots.back();
+            freeSlots.pop_back();
+        }
+    }
+    if (current < 0) {
+        // Every buffer is still waiting on the workers; don't wait with them
+        dropped++;
+        finishFrame();
+        return nullptr;
+    }
+    return slots[current].pixels.data();
+}
+
+void FrameCapture::endFrame(bool ok) {
+    if (current < 0) return;
+    Slot& slot = slots[current];
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (ok) {
+            slot.sequence = nextSequence++;
+            slot.frame = offered - 1;
+            slot.timeUs = static_cast<Uint64>(FramePacer::toSeconds(frameStart - startedAt) * 1e6);
+            pending[(pendingHead + pendingCount) % pending.size()] = current;
+            pendingCount++;
+        } else {
+            freeSlots.push_back(current);
+        }
+    }
+    if (ok) {
+        queued.notify_one();
+    } else {
+        dropped++;
+    }
+    current = -1;
+    finishFrame();
+}
+
+void FrameCapture::finishFrame() {
+    static const double usPerTick = 1e6 / static_cast<double>(SDL_GetPerformanceFrequency());
+    overheadUs.push_back(static_cast<float>((FramePacer::now() - frameStart) * usPerTick));
+}
+
+void FrameCapture::workerLoop(int worker) {
+    Uint8* out = encoded[worker].data();
+    for (;;) {
+        int s;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            queued.wait(guard, [this] { return pendingCount > 0 || stopping; });
+            // Stopping still drains the queue first
+            if (pendingCount == 0) return;
+            s = pending[pendingHead];
+            pendingHead = (pendingHead + 1) % pending.size();
+            pendingCount--;
+        }
+
+        // Encoding is the slow part and runs alongside the other workers;
+        // only the write waits for the frames before this one
+        Slot& slot = slots[s];
+        const size_t size = encodeQoi(slot.pixels.data(), width, height, out);
+        const Uint64 sequence = slot.sequence;
+        const Uint64 frame = slot.frame;
+        const Uint64 timeUs = slot.timeUs;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            freeSlots.push_back(s);
+            written.wait(guard, [this, sequence] { return nextToWrite == sequence; });
+        }
+
+        // Only the worker holding the next sequence number gets here
+        std::fwrite(out, 1, size, file);
+        std::fprintf(index, "%llu,%llu,%llu\n", static_cast<unsigned long long>(sequence),
+                     static_cast<unsigned long long>(frame), static_cast<unsigned long long>(timeUs));
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            nextToWrite++;
+            writtenFrames++;
+            writtenBytes += size;
+        }
+        written.notify_all();
+    }
+}
@@ -0,0 +1,72 @@
+#include "FramePacer.h"
+#include <cmath>
+
+FramePacer::FramePacer()
+    : frequency(SDL_GetPerformanceFrequency())
+{
+    setMode(PacingMode::CAPPED, 60);
+    frameStart = now();
+    lastEnd = frameStart;
+}
+
+double FramePacer::toSeconds(Uint64 ticks) {
+    static const double invFrequency = 1.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    return static_cast<double>(ticks) * invFrequency;
+}
+
+void FramePacer::setMode(PacingMode mode, int targetHz) {
+    this->mode = mode;
+    this->targetHz = targetHz > 0 ? targetHz : 60;
+    targetTicks = frequency / static_cast<Uint64>(this->targetHz);
+    frameStart = now();
+}
+
+void FramePacer::sleepUntil(Uint64 deadline) {
+    // Sleep while we can afford the worst sleep we expect (mean + one std dev)
+    for (;;) {
+        Uint64 current = now();
+        if (current >= deadline) return;
+
+        double remaining = toSeconds(deadline - current);
+        double stddev = std::sqrt(sleepVariance);
+        if (remaining <= sleepMean + stddev) break;
+
+        Uint64 before = now();
+        SDL_Delay(1);
+        double observed = toSeconds(now() - before);
+
+        // Mean and variance decay by the same weight, so old sleeps fade out
+        // of both instead of piling up in the variance
+        if (sleepSamples < SLEEP_WINDOW) sleepSamples++;
+        double weight = 1.0 / static_cast<double>(sleepSamples);
+        double delta = observed - sleepMean;
+        sleepMean += weight * delta;
+        sleepVariance = (1.0 - weight) * (sleepVariance + weight * delta * delta);
+    }
+
+    // Spin out the last fraction of a millisecond
+    while (now() < deadline) {
+    }
+}
+
+double FramePacer::endFrame() {
+    if (mode == PacingMode::CAPPED) {
+        Uint64 deadline = frameStart + targetTicks;
+        Uint64 current = now();
+        if (current < deadline) {
+            sleepUntil(deadline);
+            frameStart = deadline;
+        } else if (current - deadline > targetTicks) {
+            // We fell more than a frame behind; don't try to catch up with
+            // a burst of unpaced frames, just restart the schedule from here
+            frameStart = current;
+        } else {
+            frameStart = deadline;
+        }
+    }
+
+    Uint64 end = now();
+    double elapsed = toSeconds(end - lastEnd);
+    lastEnd = end;
+    return elapsed;
+}
@@ -0,0 +1,104 @@
+#include "FrameTimings.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+void FrameTimings::reserve(size_t frames) {
+    for (std::vector<float>& s : samples) s.reserve(frames);
+}
+
+void FrameTimings::clear() {
+    for (std::vector<float>& s : samples) s.clear();
+}
+
+void FrameTimings::record(FrameStage stage, Uint64 startTicks, Uint64 endTicks) {
+    static const double usPerTick = 1e6 / static_cast<double>(SDL_GetPerformanceFrequency());
+    samples[stage].push_back(static_cast<float>((endTicks - startTicks) * usPerTick));
+}
+
+FrameTimings::Summary FrameTimings::summarize(FrameStage stage) const {
+    return summarizeSamples(samples[stage]);
+}
+
+FrameTimings::Summary FrameTimings::summarizeSamples(const std::vector<float>& values) {
+    Summary s;
+    if (values.empty()) return s;
+
+    std::vector<float> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for (float v : sorted) total += v;
+
+    // Nearest-rank percentiles
+    auto rank = [&](double p) {
+        size_t i = static_cast<size_t>(p * sorted.size());
+        if (i >= sorted.size()) i = sorted.size() - 1;
+        return static_cast<double>(sorted[i]);
+    };
+
+    s.frames = static_cast<int>(sorted.size());
+    s.meanUs = total / sorted.size();
+    s.p50Us = rank(0.50);
+    s.p95Us = rank(0.95);
+    s.p99Us = rank(0.99);
+    s.maxUs = sorted.back();
+    return s;
+}
+
+const char* FrameTimings::stageName(FrameStage stage) {
+    switch (stage) {
+    case STAGE_INPUT: return "input";
+    case STAGE_UPDATE: return "update";
+    case STAGE_RENDER: return "render";
+    case STAGE_CAPTURE: return "capture";
+    case STAGE_PRESENT: return "present";
+    case STAGE_FRAME: return "frame";
+    default: return "?";
+    }
+}
+
+void FrameTimings::print() const {
+    std::printf("%-8s %8s %10s %10s %10s %10s %10s\n", "stage", "frames", "mean us", "p50 us", "p95 us", "p99 us", "max us");
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        Summary s = summarize(static_cast<FrameStage>(i));
+        std::printf("%-8s %8d %10.1f %10.1f %10.1f %10.1f %10.1f\n", stageName(static_cast<FrameStage>(i)),
+                    s.frames, s.meanUs, s.p50Us, s.p95Us, s.p99Us, s.maxUs);
+    }
+    std::fflush(stdout);
+}
+
+bool FrameTimings::writeCsv(const char* path) const {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    std::fprintf(f, "stage,frames,mean_us,p50_us,p95_us,p99_us,max_us\n");
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        Summary s = summarize(static_cast<FrameStage>(i));
+        std::fprintf(f, "%s,%d,%.2f,%.2f,%.2f,%.2f,%.2f\n", stageName(static_cast<FrameStage>(i)),
+                     s.frames, s.meanUs, s.p50Us, s.p95Us, s.p99Us, s.maxUs);
+    }
+    std::fclose(f);
+    return true;
+}
+
+bool FrameTimings::writeJson(const char* path) const {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    std::fprintf(f, "{\n  \"stages\": [\n");
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        Summary s = summarize(static_cast<FrameStage>(i));
+        std::fprintf(f, "    {\"stage\": \"%s\", \"frames\": %d, \"mean_us\": %.2f, \"p50_us\": %.2f, "
+                        "\"p95_us\": %.2f, \"p99_us\": %.2f, \"max_us\": %.2f}%s\n",
+                     stageName(static_cast<FrameStage>(i)), s.frames, s.meanUs, s.p50Us, s.p95Us, s.p99Us, s.maxUs,
+                     i + 1 < STAGE_COUNT ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+    return true;
+}
+
+bool FrameTimings::write(const char* path) const {
+    size_t len = std::strlen(path);
+    if (len >= 4 && std::strcmp(path + len - 4, ".csv") == 0) return writeCsv(path);
+    return writeJson(path);
+}
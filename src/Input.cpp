@@ -0,0 +1,125 @@
+#include "Input.h"
+#include <cstdio>
+#include <cstring>
+
+ActionMap::ActionMap() {
+    std::memset(bindings, 0, sizeof(bindings));
+    std::memset(keyDown, 0, sizeof(keyDown));
+
+    bind(SDL_SCANCODE_W, BUTTON_UP);
+    bind(SDL_SCANCODE_UP, BUTTON_UP);
+    bind(SDL_SCANCODE_S, BUTTON_DOWN);
+    bind(SDL_SCANCODE_DOWN, BUTTON_DOWN);
+    bind(SDL_SCANCODE_A, BUTTON_LEFT);
+    bind(SDL_SCANCODE_LEFT, BUTTON_LEFT);
+    bind(SDL_SCANCODE_D, BUTTON_RIGHT);
+    bind(SDL_SCANCODE_RIGHT, BUTTON_RIGHT);
+    bind(SDL_SCANCODE_LSHIFT, BUTTON_FOCUS);
+    bind(SDL_SCANCODE_Z, BUTTON_SHOOT);
+    bind(SDL_SCANCODE_X, BUTTON_BOMB);
+    bind(SDL_SCANCODE_ESCAPE, BUTTON_PAUSE);
+}
+
+void ActionMap::bind(SDL_Scancode key, Uint16 buttons) {
+    if (key > SDL_SCANCODE_UNKNOWN && key < SDL_NUM_SCANCODES) bindings[key] = buttons;
+}
+
+bool ActionMap::handleEvent(const SDL_Event& e) {
+    if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_FOCUS_LOST) {
+        // Key-ups go to whoever has focus now; don't leave buttons stuck
+        releaseAll();
+        return false;
+    }
+    if (e.type != SDL_KEYDOWN && e.type != SDL_KEYUP) return false;
+    if (e.key.repeat) return false;
+
+    const SDL_Scancode key = e.key.keysym.scancode;
+    if (key <= SDL_SCANCODE_UNKNOWN || key >= SDL_NUM_SCANCODES || !bindings[key]) return false;
+
+    const bool down = e.type == SDL_KEYDOWN;
+    if (keyDown[key] == down) return false;
+    keyDown[key] = down;
+
+    // Count keys per button, so letting go of A doesn't cancel a held Left
+    const Uint16 buttons = bindings[key];
+    for (int bit = 0; bit < BUTTON_BITS; ++bit) {
+        const Uint16 mask = static_cast<Uint16>(1u << bit);
+        if (!(buttons & mask)) continue;
+        if (down) {
+            if (holdCount[bit]++ == 0) {
+                held.fetch_or(mask, std::memory_order_relaxed);
+                tapped.fetch_or(mask, std::memory_order_relaxed);
+            }
+        } else if (holdCount[bit] > 0 && --holdCount[bit] == 0) {
+            held.fetch_and(static_cast<Uint16>(~mask), std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+void ActionMap::releaseAll() {
+    std::memset(keyDown, 0, sizeof(keyDown));
+    std::memset(holdCount, 0, sizeof(holdCount));
+    held.store(0, std::memory_order_relaxed);
+}
+
+Uint16 ActionMap::sample() {
+    // Taken in one exchange, so a tap landing meanwhile waits for the next sample
+    Uint16 buttons = tapped.exchange(0, std::memory_order_relaxed);
+    return buttons | held.load(std::memory_order_relaxed);
+}
+
+InputLatency::InputLatency() {
+    pending.reserve(64);
+    awaitingPresent.reserve(64);
+    samples.reserve(4096);
+}
+
+void InputLatency::keyEvent(Uint32 eventTimestamp) {
+    Uint32 now = SDL_GetTicks();
+    Event e;
+    e.ageUs = now >= eventTimestamp ? (now - eventTimestamp) * 1000.0f : 0.0f;
+    e.polledAt = SDL_GetPerformanceCounter();
+    pending.push_back(e);
+}
+
+void InputLatency::sampled() {
+    awaitingPresent.insert(awaitingPresent.end(), pending.begin(), pending.end());
+    pending.clear();
+}
+
+void InputLatency::sampled(Uint64 upTo) {
+    size_t kept = 0;
+    for (const Event& e : pending) {
+        if (e.polledAt <= upTo) {
+            awaitingPresent.push_back(e);
+        } else {
+            pending[kept++] = e;
+        }
+    }
+    pending.resize(kept);
+}
+
+void InputLatency::presented() {
+    if (awaitingPresent.empty()) return;
+    static const double usPerTick = 1e6 / static_cast<double>(SDL_GetPerformanceFrequency());
+    Uint64 now = SDL_GetPerformanceCounter();
+    for (const Event& e : awaitingPresent) {
+        samples.push_back(e.ageUs + static_cast<float>((now - e.polledAt) * usPerTick));
+    }
+    awaitingPresent.clear();
+}
+
+void InputLatency::clear() {
+    pending.clear();
+    awaitingPresent.clear();
+    samples.clear();
+}
+
+void InputLatency::print() const {
+    FrameTimings::Summary s = summarize();
+    if (s.frames == 0) return;
+    std::printf("input-to-present latency over %d key events: mean %.2f ms, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f\n",
+                s.frames, s.meanUs / 1000.0, s.p50Us / 1000.0, s.p95Us / 1000.0, s.p99Us / 1000.0, s.maxUs / 1000.0);
+    std::fflush(stdout);
+}
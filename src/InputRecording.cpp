@@ -0,0 +1,106 @@
+#include "InputRecording.h"
+#include <cstdio>
+
+void InputRecording::clear() {
+    bytes.clear();
+    ticks = 0;
+    lastMask = 0;
+    openMask = 0;
+    openLength = 0;
+    scenarioId = 0;
+    stageHash = 0;
+    finalHash = 0;
+}
+
+void InputRecording::writeVarint(Uint32 v) {
+    while (v >= 0x80) {
+        bytes.push_back(static_cast<Uint8>(v | 0x80));
+        v >>= 7;
+    }
+    bytes.push_back(static_cast<Uint8>(v));
+}
+
+void InputRecording::push(Uint16 buttons) {
+    if (openLength > 0 && buttons != openMask) finish();
+    openMask = buttons;
+    openLength++;
+    ticks++;
+}
+
+void InputRecording::finish() {
+    if (openLength == 0) return;
+    writeVarint(openLength);
+    writeVarint(static_cast<Uint32>(openMask ^ lastMask));
+    lastMask = openMask;
+    openLength = 0;
+}
+
+Uint16 InputRecording::Reader::next() {
+    if (done()) return 0;
+    const std::vector<Uint8>& b = recording->bytes;
+    auto readVarint = [&]() {
+        Uint32 v = 0;
+        int shift = 0;
+        while (offset < b.size()) {
+            Uint8 byte = b[offset++];
+            v |= static_cast<Uint32>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+            shift += 7;
+        }
+        return v;
+    };
+    if (runLeft == 0) {
+        runLeft = readVarint();
+        mask ^= static_cast<Uint16>(readVarint());
+    }
+    runLeft--;
+    tick++;
+    return mask;
+}
+
+bool InputRecording::save(const char* path) const {
+    if (openLength > 0) {
+        // Not finished; finish a copy rather than changing what we're saving
+        InputRecording copy = *this;
+        copy.finish();
+        return copy.save(path);
+    }
+
+    FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    RecordingHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.scenarioId = scenarioId;
+    header.stageHash = stageHash;
+    header.tickCount = ticks;
+    header.finalHash = finalHash;
+    header.byteCount = static_cast<Uint32>(bytes.size());
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              (bytes.empty() || std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size());
+    std::fclose(f);
+    return ok;
+}
+
+bool InputRecording::load(const char* path) {
+    clear();
+    FILE* f = std::fopen(path, "rb");
+    if (!f) return false;
+    RecordingHeader header;
+    bool ok = std::fread(&header, sizeof(header), 1, f) == 1 &&
+              header.magic == MAGIC && header.version == VERSION;
+    if (ok) {
+        bytes.resize(header.byteCount);
+        ok = header.byteCount == 0 || std::fread(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    }
+    std::fclose(f);
+    if (!ok) {
+        clear();
+        return false;
+    }
+    scenarioId = header.scenarioId;
+    stageHash = header.stageHash;
+    ticks = header.tickCount;
+    finalHash = header.finalHash;
+    return true;
+}
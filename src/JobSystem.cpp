@@ -0,0 +1,200 @@
+#include "JobSystem.h"
+
+namespace {
+// Which deque the calling thread owns: workers get 1..N, the thread that
+// drives the simulation uses 0
+thread_local int threadDeque = 0;
+}
+
+// The fences follow Le, Pop, Cohen & Zappa Nardelli, "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (PPoPP 2013). Slots are also stored
+// with release and loaded with acquire, which costs nothing on x86 and lets
+// thread sanitizers see that a stolen job's fields were written first.
+bool WorkStealingDeque::push(Job* job) {
+    Sint64 b = bottom.load(std::memory_order_relaxed);
+    Sint64 t = top.load(std::memory_order_acquire);
+    if (b - t >= static_cast<Sint64>(CAPACITY)) return false;
+    items[b & (CAPACITY - 1)].store(job, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+Job* WorkStealingDeque::pop() {
+    Sint64 b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Sint64 t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Job* job = items[b & (CAPACITY - 1)].load(std::memory_order_acquire);
+    if (t == b) {
+        // Last item: race any thief for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* WorkStealingDeque::steal() {
+    Sint64 t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Sint64 b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+
+    Job* job = items[t & (CAPACITY - 1)].load(std::memory_order_acquire);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystem::~JobSystem() {
+    stop();
+}
+
+void JobSystem::start(int threads) {
+    stop();
+    if (threads < 1) threads = 1;
+
+    deques.clear();
+    for (int i = 0; i < threads; ++i) deques.push_back(std::make_unique<WorkStealingDeque>());
+    stopping = false;
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+void JobSystem::stop() {
+    if (workers.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) t.join();
+    workers.clear();
+}
+
+void JobSystem::execute(Job& job) {
+    job.run(job);
+    job.counter->fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::submit(Job& job) {
+    if (workers.empty() || !deques[threadDeque]->push(&job)) {
+        // No pool, or our deque is full: just do it now
+        execute(job);
+        return;
+    }
+    workEpoch.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_seq_cst) > 0) {
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wake.notify_all();
+    }
+}
+
+Job* JobSystem::findJob(int self, Uint32& rng) {
+    if (deques.empty()) return nullptr;
+    if (Job* job = deques[self]->pop()) return job;
+
+    // Start stealing at a random victim so thieves spread out
+    const int n = static_cast<int>(deques.size());
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    int start = static_cast<int>(rng % static_cast<Uint32>(n));
+    for (int i = 0; i < n; ++i) {
+        int victim = (start + i) % n;
+        if (victim == self) continue;
+        if (Job* job = deques[victim]->steal()) return job;
+    }
+    return nullptr;
+}
+
+void JobSystem::wait(const std::atomic<int>& counter) {
+    Uint32 rng = 0x9E3779B9u ^ static_cast<Uint32>(threadDeque);
+    while (counter.load(std::memory_order_acquire) > 0) {
+        if (Job* job = findJob(threadDeque, rng)) {
+            execute(*job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::workerLoop(int index) {
+    threadDeque = index;
+    Uint32 rng = 0x9E3779B9u * static_cast<Uint32>(index + 1);
+
+    while (!stopping.load(std::memory_order_acquire)) {
+        Uint64 seen = workEpoch.load(std::memory_order_seq_cst);
+
+        // Spin a little before sleeping; ticks submit in bursts
+        Job* job = nullptr;
+        for (int spin = 0; spin < 64 && !job; ++spin) {
+            job = findJob(index, rng);
+            if (!job) std::this_thread::yield();
+        }
+        if (job) {
+            execute(*job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        wake.wait(lock, [&] {
+            return stopping.load(std::memory_order_relaxed) || workEpoch.load(std::memory_order_seq_cst) != seen;
+        });
+        sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+int TaskGraph::add(const char* name, std::function<void()> fn, std::initializer_list<int> deps) {
+    int id = static_cast<int>(tasks.size());
+    tasks.push_back(std::make_unique<Task>());
+    Task& task = *tasks.back();
+    task.name = name;
+    task.fn = std::move(fn);
+    task.dependencyCount = static_cast<int>(deps.size());
+    for (int dep : deps) tasks[dep]->successors.push_back(id);
+
+    task.job.context = this;
+    task.job.begin = static_cast<size_t>(id);
+    task.job.counter = &remaining;
+    task.job.run = &TaskGraph::runTask;
+    return id;
+}
+
+void TaskGraph::runTask(Job& job) {
+    TaskGraph& graph = *static_cast<TaskGraph*>(job.context);
+    Task& task = *graph.tasks[job.begin];
+    {
+        PROFILE_SCOPE(task.name);
+        task.fn();
+    }
+    // Release whatever was only waiting on us
+    for (int next : task.successors) {
+        Task& successor = *graph.tasks[next];
+        if (successor.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            graph.activeJobs->submit(successor.job);
+        }
+    }
+}
+
+void TaskGraph::run(JobSystem& jobs) {
+    activeJobs = &jobs;
+    remaining.store(static_cast<int>(tasks.size()), std::memory_order_relaxed);
+    for (std::unique_ptr<Task>& task : tasks) {
+        task->pending.store(task->dependencyCount, std::memory_order_relaxed);
+    }
+    for (std::unique_ptr<Task>& task : tasks) {
+        if (task->dependencyCount == 0) jobs.submit(task->job);
+    }
+    jobs.wait(remaining);
+}
@@ -0,0 +1,301 @@
+#include "LaserPool.h"
+#include <algorithm>
+#include <cmath>
+#include "StateSnapshot.h"
+
+namespace {
+
+constexpr size_t NODE_MASK = LaserPool::NODES_PER_LASER - 1;
+static_assert((LaserPool::NODES_PER_LASER & NODE_MASK) == 0, "ring indices wrap with a mask");
+
+float clamp01(float v) {
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+// Closest approach of segments p1-q1 and p2-q2, squared (Ericson, Real-Time
+// Collision Detection 5.1.9). Either one may be a single point.
+float segmentDistanceSquared(float p1x, float p1y, float q1x, float q1y,
+                             float p2x, float p2y, float q2x, float q2y) {
+    const float d1x = q1x - p1x, d1y = q1y - p1y;
+    const float d2x = q2x - p2x, d2y = q2y - p2y;
+    const float rx = p1x - p2x, ry = p1y - p2y;
+    const float a = d1x * d1x + d1y * d1y;
+    const float e = d2x * d2x + d2y * d2y;
+    const float f = d2x * rx + d2y * ry;
+    const float eps = 1.0e-6f;
+
+    float s = 0.0f;
+    float t = 0.0f;
+    if (a <= eps && e <= eps) {
+        return rx * rx + ry * ry;
+    }
+    if (a <= eps) {
+        t = clamp01(f / e);
+    } else {
+        const float c = d1x * rx + d1y * ry;
+        if (e <= eps) {
+            s = clamp01(-c / a);
+        } else {
+            const float b = d1x * d2x + d1y * d2y;
+            const float denom = a * e - b * b;
+            s = denom > 0.0f ? clamp01((b * f - c * e) / denom) : 0.0f;
+            t = (b * s + f) / e;
+            if (t < 0.0f) {
+                t = 0.0f;
+                s = clamp01(-c / a);
+            } else if (t > 1.0f) {
+                t = 1.0f;
+                s = clamp01((b - c) / a);
+            }
+        }
+    }
+    const float dx = (p1x + d1x * s) - (p2x + d2x * t);
+    const float dy = (p1y + d1y * s) - (p2y + d2y * t);
+    return dx * dx + dy * dy;
+}
+
+}
+
+LaserPool::LaserPool(size_t capacity) : maxLasers(capacity) {
+    lasers.reserve(capacity);
+    nodeX.assign(capacity * NODES_PER_LASER, 0.0f);
+    nodeY.assign(capacity * NODES_PER_LASER, 0.0f);
+    freeBlocks.reserve(capacity);
+    clear();
+}
+
+void LaserPool::clear() {
+    lasers.clear();
+    // Handed out from the back, lowest block first
+    freeBlocks.clear();
+    for (size_t i = maxLasers; i > 0; --i) freeBlocks.push_back(static_cast<Uint32>(i - 1));
+}
+
+bool LaserPool::spawn(const LaserSpawn& s) {
+    if (freeBlocks.empty()) return false;
+
+    Laser l = {};
+    l.x = s.x;
+    l.y = s.y;
+    l.speed = s.speed;
+    l.angle = s.angle;
+    l.angularVel = s.angularVel;
+    l.life = s.lifetime;
+    l.radius = s.radius;
+    l.color = s.color;
+    l.block = freeBlocks.back();
+    l.count = 1;
+    l.length = static_cast<Uint16>(std::min<Uint32>(std::max<Uint32>(s.length, 2), NODES_PER_LASER));
+    l.emitting = 1;
+    l.minX = l.maxX = s.x;
+    l.minY = l.maxY = s.y;
+    freeBlocks.pop_back();
+
+    nodeX[l.block * NODES_PER_LASER] = s.x;
+    nodeY[l.block * NODES_PER_LASER] = s.y;
+    lasers.push_back(l);
+    return true;
+}
+
+size_t LaserPool::nodeCount() const {
+    size_t n = 0;
+    for (const Laser& l : lasers) n += l.count;
+    return n;
+}
+
+void LaserPool::update(float dt, const Playfield& bounds) {
+    for (size_t i = 0; i < lasers.size();) {
+        Laser& l = lasers[i];
+        if ((l.flags & FLAG_DEAD) || (!l.emitting && l.count <= 1)) {
+            // Swap-removed; its block goes straight back to the pool
+            freeBlocks.push_back(l.block);
+            l = lasers.back();
+            lasers.pop_back();
+            continue;
+        }
+
+        float* x = &nodeX[l.block * NODES_PER_LASER];
+        float* y = &nodeY[l.block * NODES_PER_LASER];
+        l.headDx = l.headDy = 0.0f;
+        l.tailDx = l.tailDy = 0.0f;
+
+        // Tail first: a full laser drops its oldest node to make room, a
+        // stopped one drops one per tick until it's gone
+        if (!l.emitting || l.count == l.length) {
+            size_t tail = l.first;
+            size_t next = (tail + 1) & NODE_MASK;
+            if (l.count > 1) {
+                l.tailDx = x[next] - x[tail];
+                l.tailDy = y[next] - y[tail];
+            }
+            l.first = static_cast<Uint16>(next);
+            l.count--;
+        }
+
+        if (l.emitting) {
+            l.angle += l.angularVel * dt;
+            l.headDx = std::cos(l.angle) * l.speed * dt;
+            l.headDy = std::sin(l.angle) * l.speed * dt;
+            l.x += l.headDx;
+            l.y += l.headDy;
+            l.life -= dt;
+
+            size_t head = (l.first + l.count) & NODE_MASK;
+            x[head] = l.x;
+            y[head] = l.y;
+            l.count++;
+
+            // Past the edge by its own width nothing more of it would show
+            if (l.life <= 0.0f || l.x < bounds.left - l.radius || l.x > bounds.right + l.radius ||
+                l.y < bounds.top - l.radius || l.y > bounds.bottom + l.radius) {
+                l.emitting = 0;
+            }
+        }
+
+        updateBounds(l);
+        ++i;
+    }
+}
+
+void LaserPool::updateBounds(Laser& l) {
+    if (l.count == 0) return;
+    const float* x = &nodeX[l.block * NODES_PER_LASER];
+    const float* y = &nodeY[l.block * NODES_PER_LASER];
+    float minX = x[l.first], maxX = minX;
+    float minY = y[l.first], maxY = minY;
+    for (size_t k = 1; k < l.count; ++k) {
+        size_t n = (l.first + k) & NODE_MASK;
+        minX = std::min(minX, x[n]);
+        maxX = std::max(maxX, x[n]);
+        minY = std::min(minY, y[n]);
+        maxY = std::max(maxY, y[n]);
+    }
+    l.minX = minX;
+    l.minY = minY;
+    l.maxX = maxX;
+    l.maxY = maxY;
+}
+
+float LaserPool::distanceSquared(const Laser& l, float x0, float y0, float x1, float y1) const {
+    const float* x = &nodeX[l.block * NODES_PER_LASER];
+    const float* y = &nodeY[l.block * NODES_PER_LASER];
+    size_t a = l.first;
+    if (l.count == 1) return segmentDistanceSquared(x0, y0, x1, y1, x[a], y[a], x[a], y[a]);
+
+    float best = 3.4e38f;
+    for (size_t k = 1; k < l.count; ++k) {
+        size_t b = (l.first + k) & NODE_MASK;
+        best = std::min(best, segmentDistanceSquared(x0, y0, x1, y1, x[a], y[a], x[b], y[b]));
+        a = b;
+    }
+    return best;
+}
+
+bool LaserPool::hits(float x0, float y0, float x1, float y1, float radius) const {
+    const float minX = std::min(x0, x1), maxX = std::max(x0, x1);
+    const float minY = std::min(y0, y1), maxY = std::max(y0, y1);
+    for (const Laser& l : lasers) {
+        if (l.flags & FLAG_DEAD) continue;
+        const float reach = radius + l.radius;
+        if (!boundsOverlap(l, minX, minY, maxX, maxY, reach)) continue;
+        if (distanceSquared(l, x0, y0, x1, y1) < reach * reach) return true;
+    }
+    return false;
+}
+
+size_t LaserPool::graze(float x0, float y0, float x1, float y1, float radius) {
+    const float minX = std::min(x0, x1), maxX = std::max(x0, x1);
+    const float minY = std::min(y0, y1), maxY = std::max(y0, y1);
+    size_t grazed = 0;
+    for (Laser& l : lasers) {
+        if (l.flags & (FLAG_GRAZED | FLAG_DEAD)) continue;
+        const float reach = radius + l.radius;
+        if (!boundsOverlap(l, minX, minY, maxX, maxY, reach)) continue;
+        if (distanceSquared(l, x0, y0, x1, y1) < reach * reach) {
+            l.flags |= FLAG_GRAZED;
+            grazed++;
+        }
+    }
+    return grazed;
+}
+
+size_t LaserPool::killInRadius(float cx, float cy, float radius) {
+    size_t killed = 0;
+    for (Laser& l : lasers) {
+        if (l.flags & FLAG_DEAD) continue;
+        const float reach = radius + l.radius;
+        if (!boundsOverlap(l, cx, cy, cx, cy, reach)) continue;
+        const float* x = &nodeX[l.block * NODES_PER_LASER];
+        const float* y = &nodeY[l.block * NODES_PER_LASER];
+        for (size_t k = 0; k < l.count; ++k) {
+            size_t n = (l.first + k) & NODE_MASK;
+            float dx = x[n] - cx;
+            float dy = y[n] - cy;
+            if (dx * dx + dy * dy <= reach * reach) {
+                l.flags |= FLAG_DEAD;
+                killed++;
+                break;
+            }
+        }
+    }
+    return killed;
+}
+
+LaserPool::Path LaserPool::path(size_t i) const {
+    const Laser& l = lasers[i];
+    const size_t base = l.block * NODES_PER_LASER;
+    Path p;
+    p.x = &nodeX[base + l.first];
+    p.y = &nodeY[base + l.first];
+    p.firstCount = std::min<size_t>(l.count, NODES_PER_LASER - l.first);
+    p.wrapX = &nodeX[base];
+    p.wrapY = &nodeY[base];
+    p.count = l.count;
+    p.radius = l.radius;
+    p.color = l.color;
+    p.headDx = l.headDx;
+    p.headDy = l.headDy;
+    p.tailDx = l.tailDx;
+    p.tailDy = l.tailDy;
+    return p;
+}
+
+void LaserPool::saveState(StateWriter& out) const {
+    out.value(lasers.size());
+    out.array(lasers.data(), lasers.size());
+    out.value(freeBlocks.size());
+    out.array(freeBlocks.data(), freeBlocks.size());
+    // Only the live part of each ring, tail to head
+    for (size_t i = 0; i < lasers.size(); ++i) {
+        Path p = path(i);
+        out.array(p.x, p.firstCount);
+        out.array(p.wrapX, p.count - p.firstCount);
+        out.array(p.y, p.firstCount);
+        out.array(p.wrapY, p.count - p.firstCount);
+    }
+}
+
+bool LaserPool::loadState(StateReader& in) {
+    size_t n = 0;
+    size_t freeCount = 0;
+    // Within the reserved capacity, so this never allocates
+    if (!in.value(n) || n > maxLasers) return false;
+    lasers.resize(n);
+    if (!in.array(lasers.data(), n)) return false;
+    if (!in.value(freeCount) || freeCount + n != maxLasers) return false;
+    freeBlocks.resize(freeCount);
+    if (!in.array(freeBlocks.data(), freeCount)) return false;
+
+    for (const Laser& l : lasers) {
+        if (l.block >= maxLasers || l.count > NODES_PER_LASER || l.first > NODE_MASK) return false;
+    }
+    for (const Laser& l : lasers) {
+        const size_t base = l.block * NODES_PER_LASER;
+        const size_t firstCount = std::min<size_t>(l.count, NODES_PER_LASER - l.first);
+        in.array(&nodeX[base + l.first], firstCount);
+        in.array(&nodeX[base], l.count - firstCount);
+        in.array(&nodeY[base + l.first], firstCount);
+        in.array(&nodeY[base], l.count - firstCount);
+    }
+    return in.ok();
+}
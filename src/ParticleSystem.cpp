@@ -0,0 +1,362 @@
+#include "ParticleSystem.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include "JobSystem.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PARTICLE_KERNEL_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLE_KERNEL_SSE2 1
+#endif
+
+namespace {
+
+constexpr size_t LANES = 8;
+constexpr size_t ALIGNMENT = 64;
+constexpr float TWO_PI = 6.28318530718f;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+#if defined(PARTICLE_KERNEL_AVX2) || defined(PARTICLE_KERNEL_SSE2)
+// Four packed colors at once, each byte a*(256-t) + b*t >> 8 with t in
+// 0..256. Both weights add up to 256, so every product and sum fits an
+// unsigned 16-bit lane.
+__m128i lerpColors(__m128i a, __m128i b, __m128i t) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(256);
+    __m128i t16 = _mm_packs_epi32(t, t);          // t0 t1 t2 t3 t0 t1 t2 t3
+    __m128i pairs = _mm_unpacklo_epi16(t16, t16); // t0 t0 t1 t1 t2 t2 t3 t3
+    __m128i t01 = _mm_unpacklo_epi32(pairs, pairs); // t0 x4, t1 x4: one per byte
+    __m128i t23 = _mm_unpackhi_epi32(pairs, pairs);
+
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_sub_epi16(full, t01)),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), t01));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_sub_epi16(full, t23)),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), t23));
+    return _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+}
+#endif
+
+Uint32 lerpColor(Uint32 a, Uint32 b, Uint32 t) {
+    Uint32 result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        Uint32 ca = (a >> shift) & 0xFF;
+        Uint32 cb = (b >> shift) & 0xFF;
+        result |= (((ca * (256 - t) + cb * t) >> 8) & 0xFF) << shift;
+    }
+    return result;
+}
+
+}
+
+ParticleSystem::ParticleSystem(size_t capacity)
+    : maxParticles(capacity), paddedCapacity(alignUp(capacity > 0 ? capacity : 1, LANES))
+{
+    const size_t floatBytes = alignUp(paddedCapacity * sizeof(float), ALIGNMENT);
+    const size_t colorBytes = alignUp(paddedCapacity * sizeof(Uint32), ALIGNMENT);
+    const size_t maskBytes = alignUp(paddedCapacity / 8, ALIGNMENT);
+    const size_t total = floatBytes * 11 + colorBytes * 3 + maskBytes;
+
+    block = SDL_SIMDAlloc(total);
+    if (!block) {
+        SDL_Log("ParticleSystem: failed to allocate %u bytes for %u particles",
+                static_cast<unsigned>(total), static_cast<unsigned>(capacity));
+        maxParticles = 0;
+        return;
+    }
+    // Zero so the padding lanes past count never hold NaNs or denormals
+    std::memset(block, 0, total);
+
+    Uint8* p = static_cast<Uint8*>(block);
+    float** floatArrays[] = { &x, &y, &vx, &vy, &gravity, &drag, &life, &invLifetime,
+                              &radiusStart, &radiusEnd, &radius };
+    for (float** arr : floatArrays) {
+        *arr = reinterpret_cast<float*>(p);
+        p += floatBytes;
+    }
+    Uint32** colorArrays[] = { &colorStart, &colorEnd, &color };
+    for (Uint32** arr : colorArrays) {
+        *arr = reinterpret_cast<Uint32*>(p);
+        p += colorBytes;
+    }
+    deadMask = p;
+}
+
+ParticleSystem::~ParticleSystem() {
+    if (block) SDL_SIMDFree(block);
+}
+
+float ParticleSystem::random01() {
+    // xorshift32; only has to look random
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (rng >> 8) * (1.0f / 16777216.0f);
+}
+
+bool ParticleSystem::emit(size_t& index, const ParticlePreset& preset) {
+    if (count >= maxParticles) {
+        dropped++;
+        return false;
+    }
+    size_t i = count++;
+    float lifetime = preset.lifeMin + (preset.lifeMax - preset.lifeMin) * random01();
+    if (lifetime < 0.001f) lifetime = 0.001f;
+    life[i] = lifetime;
+    invLifetime[i] = 1.0f / lifetime;
+    gravity[i] = preset.gravity;
+    drag[i] = preset.drag;
+    radiusStart[i] = preset.radiusStart;
+    radiusEnd[i] = preset.radiusEnd;
+    radius[i] = preset.radiusStart;
+    colorStart[i] = preset.colorStart;
+    colorEnd[i] = preset.colorEnd;
+    color[i] = preset.colorStart;
+    index = i;
+    return true;
+}
+
+void ParticleSystem::burst(float px, float py, int n, const ParticlePreset& preset) {
+    for (int k = 0; k < n; ++k) {
+        size_t i;
+        if (!emit(i, preset)) return;
+        float angle = random01() * TWO_PI;
+        float speed = preset.speedMin + (preset.speedMax - preset.speedMin) * random01();
+        x[i] = px;
+        y[i] = py;
+        vx[i] = std::cos(angle) * speed;
+        vy[i] = std::sin(angle) * speed;
+    }
+}
+
+void ParticleSystem::ring(float px, float py, int n, float ringRadius, const ParticlePreset& preset) {
+    if (n <= 0) return;
+    const float step = TWO_PI / n;
+    for (int k = 0; k < n; ++k) {
+        size_t i;
+        if (!emit(i, preset)) return;
+        float c = std::cos(k * step);
+        float s = std::sin(k * step);
+        float speed = preset.speedMin + (preset.speedMax - preset.speedMin) * random01();
+        x[i] = px + c * ringRadius;
+        y[i] = py + s * ringRadius;
+        vx[i] = c * speed;
+        vy[i] = s * speed;
+    }
+}
+
+void ParticleSystem::trail(float x0, float y0, float x1, float y1, int n, const ParticlePreset& preset) {
+    for (int k = 0; k < n; ++k) {
+        size_t i;
+        if (!emit(i, preset)) return;
+        float t = random01();
+        float angle = random01() * TWO_PI;
+        float speed = preset.speedMin + (preset.speedMax - preset.speedMin) * random01();
+        x[i] = x0 + (x1 - x0) * t;
+        y[i] = y0 + (y1 - y0) * t;
+        vx[i] = std::cos(angle) * speed;
+        vy[i] = std::sin(angle) * speed;
+    }
+}
+
+void ParticleSystem::update(float dt, const Playfield& bounds) {
+    if (count == 0) return;
+    if (integrate(0, count, dt, bounds)) {
+        compact();
+    }
+}
+
+void ParticleSystem::update(float dt, const Playfield& bounds, JobSystem& jobs) {
+    if (count == 0) return;
+    std::atomic<bool> anyDead(false);
+    jobs.parallelFor(count, JOB_BLOCK, [&](size_t begin, size_t end) {
+        if (integrate(begin, end, dt, bounds)) anyDead.store(true, std::memory_order_relaxed);
+    });
+    if (anyDead.load(std::memory_order_relaxed)) {
+        compact();
+    }
+}
+
+// Velocity loses drag * dt of itself each tick (clamped so it never flips),
+// then gravity pulls it down. Age t = 1 - life / lifetime drives the radius
+// and color blends; a particle is gone when its life runs out or it leaves
+// the field.
+bool ParticleSystem::integrate(size_t begin, size_t end, float dt, const Playfield& bounds) {
+    bool anyDead = false;
+    const size_t blockEnd = alignUp(end, LANES);
+
+#if defined(PARTICLE_KERNEL_AVX2)
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 colorScale = _mm256_set1_ps(256.0f);
+    const __m256 left = _mm256_set1_ps(bounds.left);
+    const __m256 right = _mm256_set1_ps(bounds.right);
+    const __m256 top = _mm256_set1_ps(bounds.top);
+    const __m256 bottom = _mm256_set1_ps(bounds.bottom);
+
+    for (size_t i = begin; i < blockEnd; i += 8) {
+        __m256 damp = _mm256_max_ps(zero, _mm256_sub_ps(one, _mm256_mul_ps(_mm256_load_ps(drag + i), vdt)));
+        __m256 pvx = _mm256_mul_ps(_mm256_load_ps(vx + i), damp);
+        __m256 pvy = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(vy + i), damp),
+                                   _mm256_mul_ps(_mm256_load_ps(gravity + i), vdt));
+        _mm256_store_ps(vx + i, pvx);
+        _mm256_store_ps(vy + i, pvy);
+
+        __m256 px = _mm256_add_ps(_mm256_load_ps(x + i), _mm256_mul_ps(pvx, vdt));
+        __m256 py = _mm256_add_ps(_mm256_load_ps(y + i), _mm256_mul_ps(pvy, vdt));
+        _mm256_store_ps(x + i, px);
+        _mm256_store_ps(y + i, py);
+
+        __m256 l = _mm256_sub_ps(_mm256_load_ps(life + i), vdt);
+        _mm256_store_ps(life + i, l);
+
+        __m256 t = _mm256_sub_ps(one, _mm256_mul_ps(l, _mm256_load_ps(invLifetime + i)));
+        t = _mm256_min_ps(one, _mm256_max_ps(zero, t));
+        __m256 r0 = _mm256_load_ps(radiusStart + i);
+        _mm256_store_ps(radius + i, _mm256_add_ps(r0, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(radiusEnd + i), r0), t)));
+
+        __m256i t8 = _mm256_cvttps_epi32(_mm256_mul_ps(t, colorScale));
+        for (size_t h = 0; h < 8; h += 4) {
+            __m128i th = h == 0 ? _mm256_castsi256_si128(t8) : _mm256_extracti128_si256(t8, 1);
+            __m128i c0 = _mm_load_si128(reinterpret_cast<const __m128i*>(colorStart + i + h));
+            __m128i c1 = _mm_load_si128(reinterpret_cast<const __m128i*>(colorEnd + i + h));
+            _mm_store_si128(reinterpret_cast<__m128i*>(color + i + h), lerpColors(c0, c1, th));
+        }
+
+        __m256 dead = _mm256_cmp_ps(l, zero, _CMP_LE_OQ);
+        dead = _mm256_or_ps(dead, _mm256_cmp_ps(px, left, _CMP_LT_OQ));
+        dead = _mm256_or_ps(dead, _mm256_cmp_ps(px, right, _CMP_GT_OQ));
+        dead = _mm256_or_ps(dead, _mm256_cmp_ps(py, top, _CMP_LT_OQ));
+        dead = _mm256_or_ps(dead, _mm256_cmp_ps(py, bottom, _CMP_GT_OQ));
+
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(dead));
+        if (i + 8 > end) mask &= (1u << (end - i)) - 1u; // ignore padding lanes
+        deadMask[i >> 3] = static_cast<Uint8>(mask);
+        anyDead |= mask != 0;
+    }
+#elif defined(PARTICLE_KERNEL_SSE2)
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 colorScale = _mm_set1_ps(256.0f);
+    const __m128 left = _mm_set1_ps(bounds.left);
+    const __m128 right = _mm_set1_ps(bounds.right);
+    const __m128 top = _mm_set1_ps(bounds.top);
+    const __m128 bottom = _mm_set1_ps(bounds.bottom);
+
+    for (size_t i = begin; i < blockEnd; i += 8) {
+        unsigned mask = 0;
+        for (size_t h = 0; h < 8; h += 4) {
+            size_t j = i + h;
+            __m128 damp = _mm_max_ps(zero, _mm_sub_ps(one, _mm_mul_ps(_mm_load_ps(drag + j), vdt)));
+            __m128 pvx = _mm_mul_ps(_mm_load_ps(vx + j), damp);
+            __m128 pvy = _mm_add_ps(_mm_mul_ps(_mm_load_ps(vy + j), damp), _mm_mul_ps(_mm_load_ps(gravity + j), vdt));
+            _mm_store_ps(vx + j, pvx);
+            _mm_store_ps(vy + j, pvy);
+
+            __m128 px = _mm_add_ps(_mm_load_ps(x + j), _mm_mul_ps(pvx, vdt));
+            __m128 py = _mm_add_ps(_mm_load_ps(y + j), _mm_mul_ps(pvy, vdt));
+            _mm_store_ps(x + j, px);
+            _mm_store_ps(y + j, py);
+
+            __m128 l = _mm_sub_ps(_mm_load_ps(life + j), vdt);
+            _mm_store_ps(life + j, l);
+
+            __m128 t = _mm_sub_ps(one, _mm_mul_ps(l, _mm_load_ps(invLifetime + j)));
+            t = _mm_min_ps(one, _mm_max_ps(zero, t));
+            __m128 r0 = _mm_load_ps(radiusStart + j);
+            _mm_store_ps(radius + j, _mm_add_ps(r0, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(radiusEnd + j), r0), t)));
+
+            __m128i c0 = _mm_load_si128(reinterpret_cast<const __m128i*>(colorStart + j));
+            __m128i c1 = _mm_load_si128(reinterpret_cast<const __m128i*>(colorEnd + j));
+            __m128i t8 = _mm_cvttps_epi32(_mm_mul_ps(t, colorScale));
+            _mm_store_si128(reinterpret_cast<__m128i*>(color + j), lerpColors(c0, c1, t8));
+
+            __m128 dead = _mm_cmple_ps(l, zero);
+            dead = _mm_or_ps(dead, _mm_cmplt_ps(px, left));
+            dead = _mm_or_ps(dead, _mm_cmpgt_ps(px, right));
+            dead = _mm_or_ps(dead, _mm_cmplt_ps(py, top));
+            dead = _mm_or_ps(dead, _mm_cmpgt_ps(py, bottom));
+            mask |= static_cast<unsigned>(_mm_movemask_ps(dead)) << h;
+        }
+        if (i + 8 > end) mask &= (1u << (end - i)) - 1u; // ignore padding lanes
+        deadMask[i >> 3] = static_cast<Uint8>(mask);
+        anyDead |= mask != 0;
+    }
+#else
+    for (size_t i = begin; i < blockEnd; i += 8) {
+        unsigned mask = 0;
+        for (size_t lane = 0; lane < 8; ++lane) {
+            size_t j = i + lane;
+            float damp = 1.0f - drag[j] * dt;
+            if (damp < 0.0f) damp = 0.0f;
+            vx[j] *= damp;
+            vy[j] = vy[j] * damp + gravity[j] * dt;
+            x[j] += vx[j] * dt;
+            y[j] += vy[j] * dt;
+            life[j] -= dt;
+
+            float t = 1.0f - life[j] * invLifetime[j];
+            if (t < 0.0f) t = 0.0f;
+            if (t > 1.0f) t = 1.0f;
+            radius[j] = radiusStart[j] + (radiusEnd[j] - radiusStart[j]) * t;
+            color[j] = lerpColor(colorStart[j], colorEnd[j], static_cast<Uint32>(t * 256.0f));
+
+            bool dead = life[j] <= 0.0f ||
+                        x[j] < bounds.left || x[j] > bounds.right ||
+                        y[j] < bounds.top || y[j] > bounds.bottom;
+            mask |= static_cast<unsigned>(dead) << lane;
+        }
+        if (i + 8 > end) mask &= (1u << (end - i)) - 1u; // ignore padding lanes
+        deadMask[i >> 3] = static_cast<Uint8>(mask);
+        anyDead |= mask != 0;
+    }
+#endif
+
+    return anyDead;
+}
+
+void ParticleSystem::moveParticle(size_t from, size_t to) {
+    x[to] = x[from];
+    y[to] = y[from];
+    vx[to] = vx[from];
+    vy[to] = vy[from];
+    gravity[to] = gravity[from];
+    drag[to] = drag[from];
+    life[to] = life[from];
+    invLifetime[to] = invLifetime[from];
+    radiusStart[to] = radiusStart[from];
+    radiusEnd[to] = radiusEnd[from];
+    radius[to] = radius[from];
+    colorStart[to] = colorStart[from];
+    colorEnd[to] = colorEnd[from];
+    color[to] = color[from];
+}
+
+// Swap-remove, same as BulletPool::compact()
+void ParticleSystem::compact() {
+    size_t n = count;
+    size_t i = 0;
+    while (i < n) {
+        if ((i & 7) == 0 && i + 8 <= n && deadMask[i >> 3] == 0) {
+            i += 8;
+            continue;
+        }
+        if (!isDead(i)) {
+            ++i;
+            continue;
+        }
+        --n;
+        if (i != n) {
+            moveParticle(n, i);
+            setDead(i, isDead(n));
+        }
+    }
+    count = n;
+}
@@ -0,0 +1,116 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+// Keeps a trace from eating all memory if capture is left running
+constexpr size_t MAX_CAPTURED_EVENTS = 4u << 20;
+}
+
+Profiler& Profiler::get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+ProfileRing& Profiler::threadRing() {
+    thread_local ProfileRing* ring = nullptr;
+    if (!ring) ring = &get().registerThread();
+    return *ring;
+}
+
+ProfileRing& Profiler::registerThread() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    rings.push_back(std::make_unique<ProfileRing>(nextThreadId++));
+    return *rings.back();
+}
+
+void Profiler::beginFrame() {
+    frameStart = SDL_GetPerformanceCounter();
+}
+
+void Profiler::endFrame() {
+    Uint64 frameEnd = SDL_GetPerformanceCounter();
+    const double msPerTick = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+    frameEvents.clear();
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (std::unique_ptr<ProfileRing>& ring : rings) {
+            ring->drain([&](const ProfileEvent& e) { frameEvents.push_back(e); });
+        }
+    }
+
+    // Children finish (and are pushed) before their parents; sorting by
+    // start puts parents first so new zones get listed in tree order
+    std::sort(frameEvents.begin(), frameEvents.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+        return a.start < b.start;
+    });
+
+    for (Zone& z : zones) z.history[historyHead] = 0.0f;
+    for (const ProfileEvent& e : frameEvents) {
+        int i = findZone(e.name, e.depth);
+        if (i >= 0) zones[i].history[historyHead] += static_cast<float>((e.end - e.start) * msPerTick);
+    }
+    frameMs[historyHead] = static_cast<float>((frameEnd - frameStart) * msPerTick);
+    historyHead = (historyHead + 1) % HISTORY;
+
+    if (capturing && captured.size() + frameEvents.size() <= MAX_CAPTURED_EVENTS) {
+        captured.insert(captured.end(), frameEvents.begin(), frameEvents.end());
+    }
+}
+
+int Profiler::findZone(const char* name, Uint16 depth) {
+    for (size_t i = 0; i < zones.size(); ++i) {
+        if (zones[i].name == name) return static_cast<int>(i);
+    }
+    if (zones.size() >= MAX_ZONES) return -1;
+    zones.emplace_back();
+    zones.back().name = name;
+    zones.back().depth = depth;
+    return static_cast<int>(zones.size() - 1);
+}
+
+float Profiler::zoneAverageMs(int i) const {
+    float total = 0.0f;
+    for (float ms : zones[i].history) total += ms;
+    return total / HISTORY;
+}
+
+float Profiler::zoneMaxMs(int i) const {
+    return *std::max_element(zones[i].history, zones[i].history + HISTORY);
+}
+
+Uint64 Profiler::droppedEvents() const {
+    Uint64 total = 0;
+    for (const std::unique_ptr<ProfileRing>& ring : rings) total += ring->dropped.load(std::memory_order_relaxed);
+    return total;
+}
+
+void Profiler::startCapture() {
+    captured.clear();
+    captureStart = SDL_GetPerformanceCounter();
+    capturing = true;
+}
+
+bool Profiler::stopCapture(const char* path) {
+    capturing = false;
+
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+
+    const double usPerTick = 1e6 / static_cast<double>(SDL_GetPerformanceFrequency());
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < captured.size(); ++i) {
+        const ProfileEvent& e = captured[i];
+        double ts = (e.start >= captureStart ? e.start - captureStart : 0) * usPerTick;
+        double dur = (e.end - e.start) * usPerTick;
+        std::fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}%s\n",
+                     e.name, ts, dur, e.threadId, i + 1 < captured.size() ? "," : "");
+    }
+    std::fprintf(f, "]}\n");
+    std::fclose(f);
+
+    captured.clear();
+    captured.shrink_to_fit();
+    return true;
+}
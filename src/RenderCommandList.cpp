@@ -0,0 +1,258 @@
+#include "RenderCommandList.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "CircleRenderer.h"
+#include "Profiler.h"
+#include "TextRenderer.h"
+
+void RenderCommandList::clear() {
+    commands.clear();
+    chars.clear();
+    circlesUsed = 0;
+    strips.clear();
+    stripNodesUsed = 0;
+}
+
+void RenderCommandList::sprite(const Sprite& sprite, const SDL_FRect& dst, float dx, float dy, Uint8 layer,
+                               SDL_Color color) {
+    Command c = {};
+    c.type = Type::SPRITE;
+    c.layer = layer;
+    c.color = color;
+    c.sprite = &sprite;
+    c.rect = dst;
+    c.dx = dx;
+    c.dy = dy;
+    commands.push_back(c);
+}
+
+void RenderCommandList::rect(const SDL_FRect& dst, Uint8 layer, SDL_Color color, SDL_BlendMode blend) {
+    Command c = {};
+    c.type = Type::RECT;
+    c.layer = layer;
+    c.blend = blend;
+    c.color = color;
+    c.rect = dst;
+    commands.push_back(c);
+}
+
+void RenderCommandList::circle(float x, float y, float dx, float dy, float radius, SDL_Color color, Uint8 layer) {
+    Command c = {};
+    c.type = Type::CIRCLE;
+    c.layer = layer;
+    c.color = color;
+    c.rect = { x, y, radius, radius };
+    c.dx = dx;
+    c.dy = dy;
+    commands.push_back(c);
+}
+
+void RenderCommandList::text(const char* str, int x, int y, SDL_Color color, Uint8 layer, bool centered) {
+    Command c = {};
+    c.type = Type::TEXT;
+    c.layer = layer;
+    c.centered = centered;
+    c.color = color;
+    c.rect = { static_cast<float>(x), static_cast<float>(y), 0.0f, 0.0f };
+    c.first = static_cast<Uint32>(chars.size());
+    size_t length = std::strlen(str);
+    chars.insert(chars.end(), str, str + length + 1);
+    commands.push_back(c);
+}
+
+RenderCommandList::CircleRun RenderCommandList::beginCircles(size_t count, SDL_BlendMode blend, Uint8 layer) {
+    size_t first = circlesUsed;
+    circlesUsed += count;
+    if (circlesUsed > circleX.size()) {
+        circleX.resize(circlesUsed);
+        circleY.resize(circlesUsed);
+        circleDx.resize(circlesUsed);
+        circleDy.resize(circlesUsed);
+        circleRadius.resize(circlesUsed);
+        circleColor.resize(circlesUsed);
+    }
+
+    Command c = {};
+    c.type = Type::CIRCLES;
+    c.layer = layer;
+    c.blend = blend;
+    c.first = static_cast<Uint32>(first);
+    c.count = static_cast<Uint32>(count);
+    commands.push_back(c);
+
+    return { &circleX[first], &circleY[first], &circleDx[first], &circleDy[first],
+             &circleRadius[first], &circleColor[first] };
+}
+
+RenderCommandList::StripRun RenderCommandList::beginStrips(size_t count, size_t nodes, SDL_BlendMode blend,
+                                                           Uint8 layer) {
+    size_t first = strips.size();
+    size_t firstNode = stripNodesUsed;
+    strips.resize(first + count);
+    stripNodesUsed += nodes;
+    if (stripNodesUsed > stripX.size()) {
+        stripX.resize(stripNodesUsed);
+        stripY.resize(stripNodesUsed);
+    }
+
+    Command c = {};
+    c.type = Type::STRIPS;
+    c.layer = layer;
+    c.blend = blend;
+    c.first = static_cast<Uint32>(first);
+    c.count = static_cast<Uint32>(count);
+    c.firstNode = static_cast<Uint32>(firstNode);
+    commands.push_back(c);
+
+    return { &strips[first], &stripX[firstNode], &stripY[firstNode] };
+}
+
+void RenderCommandList::replay(SpriteBatch& batch, CircleRenderer& circles, TextRenderer& text, float alpha) const {
+    PROFILE_SCOPE("replayCommands");
+    const float rewind = 1.0f - alpha;
+    for (const Command& c : commands) {
+        switch (c.type) {
+        case Type::SPRITE: {
+            SDL_FRect dst = { c.rect.x - c.dx * rewind, c.rect.y - c.dy * rewind, c.rect.w, c.rect.h };
+            batch.draw(*c.sprite, dst, c.layer, c.color);
+            break;
+        }
+        case Type::RECT:
+            batch.drawRect(c.rect, c.layer, c.color, c.blend);
+            break;
+        case Type::CIRCLE:
+            circles.fillCircle(c.rect.x - c.dx * rewind, c.rect.y - c.dy * rewind, c.rect.w, c.color, c.layer);
+            break;
+        case Type::TEXT: {
+            const char* str = &chars[c.first];
+            int x = static_cast<int>(c.rect.x);
+            if (c.centered) {
+                int w = 0;
+                text.measureText(str, &w, nullptr);
+                x -= w / 2;
+            }
+            text.drawText(str, x, static_cast<int>(c.rect.y), c.color, c.layer);
+            break;
+        }
+        case Type::CIRCLES:
+            replayCircles(c, batch, circles, rewind);
+            break;
+        case Type::STRIPS:
+            replayStrips(c, batch, circles, rewind);
+            break;
+        }
+    }
+}
+
+void RenderCommandList::replayCircles(const Command& c, SpriteBatch& batch, const CircleRenderer& circles,
+                                      float rewind) const {
+    if (c.count == 0) return;
+    const float* x = &circleX[c.first];
+    const float* y = &circleY[c.first];
+    const float* dx = &circleDx[c.first];
+    const float* dy = &circleDy[c.first];
+    const float* radius = &circleRadius[c.first];
+    const Uint32* color = &circleColor[c.first];
+
+    // Every radius lives in the same circle atlas, so this is one draw call
+    const Sprite& atlasSprite = circles.circleSprite(1);
+    SDL_Vertex* v = batch.reserveQuads(atlasSprite.texture, c.blend, c.layer, c.count);
+    for (Uint32 i = 0; i < c.count; ++i, v += 4) {
+        float cx = x[i] - dx[i] * rewind;
+        float cy = y[i] - dy[i] * rewind;
+        float r = radius[i];
+        const Sprite& sprite = circles.circleSprite(static_cast<int>(r + 0.5f));
+        float half = r + 1.0f; // sprite has a 1 px AA margin
+        SDL_Color tint = {
+            static_cast<Uint8>(color[i] >> 24), static_cast<Uint8>(color[i] >> 16),
+            static_cast<Uint8>(color[i] >> 8), static_cast<Uint8>(color[i])
+        };
+        float u0 = sprite.uv.x;
+        float v0 = sprite.uv.y;
+        float u1 = sprite.uv.x + sprite.uv.w;
+        float v1 = sprite.uv.y + sprite.uv.h;
+        v[0] = { { cx - half, cy - half }, tint, { u0, v0 } };
+        v[1] = { { cx + half, cy - half }, tint, { u1, v0 } };
+        v[2] = { { cx - half, cy + half }, tint, { u0, v1 } };
+        v[3] = { { cx + half, cy + half }, tint, { u1, v1 } };
+    }
+}
+
+void RenderCommandList::replayStrips(const Command& c, SpriteBatch& batch, const CircleRenderer& circles,
+                                     float rewind) const {
+    size_t quads = 0;
+    for (Uint32 s = 0; s < c.count; ++s) {
+        Uint32 nodes = strips[c.first + s].nodes;
+        if (nodes >= 2) quads += nodes - 1;
+    }
+    if (quads == 0) return;
+
+    // A quad per segment, each sharing its edge with the next, so the strip
+    // stays connected however tightly it bends
+    const Sprite& atlasSprite = circles.circleSprite(1);
+    SDL_Vertex* v = batch.reserveQuads(atlasSprite.texture, c.blend, c.layer, quads);
+    const float* x = &stripX[c.firstNode];
+    const float* y = &stripY[c.firstNode];
+    for (Uint32 s = 0; s < c.count; ++s) {
+        const Strip& strip = strips[c.first + s];
+        const int n = static_cast<int>(strip.nodes);
+        if (n < 2) {
+            x += n;
+            y += n;
+            continue;
+        }
+
+        const Sprite& sprite = circles.circleSprite(static_cast<int>(strip.radius + 0.5f));
+        const float u = sprite.uv.x + sprite.uv.w * 0.5f;
+        const float v0 = sprite.uv.y;
+        const float v1 = sprite.uv.y + sprite.uv.h;
+        const float half = strip.radius + 1.0f; // sprite has a 1 px AA margin
+        const SDL_Color tint = {
+            static_cast<Uint8>(strip.color >> 24), static_cast<Uint8>(strip.color >> 16),
+            static_cast<Uint8>(strip.color >> 8), static_cast<Uint8>(strip.color)
+        };
+        auto point = [&](int i) {
+            SDL_FPoint p = { x[i], y[i] };
+            if (i == 0) {
+                p.x -= strip.tailDx * rewind;
+                p.y -= strip.tailDy * rewind;
+            } else if (i == n - 1) {
+                p.x -= strip.headDx * rewind;
+                p.y -= strip.headDy * rewind;
+            }
+            return p;
+        };
+
+        // Edge points across each node, along the average of its two
+        // segments, narrowing over the last few nodes at either end
+        SDL_FPoint left = {}, right = {};
+        float nx = 0.0f, ny = -1.0f;
+        for (int i = 0; i < n; ++i) {
+            SDL_FPoint p = point(i);
+            SDL_FPoint ahead = point(std::min(i + 1, n - 1));
+            SDL_FPoint behind = point(std::max(i - 1, 0));
+            float tx = ahead.x - behind.x;
+            float ty = ahead.y - behind.y;
+            float length = std::sqrt(tx * tx + ty * ty);
+            if (length > 1.0e-4f) {
+                nx = -ty / length;
+                ny = tx / length;
+            }
+            float w = half * std::min(1.0f, (std::min(i, n - 1 - i) + 1) * 0.25f);
+            SDL_FPoint nextLeft = { p.x + nx * w, p.y + ny * w };
+            SDL_FPoint nextRight = { p.x - nx * w, p.y - ny * w };
+            if (i > 0) {
+                v[0] = { left, tint, { u, v0 } };
+                v[1] = { nextLeft, tint, { u, v0 } };
+                v[2] = { right, tint, { u, v1 } };
+                v[3] = { nextRight, tint, { u, v1 } };
+                v += 4;
+            }
+            left = nextLeft;
+            right = nextRight;
+        }
+        x += n;
+        y += n;
+    }
+}
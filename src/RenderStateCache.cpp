@@ -0,0 +1,49 @@
+#include "RenderStateCache.h"
+#include <cstdint>
+
+void RenderStateCache::attach(SDL_Renderer* renderer) {
+    this->renderer = renderer;
+    invalidate();
+}
+
+void RenderStateCache::invalidate() {
+    colorValid = false;
+    blendValid = false;
+    for (int i = 0; i < TEXTURE_SLOTS; ++i) textureKeys[i] = nullptr;
+}
+
+void RenderStateCache::setDrawColor(SDL_Color color) {
+    if (colorValid && color.r == drawColor.r && color.g == drawColor.g &&
+        color.b == drawColor.b && color.a == drawColor.a) {
+        stateChangesSkipped++;
+        return;
+    }
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    drawColor = color;
+    colorValid = true;
+    stateChanges++;
+}
+
+void RenderStateCache::setDrawBlendMode(SDL_BlendMode mode) {
+    if (blendValid && mode == drawBlend) {
+        stateChangesSkipped++;
+        return;
+    }
+    SDL_SetRenderDrawBlendMode(renderer, mode);
+    drawBlend = mode;
+    blendValid = true;
+    stateChanges++;
+}
+
+void RenderStateCache::setTextureBlendMode(SDL_Texture* texture, SDL_BlendMode mode) {
+    // Textures are heap pointers; drop the low alignment bits before hashing
+    size_t slot = (reinterpret_cast<uintptr_t>(texture) >> 4) % TEXTURE_SLOTS;
+    if (textureKeys[slot] == texture && textureBlend[slot] == mode) {
+        stateChangesSkipped++;
+        return;
+    }
+    SDL_SetTextureBlendMode(texture, mode);
+    textureKeys[slot] = texture;
+    textureBlend[slot] = mode;
+    stateChanges++;
+}
@@ -0,0 +1,56 @@
+#include "SdlRenderBackend.h"
+#include "RenderStateCache.h"
+
+bool SdlRenderBackend::init(SDL_Renderer* renderer, RenderStateCache& cache, int, int) {
+    this->renderer = renderer;
+    this->cache = &cache;
+    return true;
+}
+
+bool SdlRenderBackend::supportsTargets() const {
+    return SDL_RenderTargetSupported(renderer) == SDL_TRUE;
+}
+
+SDL_Texture* SdlRenderBackend::createTarget(int width, int height) {
+    return SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+}
+
+void SdlRenderBackend::destroyTexture(SDL_Texture* texture) {
+    if (!texture) return;
+    SDL_DestroyTexture(texture);
+    // A new texture can get the same address and a stale cached blend mode
+    cache->invalidate();
+}
+
+void SdlRenderBackend::setTarget(SDL_Texture* target) {
+    SDL_SetRenderTarget(renderer, target);
+    // The cache doesn't know the target changed; clear its state either way
+    cache->invalidate();
+}
+
+void SdlRenderBackend::clear(SDL_Color color) {
+    cache->setDrawColor(color);
+    SDL_RenderClear(renderer);
+}
+
+void SdlRenderBackend::drawGeometry(SDL_Texture* texture, SDL_BlendMode blend, const SDL_Vertex* vertices,
+                                    int vertexCount, const int* indices, int indexCount) {
+    // Geometry takes its blend mode from the texture, or from the renderer's
+    // draw blend mode when untextured
+    if (texture) {
+        cache->setTextureBlendMode(texture, blend);
+    } else {
+        cache->setDrawBlendMode(blend);
+    }
+    SDL_RenderGeometry(renderer, texture, vertices, vertexCount, indices, indexCount);
+}
+
+void SdlRenderBackend::present() {
+    SDL_RenderPresent(renderer);
+}
+
+bool SdlRenderBackend::readPixels(Uint32* dst, int width, int height) {
+    SDL_Rect area = { 0, 0, width, height };
+    return SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_RGBA32, dst,
+                                width * static_cast<int>(sizeof(Uint32))) == 0;
+}
@@ -0,0 +1,167 @@
+#include "SpriteBatch.h"
+
+Sprite Sprite::fromTexture(SDL_Texture* texture) {
+    Sprite sprite;
+    sprite.texture = texture;
+    if (texture) {
+        SDL_QueryTexture(texture, NULL, NULL, &sprite.width, &sprite.height);
+    }
+    return sprite;
+}
+
+template<typename Backend>
+bool BasicSpriteBatch<Backend>::init(SDL_Renderer* renderer, int width, int height, size_t expectedQuads) {
+    cache.attach(renderer);
+    if (!renderBackend.init(renderer, cache, width, height)) {
+        return false;
+    }
+
+    vertices.reserve(expectedQuads * 4);
+    quadState.reserve(expectedQuads);
+    indices.reserve(expectedQuads * 6);
+    states.reserve(64);
+    stateCount.reserve(64);
+    stateRank.reserve(64);
+    rankOrder.reserve(64);
+    return true;
+}
+
+template<typename Backend>
+Uint16 BasicSpriteBatch<Backend>::findState(SDL_Texture* texture, SDL_BlendMode blend, Uint8 layer) {
+    if (layer >= LAYER_COUNT) layer = LAYER_COUNT - 1;
+
+    // Consecutive draws almost always share state; check the last one first
+    if (lastState >= 0) {
+        const State& s = states[lastState];
+        if (s.texture == texture && s.blend == blend && s.layer == layer) {
+            return static_cast<Uint16>(lastState);
+        }
+    }
+    for (size_t i = 0; i < states.size(); ++i) {
+        const State& s = states[i];
+        if (s.texture == texture && s.blend == blend && s.layer == layer) {
+            lastState = static_cast<int>(i);
+            return static_cast<Uint16>(i);
+        }
+    }
+    states.push_back({ texture, blend, layer });
+    lastState = static_cast<int>(states.size() - 1);
+    return static_cast<Uint16>(lastState);
+}
+
+template<typename Backend>
+SDL_Vertex* BasicSpriteBatch<Backend>::reserveQuads(SDL_Texture* texture, SDL_BlendMode blend, Uint8 layer, size_t count) {
+    Uint16 state = findState(texture, blend, layer);
+    size_t first = vertices.size();
+    vertices.resize(first + count * 4);
+    quadState.insert(quadState.end(), count, state);
+    return &vertices[first];
+}
+
+template<typename Backend>
+void BasicSpriteBatch<Backend>::drawQuad(SDL_Texture* texture, SDL_BlendMode blend, Uint8 layer, const SDL_Vertex* v) {
+    SDL_Vertex* dst = reserveQuads(texture, blend, layer, 1);
+    dst[0] = v[0];
+    dst[1] = v[1];
+    dst[2] = v[2];
+    dst[3] = v[3];
+}
+
+template<typename Backend>
+void BasicSpriteBatch<Backend>::draw(const Sprite& sprite, const SDL_FRect& dst, Uint8 layer, SDL_Color color) {
+    SDL_Vertex* v = reserveQuads(sprite.texture, sprite.blend, layer, 1);
+    const float x0 = dst.x;
+    const float y0 = dst.y;
+    const float x1 = dst.x + dst.w;
+    const float y1 = dst.y + dst.h;
+    const float u0 = sprite.uv.x;
+    const float v0 = sprite.uv.y;
+    const float u1 = sprite.uv.x + sprite.uv.w;
+    const float v1 = sprite.uv.y + sprite.uv.h;
+    v[0] = { { x0, y0 }, color, { u0, v0 } };
+    v[1] = { { x1, y0 }, color, { u1, v0 } };
+    v[2] = { { x0, y1 }, color, { u0, v1 } };
+    v[3] = { { x1, y1 }, color, { u1, v1 } };
+}
+
+template<typename Backend>
+void BasicSpriteBatch<Backend>::drawRect(const SDL_FRect& dst, Uint8 layer, SDL_Color color, SDL_BlendMode blend) {
+    SDL_Vertex* v = reserveQuads(nullptr, blend, layer, 1);
+    const float x0 = dst.x;
+    const float y0 = dst.y;
+    const float x1 = dst.x + dst.w;
+    const float y1 = dst.y + dst.h;
+    v[0] = { { x0, y0 }, color, { 0.0f, 0.0f } };
+    v[1] = { { x1, y0 }, color, { 0.0f, 0.0f } };
+    v[2] = { { x0, y1 }, color, { 0.0f, 0.0f } };
+    v[3] = { { x1, y1 }, color, { 0.0f, 0.0f } };
+}
+
+template<typename Backend>
+void BasicSpriteBatch<Backend>::submitRun(const State& state, size_t firstIndex, size_t indexCount) {
+    renderBackend.drawGeometry(state.texture, state.blend, vertices.data(), static_cast<int>(vertices.size()),
+                               indices.data() + firstIndex, static_cast<int>(indexCount));
+    stats.drawCalls++;
+}
+
+template<typename Backend>
+void BasicSpriteBatch<Backend>::flush() {
+    const size_t quadCount = quadState.size();
+    const size_t stateTotal = states.size();
+
+    stats = Stats();
+    stats.quads = static_cast<int>(quadCount);
+    stats.vertices = static_cast<int>(vertices.size());
+    stats.states = static_cast<int>(stateTotal);
+
+    if (quadCount > 0) {
+        // Rank states by layer, keeping first-submitted order within a layer
+        // so the result is stable from frame to frame
+        rankOrder.clear();
+        for (Uint8 layer = 0; layer < LAYER_COUNT; ++layer) {
+            for (size_t s = 0; s < stateTotal; ++s) {
+                if (states[s].layer == layer) rankOrder.push_back(static_cast<Uint16>(s));
+            }
+        }
+        stateRank.assign(stateTotal, 0);
+        for (size_t r = 0; r < rankOrder.size(); ++r) stateRank[rankOrder[r]] = static_cast<Uint16>(r);
+
+        // Counting sort of quads by state rank, written straight out as indices
+        stateCount.assign(stateTotal + 1, 0);
+        for (size_t q = 0; q < quadCount; ++q) stateCount[stateRank[quadState[q]] + 1]++;
+        for (size_t r = 1; r <= stateTotal; ++r) stateCount[r] += stateCount[r - 1];
+
+        indices.resize(quadCount * 6);
+        for (size_t q = 0; q < quadCount; ++q) {
+            Uint32 slot = stateCount[stateRank[quadState[q]]]++;
+            int base = static_cast<int>(q * 4);
+            int* idx = &indices[slot * 6];
+            idx[0] = base;
+            idx[1] = base + 1;
+            idx[2] = base + 2;
+            idx[3] = base + 2;
+            idx[4] = base + 1;
+            idx[5] = base + 3;
+        }
+
+        // After the scatter stateCount[r] is the end of rank r's run
+        size_t runStart = 0;
+        for (size_t r = 0; r < stateTotal; ++r) {
+            size_t runEnd = stateCount[r];
+            if (runEnd > runStart) {
+                submitRun(states[rankOrder[r]], runStart * 6, (runEnd - runStart) * 6);
+            }
+            runStart = runEnd;
+        }
+    }
+    renderBackend.finish();
+
+    vertices.clear();
+    quadState.clear();
+    states.clear();
+    lastState = -1;
+}
+
+// Both are built so tools can compare them whichever one the game uses
+template class BasicSpriteBatch<SdlRenderBackend>;
+template class BasicSpriteBatch<CpuRenderBackend>;
@@ -0,0 +1,509 @@
+#include "Stage.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "Components.h"
+#include "EntitySystems.h"
+#include "Profiler.h"
+#include "StateSnapshot.h"
+
+namespace {
+
+constexpr int MAX_TOKENS = 16;
+
+void copyText(char* dst, size_t size, const char* src) {
+    std::strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+}
+
+bool parseFloat(const char* token, float& out) {
+    char* end = nullptr;
+    out = std::strtof(token, &end);
+    return end != token && *end == '\0';
+}
+
+bool parseInt(const char* token, int& out) {
+    char* end = nullptr;
+    long v = std::strtol(token, &end, 10);
+    if (end == token || *end != '\0') return false;
+    out = static_cast<int>(v);
+    return true;
+}
+
+}
+
+StageScheduler::StageScheduler(size_t capacity)
+    : pool(capacity), nextIndex(capacity)
+{
+    overflow.reserve(capacity);
+    reset(0);
+}
+
+void StageScheduler::reset(Uint32 tick) {
+    for (Uint32 i = 0; i < WHEEL_SLOTS; ++i) {
+        heads[i] = NONE;
+        tails[i] = NONE;
+    }
+    // Free list through every pool slot
+    const Uint32 n = static_cast<Uint32>(pool.size());
+    for (Uint32 i = 0; i < n; ++i) nextIndex[i] = i + 1 < n ? i + 1 : NONE;
+    freeHead = n > 0 ? 0 : NONE;
+    overflow.clear();
+    currentTick = tick;
+    nextSequence = 0;
+    pendingCount = 0;
+}
+
+// Heap order: earlier tick first, then earlier sequence
+bool StageScheduler::later(Uint32 a, Uint32 b) const {
+    const StageEvent& ea = pool[a];
+    const StageEvent& eb = pool[b];
+    return ea.tick != eb.tick ? ea.tick > eb.tick : ea.sequence > eb.sequence;
+}
+
+bool StageScheduler::schedule(const StageEvent& event) {
+    if (freeHead == NONE) return false;
+    Uint32 index = freeHead;
+    freeHead = nextIndex[index];
+
+    StageEvent& e = pool[index];
+    e = event;
+    e.sequence = nextSequence++;
+    if (e.tick < currentTick) e.tick = currentTick; // late: goes out next
+    pendingCount++;
+
+    if (e.tick - currentTick < WHEEL_SLOTS) {
+        append(index);
+    } else {
+        overflow.push_back(index);
+        std::push_heap(overflow.begin(), overflow.end(), [this](Uint32 a, Uint32 b) { return later(a, b); });
+    }
+    return true;
+}
+
+void StageScheduler::append(Uint32 index) {
+    const Uint32 slot = pool[index].tick & (WHEEL_SLOTS - 1);
+    nextIndex[index] = NONE;
+    if (tails[slot] == NONE) {
+        heads[slot] = index;
+    } else {
+        nextIndex[tails[slot]] = index;
+    }
+    tails[slot] = index;
+}
+
+void StageScheduler::release(Uint32 index) {
+    nextIndex[index] = freeHead;
+    freeHead = index;
+    pendingCount--;
+}
+
+// Keeps the heap to events WHEEL_SLOTS or more ticks away. Runs once the
+// tick has moved on, before anything else can be scheduled for it, so heap
+// events still land ahead of later ones for the same tick.
+void StageScheduler::migrateOverflow() {
+    auto cmp = [this](Uint32 a, Uint32 b) { return later(a, b); };
+    while (!overflow.empty() && pool[overflow.front()].tick - currentTick < WHEEL_SLOTS) {
+        std::pop_heap(overflow.begin(), overflow.end(), cmp);
+        Uint32 index = overflow.back();
+        overflow.pop_back();
+        append(index);
+    }
+}
+
+void StageScheduler::saveState(StateWriter& out) const {
+    out.value(currentTick);
+    out.value(nextSequence);
+    // The wheel one bucket at a time from the current tick, each in FIFO
+    // order, then the heap as it's laid out
+    out.value(static_cast<Uint32>(pendingCount - overflow.size()));
+    for (Uint32 t = 0; t < WHEEL_SLOTS; ++t) {
+        for (Uint32 i = heads[(currentTick + t) & (WHEEL_SLOTS - 1)]; i != NONE; i = nextIndex[i]) {
+            out.value(pool[i]);
+        }
+    }
+    out.value(static_cast<Uint32>(overflow.size()));
+    for (Uint32 i : overflow) out.value(pool[i]);
+}
+
+bool StageScheduler::loadState(StateReader& in) {
+    Uint32 tick = 0;
+    Uint32 sequence = 0;
+    Uint32 wheelCount = 0;
+    Uint32 overflowCount = 0;
+    if (!in.value(tick) || !in.value(sequence) || !in.value(wheelCount)) return false;
+    reset(tick);
+    auto take = [&](Uint32& index) {
+        if (freeHead == NONE) return false;
+        index = freeHead;
+        freeHead = nextIndex[index];
+        pendingCount++;
+        return in.value(pool[index]);
+    };
+    // Appending in saved order gives every bucket its old order back, and
+    // the heap array is still a heap under the same comparison
+    for (Uint32 k = 0; k < wheelCount; ++k) {
+        Uint32 index = 0;
+        if (!take(index)) return false;
+        append(index);
+    }
+    if (!in.value(overflowCount)) return false;
+    for (Uint32 k = 0; k < overflowCount; ++k) {
+        Uint32 index = 0;
+        if (!take(index)) return false;
+        overflow.push_back(index);
+    }
+    nextSequence = sequence;
+    return true;
+}
+
+StageReader::~StageReader() {
+    close();
+}
+
+bool StageReader::open(const char* path, int ticksPerSecond) {
+    close();
+    file = std::fopen(path, "rb");
+    if (!file) return false;
+    this->path = path;
+    // We read in BUFFER_SIZE blocks ourselves
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    this->ticksPerSecond = ticksPerSecond;
+    atEnd = false;
+    bufferOffset = 0;
+    bufferPos = 0;
+    bufferLen = 0;
+    lineNumber = 0;
+    lastTick = 0;
+    name[0] = '\0';
+    error.clear();
+    return true;
+}
+
+void StageReader::close() {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    atEnd = true;
+}
+
+void StageReader::saveState(StateWriter& out) const {
+    long offset = file ? bufferOffset + static_cast<long>(bufferPos) : -1;
+    out.value(offset);
+    out.value(lineNumber);
+    out.value(atEnd);
+    out.value(lastTick);
+    out.value(name);
+}
+
+bool StageReader::loadState(StateReader& in) {
+    long offset = -1;
+    if (!in.value(offset)) return false;
+    if (offset >= 0) {
+        if (!file) {
+            file = std::fopen(path.c_str(), "rb");
+            if (!file) return false;
+            std::setvbuf(file, nullptr, _IONBF, 0);
+        }
+        // The buffer refills from here on the next line
+        if (std::fseek(file, offset, SEEK_SET) != 0) return false;
+        bufferOffset = offset;
+        bufferPos = 0;
+        bufferLen = 0;
+        error.clear();
+    } else {
+        close();
+    }
+    in.value(lineNumber);
+    in.value(atEnd);
+    in.value(lastTick);
+    in.value(name);
+    return in.ok();
+}
+
+bool StageReader::fail(const char* message) {
+    char text[160];
+    std::snprintf(text, sizeof(text), "line %d: %s", lineNumber, message);
+    error = text;
+    close();
+    return false;
+}
+
+// Next line into `line` with comments and surrounding blanks stripped;
+// false at end of file
+bool StageReader::readLine() {
+    size_t length = 0;
+    bool tooLong = false;
+    for (;;) {
+        if (bufferPos == bufferLen) {
+            bufferOffset += static_cast<long>(bufferLen);
+            bufferLen = file ? std::fread(buffer, 1, BUFFER_SIZE, file) : 0;
+            bufferPos = 0;
+            if (bufferLen == 0) {
+                if (length == 0 && !tooLong) {
+                    atEnd = true;
+                    return false;
+                }
+                break; // last line without a newline
+            }
+        }
+        char c = buffer[bufferPos++];
+        if (c == '\n') break;
+        if (length + 1 < MAX_LINE) line[length++] = c;
+        else tooLong = true;
+    }
+    lineNumber++;
+    line[length] = '\0';
+    if (tooLong) return fail("line too long");
+
+    if (char* comment = std::strchr(line, '#')) *comment = '\0';
+    size_t end = std::strlen(line);
+    while (end > 0 && std::isspace(static_cast<unsigned char>(line[end - 1]))) line[--end] = '\0';
+    return true;
+}
+
+bool StageReader::parseTime(const char* token, Uint32& tick) {
+    bool relative = *token == '+';
+    if (relative) token++;
+    char* end = nullptr;
+    double value = std::strtod(token, &end);
+    if (end == token || value < 0.0) return false;
+    if (*end == 's' && end[1] == '\0') {
+        value *= ticksPerSecond;
+    } else if (*end != '\0') {
+        return false;
+    }
+    Uint32 ticks = static_cast<Uint32>(std::floor(value + 0.5));
+    tick = relative ? lastTick + ticks : ticks;
+    return true;
+}
+
+bool StageReader::next(const PatternLibrary& patterns, StageEvent& out) {
+    while (!atEnd && readLine()) {
+        // Split a copy so the original keeps the free text after the fields
+        char fields[MAX_LINE];
+        std::memcpy(fields, line, sizeof(line));
+        const char* tokens[MAX_TOKENS];
+        size_t offsets[MAX_TOKENS];
+        int count = 0;
+        char* p = fields;
+        while (*p && count < MAX_TOKENS) {
+            while (*p && std::isspace(static_cast<unsigned char>(*p))) ++p;
+            if (!*p) break;
+            tokens[count] = p;
+            offsets[count] = static_cast<size_t>(p - fields);
+            count++;
+            while (*p && !std::isspace(static_cast<unsigned char>(*p))) ++p;
+            if (*p) *p++ = '\0';
+        }
+        if (count == 0) continue;
+        // Everything from field i to the end of the line
+        auto rest = [&](int i) { return i < count ? line + offsets[i] : ""; };
+
+        if (std::strcmp(tokens[0], "stage") == 0) {
+            if (count < 2) return fail("stage needs a name");
+            copyText(name, sizeof(name), rest(1));
+            continue;
+        }
+
+        if (count < 2) return fail("expected <time> <event>");
+        StageEvent e = {};
+        if (!parseTime(tokens[0], e.tick)) return fail("bad time");
+        if (e.tick < lastTick) return fail("events must be in time order");
+        lastTick = e.tick;
+
+        const char* op = tokens[1];
+        bool ok = true;
+        if (std::strcmp(op, "wave") == 0) {
+            e.type = StageEventType::WAVE;
+            ok = count >= 8 && parseInt(tokens[2], e.count) && parseFloat(tokens[3], e.x) &&
+                 parseFloat(tokens[4], e.y) && parseFloat(tokens[5], e.vx) && parseFloat(tokens[6], e.vy) &&
+                 parseInt(tokens[7], e.hp) &&
+                 (count < 9 || parseFloat(tokens[8], e.dx)) && (count < 10 || parseFloat(tokens[9], e.dy));
+            if (!ok) return fail("wave <count> <x> <y> <vx> <vy> <hp> [<dx> <dy>]");
+        } else if (std::strcmp(op, "pattern") == 0) {
+            e.type = StageEventType::PATTERN;
+            e.count = 1;
+            ok = count >= 5 && parseFloat(tokens[3], e.x) && parseFloat(tokens[4], e.y) &&
+                 (count < 6 || parseInt(tokens[5], e.count)) && (count < 7 || parseFloat(tokens[6], e.dx));
+            if (!ok) return fail("pattern <name> <x> <y> [<count> <dx>]");
+            e.program = patterns.find(tokens[2]);
+            if (e.program < 0) return fail("unknown pattern");
+        } else if (std::strcmp(op, "dialog") == 0) {
+            e.type = StageEventType::DIALOG;
+            if (count < 4 || !parseInt(tokens[2], e.count)) return fail("dialog <ticks> <text>");
+            copyText(e.text, sizeof(e.text), rest(3));
+        } else if (std::strcmp(op, "boss") == 0) {
+            e.type = StageEventType::BOSS;
+            ok = count >= 6 && parseInt(tokens[2], e.hp) && parseFloat(tokens[3], e.x) && parseFloat(tokens[4], e.y);
+            if (!ok) return fail("boss <hp> <x> <y> <name>");
+            copyText(e.text, sizeof(e.text), rest(5));
+        } else if (std::strcmp(op, "phase") == 0) {
+            e.type = StageEventType::PHASE;
+            if (count < 5 || !parseInt(tokens[3], e.count)) return fail("phase <pattern> <count> <name>");
+            e.program = patterns.find(tokens[2]);
+            if (e.program < 0) return fail("unknown pattern");
+            copyText(e.text, sizeof(e.text), rest(4));
+        } else if (std::strcmp(op, "clear") == 0) {
+            e.type = StageEventType::CLEAR;
+        } else if (std::strcmp(op, "end") == 0) {
+            e.type = StageEventType::END;
+        } else {
+            return fail("unknown event");
+        }
+        out = e;
+        return true;
+    }
+    return false;
+}
+
+bool Stage::start(const char* path, const PatternLibrary& patterns, int ticksPerSecond) {
+    stop();
+    if (!reader.open(path, ticksPerSecond)) {
+        SDL_Log("Could not open stage %s", path);
+        return false;
+    }
+    scheduler.reset(0);
+    haveLookahead = false;
+    readerDone = false;
+    running = true;
+    cleared = false;
+    dialogTicks = 0;
+    boss = Entity();
+
+    // Only the first few seconds are read now; the rest streams in as it nears
+    fill(patterns);
+    if (reader.failed()) {
+        SDL_Log("Stage %s %s", path, reader.errorMessage().c_str());
+    }
+    SDL_Log("Stage \"%s\" started, %u events in the first %u ticks", reader.stageName(),
+            static_cast<unsigned>(scheduler.pending()), LOOKAHEAD_TICKS);
+    return true;
+}
+
+void Stage::stop() {
+    reader.close();
+    scheduler.reset(0);
+    haveLookahead = false;
+    readerDone = true;
+    running = false;
+    dialogTicks = 0;
+    boss = Entity();
+}
+
+void Stage::saveState(StateWriter& out) const {
+    scheduler.saveState(out);
+    reader.saveState(out);
+    out.value(lookahead);
+    out.value(haveLookahead);
+    out.value(readerDone);
+    out.value(running);
+    out.value(cleared);
+    out.value(dialogText);
+    out.value(dialogTicks);
+    out.value(boss);
+    out.value(bossTitle);
+    out.value(phaseTitle);
+}
+
+bool Stage::loadState(StateReader& in) {
+    if (!scheduler.loadState(in) || !reader.loadState(in)) return false;
+    in.value(lookahead);
+    in.value(haveLookahead);
+    in.value(readerDone);
+    in.value(running);
+    in.value(cleared);
+    in.value(dialogText);
+    in.value(dialogTicks);
+    in.value(boss);
+    in.value(bossTitle);
+    in.value(phaseTitle);
+    return in.ok();
+}
+
+Uint32 Stage::nameHash() const {
+    if (!running) return 0;
+    Uint32 hash = 2166136261u;
+    for (const char* c = reader.stageName(); *c; ++c) {
+        hash ^= static_cast<Uint8>(*c);
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+void Stage::fill(const PatternLibrary& patterns) {
+    const Uint32 horizon = scheduler.now() + LOOKAHEAD_TICKS;
+    for (;;) {
+        if (!haveLookahead) {
+            if (readerDone) return;
+            if (!reader.next(patterns, lookahead)) {
+                if (reader.failed()) SDL_Log("Stage script %s", reader.errorMessage().c_str());
+                readerDone = true;
+                return;
+            }
+            haveLookahead = true;
+        }
+        // A full pool just leaves the event in the file a little longer
+        if (lookahead.tick > horizon || !scheduler.schedule(lookahead)) return;
+        haveLookahead = false;
+    }
+}
+
+void Stage::update(const PatternLibrary& patterns, EmitterPool& emitters, World& world, const Playfield& bounds) {
+    if (!running || cleared) return;
+    PROFILE_SCOPE("stage");
+    fill(patterns);
+    if (dialogTicks > 0) dialogTicks--;
+    scheduler.advance([&](const StageEvent& event) {
+        dispatch(event, patterns, emitters, world, bounds);
+    });
+    if (readerDone && !haveLookahead && scheduler.pending() == 0) {
+        cleared = true;
+    }
+}
+
+void Stage::dispatch(const StageEvent& e, const PatternLibrary& patterns, EmitterPool& emitters, World& world,
+                     const Playfield& bounds) {
+    switch (e.type) {
+    case StageEventType::WAVE:
+        for (int i = 0; i < e.count; ++i) {
+            EntitySystems::spawnEnemy(world, bounds.left + e.x + e.dx * i, bounds.top + e.y + e.dy * i,
+                                      e.vx, e.vy, e.hp);
+        }
+        break;
+    case StageEventType::PATTERN:
+        for (int i = 0; i < e.count; ++i) {
+            if (!emitters.spawn(patterns, e.program, bounds.left + e.x + e.dx * i, bounds.top + e.y)) break;
+        }
+        break;
+    case StageEventType::DIALOG:
+        copyText(dialogText, sizeof(dialogText), e.text);
+        dialogTicks = e.count;
+        break;
+    case StageEventType::BOSS:
+        boss = EntitySystems::spawnEnemy(world, bounds.left + e.x, bounds.top + e.y, 0.0f, 0.0f, e.hp);
+        copyText(bossTitle, sizeof(bossTitle), e.text);
+        phaseTitle[0] = '\0';
+        break;
+    case StageEventType::PHASE: {
+        if (!world.alive(boss)) break;
+        emitters.clear();
+        const Position& pos = *world.get<Position>(boss);
+        for (int i = 0; i < e.count; ++i) {
+            float offset = (i - (e.count - 1) * 0.5f) * 24.0f;
+            if (!emitters.spawn(patterns, e.program, pos.x + offset, pos.y)) break;
+        }
+        copyText(phaseTitle, sizeof(phaseTitle), e.text);
+        break;
+    }
+    case StageEventType::CLEAR:
+        emitters.clear();
+        break;
+    case StageEventType::END:
+        cleared = true;
+        break;
+    }
+}
@@ -0,0 +1,138 @@
+#include "StateSnapshot.h"
+#include <algorithm>
+
+StateHistory::StateHistory(size_t slots) {
+    resize(slots);
+}
+
+void StateHistory::resize(size_t slotCount) {
+    slots.clear();
+    slots.resize(slotCount);
+    head = 0;
+    count = 0;
+}
+
+void StateHistory::setDelta(bool enabled) {
+    // The slots already stored only make sense in the mode they were written
+    if (enabled != useDelta) clear();
+    useDelta = enabled;
+}
+
+void StateHistory::clear() {
+    head = 0;
+    count = 0;
+    newest.clear();
+}
+
+size_t StateHistory::storedBytes() const {
+    size_t words = useDelta ? newest.size() : 0;
+    for (size_t i = 0; i < count; ++i) {
+        words += slots[(head + slots.size() - 1 - i) % slots.size()].used;
+    }
+    return words * sizeof(Uint32);
+}
+
+// Runs of (unchanged words, changed words, their XORs) between the image
+// and prev, which is brought up to the image as it goes. The image counts as
+// zeros past its own words, for when prev is the longer of the two. Returns
+// the words written.
+size_t StateHistory::encodeRuns(const Uint8* image, size_t words, Uint32* prev, size_t total, Uint32* out) {
+    auto word = [image, words](size_t i) {
+        Uint32 w = 0;
+        if (i < words) std::memcpy(&w, image + i * sizeof(Uint32), sizeof(w));
+        return w;
+    };
+    size_t written = 0;
+    size_t i = 0;
+    while (i < total) {
+        const size_t sameStart = i;
+        while (i < total && word(i) == prev[i]) ++i;
+        const size_t changedStart = i;
+        Uint32* header = out + written;
+        written += 2;
+        for (; i < total; ++i) {
+            const Uint32 w = word(i);
+            if (w == prev[i]) break;
+            out[written++] = w ^ prev[i];
+            prev[i] = w;
+        }
+        header[0] = static_cast<Uint32>(changedStart - sameStart);
+        header[1] = static_cast<Uint32>(i - changedStart);
+    }
+    return written;
+}
+
+void StateHistory::push(Uint32 tick, const std::vector<Uint8>& image) {
+    if (slots.empty()) return;
+    const size_t words = image.size() / sizeof(Uint32);
+
+    Slot& slot = slots[head];
+    slot.tick = tick;
+    slot.words = static_cast<Uint32>(words);
+
+    if (!useDelta || count == 0) {
+        // Stored whole: delta is off, or there is nothing to XOR against
+        if (slot.data.size() < words) slot.data.resize(words);
+        std::memcpy(slot.data.data(), image.data(), image.size());
+        slot.used = words;
+        slot.delta = false;
+        slot.previousWords = 0;
+        if (useDelta) {
+            newest.resize(words);
+            std::memcpy(newest.data(), image.data(), image.size());
+        }
+    } else {
+        // Worst case alternates changed and unchanged words: 3 per 2. Coded
+        // into scratch first so each slot only grows to what it really used.
+        const size_t previousWords = newest.size();
+        const size_t total = std::max(words, previousWords);
+        const size_t bound = total + total / 2 + 2;
+        if (encoded.size() < bound) encoded.resize(bound);
+
+        // Zero-filled past the previous image, so a longer one XORs against zeros
+        if (previousWords < total) newest.resize(total);
+        const size_t used = encodeRuns(image.data(), words, newest.data(), total, encoded.data());
+        newest.resize(words);
+        if (slot.data.size() < used) slot.data.resize(used);
+        std::memcpy(slot.data.data(), encoded.data(), used * sizeof(Uint32));
+        slot.used = used;
+        slot.delta = true;
+        slot.previousWords = static_cast<Uint32>(previousWords);
+    }
+
+    head = (head + 1) % slots.size();
+    if (count < slots.size()) count++;
+}
+
+bool StateHistory::pop(std::vector<Uint8>& out, Uint32& tick) {
+    if (count == 0) return false;
+    const size_t top = (head + slots.size() - 1) % slots.size();
+    Slot& slot = slots[top];
+    tick = slot.tick;
+
+    if (!useDelta) {
+        const Uint8* bytes = reinterpret_cast<const Uint8*>(slot.data.data());
+        out.assign(bytes, bytes + slot.words * sizeof(Uint32));
+    } else {
+        const Uint8* bytes = reinterpret_cast<const Uint8*>(newest.data());
+        out.assign(bytes, bytes + newest.size() * sizeof(Uint32));
+        // newest ^ delta is the image pushed before it. The oldest slot's
+        // delta points at one the ring already dropped, so it stops there.
+        if (count > 1 && slot.delta) {
+            if (newest.size() < slot.previousWords) newest.resize(slot.previousWords); // zero-filled
+            const Uint32* runs = slot.data.data();
+            size_t i = 0;
+            for (size_t p = 0; p < slot.used;) {
+                i += runs[p++];
+                Uint32 literals = runs[p++];
+                for (Uint32 k = 0; k < literals; ++k) newest[i++] ^= runs[p++];
+            }
+            newest.resize(slot.previousWords);
+        }
+    }
+
+    head = top;
+    count--;
+    if (count == 0) newest.clear();
+    return true;
+}
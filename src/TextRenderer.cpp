@@ -0,0 +1,232 @@
+#include "TextRenderer.h"
+#include <iostream>
+#include <cstring>
+
+namespace {
+
+// FNV-1a, good enough to pick a cache slot without building a std::string per lookup
+Uint64 hashText(const char* text) {
+    Uint64 hash = 14695981039346656037ull;
+    for (const char* c = text; *c; ++c) {
+        hash ^= static_cast<unsigned char>(*c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}
+
+bool GlyphAtlas::build(TTF_Font* font) {
+    freeSurface();
+    fontHeight = TTF_FontHeight(font);
+
+    // Render every glyph once, then shelf-pack them into one atlas surface
+    SDL_Surface* glyphSurfaces[GLYPH_COUNT] = {};
+    SDL_Color white = { 255, 255, 255, 255 };
+    const int atlasMaxWidth = 512;
+    const int padding = 1;
+    int penX = padding;
+    int penY = padding;
+    int shelfHeight = 0;
+
+    for (int i = 0; i < GLYPH_COUNT; ++i) {
+        char str[2] = { static_cast<char>(FIRST_GLYPH + i), '\0' };
+        Uint16 ch = static_cast<Uint16>(FIRST_GLYPH + i);
+
+        int minX = 0, maxX = 0, minY = 0, maxY = 0, advance = 0;
+        if (TTF_GlyphMetrics(font, ch, &minX, &maxX, &minY, &maxY, &advance) != 0) {
+            advance = 0;
+        }
+        glyphs[i] = Glyph();
+        glyphs[i].advance = advance;
+        glyphs[i].offsetX = minX < 0 ? minX : 0;
+
+        // Space has no pixels; TTF refuses to render an empty line
+        if (ch == ' ') continue;
+
+        SDL_Surface* glyphSurface = TTF_RenderText_Blended(font, str, white);
+        if (!glyphSurface) continue;
+        glyphSurfaces[i] = glyphSurface;
+
+        if (penX + glyphSurface->w + padding > atlasMaxWidth) {
+            penX = padding;
+            penY += shelfHeight + padding;
+            shelfHeight = 0;
+        }
+        glyphs[i].src = { penX, penY, glyphSurface->w, glyphSurface->h };
+        penX += glyphSurface->w + padding;
+        if (glyphSurface->h > shelfHeight) shelfHeight = glyphSurface->h;
+    }
+
+    width = atlasMaxWidth;
+    height = penY + shelfHeight + padding;
+
+    surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) {
+        std::cerr << "Failed to create glyph atlas surface! SDL_Error: " << SDL_GetError() << "\n";
+        for (SDL_Surface* s : glyphSurfaces) if (s) SDL_FreeSurface(s);
+        return false;
+    }
+    SDL_FillRect(surface, NULL, 0);
+
+    for (int i = 0; i < GLYPH_COUNT; ++i) {
+        if (!glyphSurfaces[i]) continue;
+        // Copy the glyph's alpha as-is instead of blending it onto the empty atlas
+        SDL_SetSurfaceBlendMode(glyphSurfaces[i], SDL_BLENDMODE_NONE);
+        SDL_Rect dst = glyphs[i].src;
+        SDL_BlitSurface(glyphSurfaces[i], NULL, surface, &dst);
+        SDL_FreeSurface(glyphSurfaces[i]);
+    }
+    return true;
+}
+
+void GlyphAtlas::freeSurface() {
+    if (surface) {
+        SDL_FreeSurface(surface);
+        surface = nullptr;
+    }
+}
+
+bool TextRenderer::init(SDL_Renderer* renderer, TTF_Font* font, SpriteBatch* batch) {
+    GlyphAtlas glyphAtlas;
+    if (!glyphAtlas.build(font)) return false;
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, glyphAtlas.surface);
+    if (texture) batch->backend().registerTexture(texture, glyphAtlas.surface);
+    glyphAtlas.freeSurface();
+    if (!texture) {
+        std::cerr << "Failed to create glyph atlas texture! SDL_Error: " << SDL_GetError() << "\n";
+        return false;
+    }
+    setup(font, glyphAtlas, texture, batch);
+    ownsAtlas = true;
+    return true;
+}
+
+bool TextRenderer::init(TTF_Font* font, const GlyphAtlas& glyphAtlas, SDL_Texture* texture, SpriteBatch* batch) {
+    if (!font || !texture) return false;
+    setup(font, glyphAtlas, texture, batch);
+    ownsAtlas = false;
+    return true;
+}
+
+void TextRenderer::setup(TTF_Font* font, const GlyphAtlas& glyphAtlas, SDL_Texture* texture, SpriteBatch* batch) {
+    this->batch = batch;
+    this->font = font;
+    atlas = texture;
+    atlasWidth = glyphAtlas.width;
+    atlasHeight = glyphAtlas.height;
+    fontHeight = glyphAtlas.fontHeight;
+    for (int i = 0; i < GLYPH_COUNT; ++i) glyphs[i] = glyphAtlas.glyphs[i];
+    SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+
+    // Every slot can take its longest string without growing later
+    for (TextLayout& layout : layouts) {
+        layout.text[0] = '\0';
+        layout.vertices.reserve(MAX_CACHED_CHARS * 4);
+    }
+}
+
+void TextRenderer::cleanup() {
+    if (atlas && ownsAtlas) {
+        batch->backend().destroyTexture(atlas);
+    }
+    atlas = nullptr;
+    for (TextLayout& layout : layouts) layout.text[0] = '\0';
+}
+
+void TextRenderer::buildLayout(const char* text, TextLayout& layout) {
+    layout.vertices.clear();
+    layout.height = fontHeight;
+
+    const float invW = 1.0f / atlasWidth;
+    const float invH = 1.0f / atlasHeight;
+    int penX = 0;
+    int width = 0;
+    Uint16 prev = 0;
+
+    for (const char* c = text; *c; ++c) {
+        int ch = static_cast<unsigned char>(*c);
+        if (ch < FIRST_GLYPH || ch > LAST_GLYPH) ch = '?';
+        const Glyph& g = glyphs[ch - FIRST_GLYPH];
+
+        if (prev) penX += TTF_GetFontKerningSizeGlyphs(font, prev, static_cast<Uint16>(ch));
+        prev = static_cast<Uint16>(ch);
+
+        if (g.src.w > 0) {
+            float x0 = static_cast<float>(penX + g.offsetX);
+            float y0 = 0.0f;
+            float x1 = x0 + g.src.w;
+            float y1 = y0 + g.src.h;
+            float u0 = g.src.x * invW;
+            float v0 = g.src.y * invH;
+            float u1 = (g.src.x + g.src.w) * invW;
+            float v1 = (g.src.y + g.src.h) * invH;
+            SDL_Color white = { 255, 255, 255, 255 };
+
+            layout.vertices.push_back({ { x0, y0 }, white, { u0, v0 } });
+            layout.vertices.push_back({ { x1, y0 }, white, { u1, v0 } });
+            layout.vertices.push_back({ { x0, y1 }, white, { u0, v1 } });
+            layout.vertices.push_back({ { x1, y1 }, white, { u1, v1 } });
+
+            if (penX + g.offsetX + g.src.w > width) width = penX + g.offsetX + g.src.w;
+        }
+        penX += g.advance;
+    }
+
+    layout.width = penX > width ? penX : width;
+}
+
+const TextRenderer::TextLayout& TextRenderer::getLayout(const char* text) {
+    size_t length = std::strlen(text);
+    if (length > MAX_CACHED_CHARS) {
+        buildLayout(text, scratchLayout);
+        return scratchLayout;
+    }
+
+    Uint64 key = hashText(text);
+    TextLayout& layout = layouts[key & (MAX_CACHED_LAYOUTS - 1)];
+    if (layout.key == key && std::strcmp(layout.text, text) == 0) return layout;
+
+    // Miss: whatever was in this slot gets laid out again if it comes back
+    std::memcpy(layout.text, text, length + 1);
+    layout.key = key;
+    buildLayout(text, layout);
+    return layout;
+}
+
+void TextRenderer::drawText(const char* text, int x, int y, SDL_Color color, Uint8 layer) {
+    if (!atlas || !text || !*text) return;
+
+    const TextLayout& layout = getLayout(text);
+    size_t vertexCount = layout.vertices.size();
+    if (vertexCount == 0) return;
+
+    // Offset and tint into the batch so the cached layout stays position-free
+    SDL_Vertex* dst = batch->reserveQuads(atlas, SDL_BLENDMODE_BLEND, layer, vertexCount / 4);
+    const float fx = static_cast<float>(x);
+    const float fy = static_cast<float>(y);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const SDL_Vertex& src = layout.vertices[i];
+        dst[i].position.x = src.position.x + fx;
+        dst[i].position.y = src.position.y + fy;
+        dst[i].color = color;
+        dst[i].tex_coord = src.tex_coord;
+    }
+}
+
+void TextRenderer::measureText(const char* text, int* w, int* h) {
+    if (!atlas) {
+        if (w) *w = 0;
+        if (h) *h = 0;
+        return;
+    }
+    if (!text || !*text) {
+        if (w) *w = 0;
+        if (h) *h = fontHeight;
+        return;
+    }
+    const TextLayout& layout = getLayout(text);
+    if (w) *w = layout.width;
+    if (h) *h = layout.height;
+}
@@ -0,0 +1,260 @@
+#include "World.h"
+#include <cstdlib>
+#include "StateSnapshot.h"
+
+namespace {
+
+std::vector<size_t>& componentSizes() {
+    static std::vector<size_t> sizes;
+    return sizes;
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+int ComponentRegistry::registerType(size_t size) {
+    std::vector<size_t>& sizes = componentSizes();
+    if (sizes.size() >= static_cast<size_t>(MAX_COMPONENTS)) {
+        SDL_Log("Too many component types (max %d)", MAX_COMPONENTS);
+        std::abort();
+    }
+    sizes.push_back(size);
+    return static_cast<int>(sizes.size() - 1);
+}
+
+size_t ComponentRegistry::size(int id) {
+    return componentSizes()[id];
+}
+
+Archetype::Archetype(ComponentMask mask, BlockPool& chunkPool) : componentBits(mask), pool(chunkPool) {
+    for (int i = 0; i < ComponentRegistry::MAX_COMPONENTS; ++i) {
+        columnOf[i] = -1;
+        if (mask & (ComponentMask(1) << i)) {
+            columnOf[i] = static_cast<Sint8>(ids.size());
+            ids.push_back(i);
+            sizes.push_back(ComponentRegistry::size(i));
+        }
+    }
+
+    // As many rows as fit once every array is padded to 16 bytes
+    size_t rowBytes = sizeof(Entity);
+    for (size_t s : sizes) rowBytes += s;
+    size_t capacity = CHUNK_BYTES / rowBytes;
+    offsets.resize(ids.size());
+    for (; capacity > 0; --capacity) {
+        size_t offset = alignUp(capacity * sizeof(Entity), 16);
+        for (size_t i = 0; i < ids.size(); ++i) {
+            offsets[i] = offset;
+            offset = alignUp(offset + capacity * sizes[i], 16);
+        }
+        if (offset <= CHUNK_BYTES) break;
+    }
+    chunkCapacity = static_cast<Uint32>(capacity > 0 ? capacity : 1);
+}
+
+Archetype::~Archetype() {
+    for (Chunk& c : chunks) pool.release(c.data);
+}
+
+void Archetype::pushRow(Entity e, Uint32& chunkIndex, Uint32& row) {
+    if (chunks.empty() || chunks.back().count == chunkCapacity) {
+        Chunk c;
+        c.data = static_cast<Uint8*>(pool.acquire());
+        chunks.push_back(c);
+    }
+    Chunk& c = chunks.back();
+    chunkIndex = static_cast<Uint32>(chunks.size() - 1);
+    row = c.count++;
+    entities(c)[row] = e;
+    entityCount++;
+}
+
+Entity Archetype::swapRemove(Uint32 chunkIndex, Uint32 row) {
+    Chunk& last = chunks.back();
+    Uint32 lastRow = last.count - 1;
+    Entity moved;
+
+    if (chunkIndex != chunks.size() - 1 || row != lastRow) {
+        Chunk& hole = chunks[chunkIndex];
+        moved = entities(last)[lastRow];
+        entities(hole)[row] = moved;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            std::memcpy(hole.data + offsets[i] + row * sizes[i], last.data + offsets[i] + lastRow * sizes[i], sizes[i]);
+        }
+    }
+    last.count--;
+    if (last.count == 0) {
+        pool.release(last.data);
+        chunks.pop_back();
+    }
+    entityCount--;
+    return moved;
+}
+
+World::World() : chunkPool(Archetype::CHUNK_BYTES, CHUNKS_PER_SLAB) {}
+
+Archetype& World::findOrCreate(ComponentMask mask) {
+    for (std::unique_ptr<Archetype>& arch : archetypes) {
+        if (arch->mask() == mask) return *arch;
+    }
+    archetypes.push_back(std::make_unique<Archetype>(mask, chunkPool));
+    return *archetypes.back();
+}
+
+Entity World::allocateEntity() {
+    Entity e;
+    if (!freeIndices.empty()) {
+        e.index = freeIndices.back();
+        freeIndices.pop_back();
+    } else {
+        e.index = static_cast<Uint32>(records.size());
+        records.push_back(Record());
+    }
+    e.generation = records[e.index].generation;
+    liveCount++;
+    return e;
+}
+
+void World::place(Entity e, Archetype& arch) {
+    Record& r = records[e.index];
+    r.archetype = &arch;
+    arch.pushRow(e, r.chunk, r.row);
+}
+
+void World::removeRow(Record& record) {
+    Entity moved = record.archetype->swapRemove(record.chunk, record.row);
+    if (moved.valid()) {
+        records[moved.index].chunk = record.chunk;
+        records[moved.index].row = record.row;
+    }
+}
+
+void World::destroy(Entity e) {
+    if (!alive(e)) return;
+    Record& r = records[e.index];
+    removeRow(r);
+    r.archetype = nullptr;
+    r.generation++; // stale handles stop matching
+    freeIndices.push_back(e.index);
+    liveCount--;
+}
+
+void World::flushDestroyed() {
+    // destroy() ignores handles that are already dead, so duplicates are fine
+    for (Entity e : pendingDestroy) destroy(e);
+    pendingDestroy.clear();
+}
+
+void World::clear() {
+    for (size_t i = 0; i < records.size(); ++i) {
+        Record& r = records[i];
+        if (r.archetype) {
+            r.archetype = nullptr;
+            r.generation++;
+        }
+    }
+    for (std::unique_ptr<Archetype>& arch : archetypes) {
+        for (Archetype::Chunk& c : arch->chunks) arch->pool.release(c.data);
+        arch->chunks.clear();
+        arch->entityCount = 0;
+    }
+    // Hand indices out again from zero, so a cleared world numbers its
+    // entities exactly like a fresh one
+    freeIndices.clear();
+    for (size_t i = records.size(); i > 0; --i) freeIndices.push_back(static_cast<Uint32>(i - 1));
+    pendingDestroy.clear();
+    liveCount = 0;
+}
+
+void World::saveState(StateWriter& out) const {
+    out.value(liveCount);
+    out.value(records.size());
+    out.array(records.data(), records.size());
+    out.value(freeIndices.size());
+    out.array(freeIndices.data(), freeIndices.size());
+
+    out.value(archetypes.size());
+    for (const std::unique_ptr<Archetype>& arch : archetypes) {
+        out.value(arch->entityCount);
+        out.value(arch->chunks.size());
+        for (const Archetype::Chunk& c : arch->chunks) {
+            out.value(c.count);
+            out.array(arch->entities(c), c.count);
+            for (size_t i = 0; i < arch->ids.size(); ++i) {
+                out.write(c.data + arch->offsets[i], c.count * arch->sizes[i]);
+            }
+        }
+    }
+}
+
+bool World::loadState(StateReader& in) {
+    size_t recordCount = 0;
+    size_t freeCount = 0;
+    size_t archetypeCount = 0;
+    in.value(liveCount);
+    if (!in.value(recordCount)) return false;
+    records.resize(recordCount);
+    in.array(records.data(), recordCount);
+    if (!in.value(freeCount)) return false;
+    freeIndices.resize(freeCount);
+    in.array(freeIndices.data(), freeCount);
+    pendingDestroy.clear();
+
+    // Archetypes made since the image was written are simply left empty
+    if (!in.value(archetypeCount) || archetypeCount > archetypes.size()) return false;
+    for (size_t a = 0; a < archetypes.size(); ++a) {
+        Archetype& arch = *archetypes[a];
+        size_t chunkCount = 0;
+        arch.entityCount = 0;
+        if (a < archetypeCount && (!in.value(arch.entityCount) || !in.value(chunkCount))) return false;
+
+        // Same number of chunks as then, through the pool
+        while (arch.chunks.size() > chunkCount) {
+            arch.pool.release(arch.chunks.back().data);
+            arch.chunks.pop_back();
+        }
+        while (arch.chunks.size() < chunkCount) {
+            Archetype::Chunk c;
+            c.data = static_cast<Uint8*>(arch.pool.acquire());
+            arch.chunks.push_back(c);
+        }
+        for (Archetype::Chunk& c : arch.chunks) {
+            if (!in.value(c.count) || c.count > arch.chunkCapacity) return false;
+            in.array(arch.entities(c), c.count);
+            for (size_t i = 0; i < arch.ids.size(); ++i) {
+                in.read(c.data + arch.offsets[i], c.count * arch.sizes[i]);
+            }
+        }
+    }
+    return in.ok();
+}
+
+void World::migrate(Entity e, ComponentMask newMask) {
+    Record& r = records[e.index];
+    Archetype& from = *r.archetype;
+    Archetype& to = findOrCreate(newMask);
+    Archetype::Chunk& src = from.chunk(r.chunk);
+    const Uint32 srcRow = r.row;
+
+    Uint32 chunkIndex = 0;
+    Uint32 row = 0;
+    to.pushRow(e, chunkIndex, row);
+    Archetype::Chunk& dst = to.chunk(chunkIndex);
+    for (size_t i = 0; i < to.ids.size(); ++i) {
+        void* fromColumn = from.column(src, to.ids[i]);
+        Uint8* toSlot = dst.data + to.offsets[i] + row * to.sizes[i];
+        if (fromColumn) {
+            std::memcpy(toSlot, static_cast<Uint8*>(fromColumn) + srcRow * to.sizes[i], to.sizes[i]);
+        } else {
+            std::memset(toSlot, 0, to.sizes[i]);
+        }
+    }
+
+    removeRow(r);
+    r.archetype = &to;
+    r.chunk = chunkIndex;
+    r.row = row;
+}
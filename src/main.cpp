@@ -1,10 +1,120 @@
 #include "Engine.h"
+#include <cstring>
+#include <cstdlib>
 
 int main(int argc, char* argv[]) {
+    // Before anything calls into SDL, so its allocations are counted too
+    AllocationTracker::installSdlHooks();
+
     Engine engine("DANGAME33", 640, 480);
+
+    int benchFrames = 0;
+    const char* benchOut = nullptr;
+    const char* tracePath = nullptr;
+    const char* replayPath = nullptr;
+    bool replayFast = false;
+    const BenchScenario* scenario = nullptr;
+    int threads = 0;
+    int rewindSeconds = 0;
+    bool rewindDelta = true;
+
+    // Frame pacing: --vsync, --fps <hz> (capped, the default at 60) or --uncapped
+    // Benchmark: --bench <frames> [--bench-out results.json|.csv] [--trace trace.json] [--headless]
+    // Recording: --record <file>, --replay <file> [--fast]
+    // Capture: --capture <file.qoi> (every presented frame as a QOI stream, index in <file>.csv)
+    // Bullets: --scenario <id> (1 = rings, 2 = boss patterns, 3 = enemy swarm, 4 = lasers), for play and --bench
+    // Stage: --stage <file> (waves, patterns, dialog and the boss from a stage script)
+    // Simulation: --threads <n> (default one per CPU; 1 runs every job inline),
+    //             --sim-thread (tick on a thread of its own; the main one only draws)
+    // Input: --late-latch (draw the player from keys read just before present)
+    // Rewind: --rewind <seconds> (hold Backspace to step back), --rewind-raw (whole snapshots, no XOR delta)
+    // Memory: --assert-no-alloc (abort on heap use while playing; needs ENGINE_TRACK_ALLOCATIONS)
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--vsync") == 0) {
+            engine.setFramePacing(PacingMode::VSYNC);
+        } else if (std::strcmp(argv[i], "--uncapped") == 0) {
+            engine.setFramePacing(PacingMode::UNCAPPED);
+        } else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            engine.setFramePacing(PacingMode::CAPPED, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            engine.setHeadless(true);
+        } else if (std::strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            benchFrames = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc) {
+            benchOut = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            engine.recordTo(argv[++i]);
+        } else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            engine.captureTo(argv[++i]);
+        } else if (std::strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            scenario = BenchScenario::find(static_cast<Uint32>(std::atoi(argv[++i])));
+            if (!scenario) {
+                SDL_Log("Unknown scenario %s", argv[i]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--stage") == 0 && i + 1 < argc) {
+            engine.setStage(argv[++i]);
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--fast") == 0) {
+            replayFast = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--sim-thread") == 0) {
+            engine.setSimulationThread(true);
+        } else if (std::strcmp(argv[i], "--rewind") == 0 && i + 1 < argc) {
+            rewindSeconds = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--rewind-raw") == 0) {
+            rewindDelta = false;
+        } else if (std::strcmp(argv[i], "--late-latch") == 0) {
+            engine.setLateLatch(true);
+        } else if (std::strcmp(argv[i], "--assert-no-alloc") == 0) {
+            engine.setAssertNoAllocations(true);
+        }
+    }
+
+    engine.setScenario(scenario);
+    engine.setThreadCount(threads);
+    engine.setRewind(rewindSeconds, rewindDelta);
+
+    // Fast replay never opens a window: simulation only, as fast as it goes
+    if (replayPath && replayFast) {
+        if (tracePath) Profiler::get().startCapture();
+        bool match = engine.replayFast(replayPath);
+        if (tracePath && !Profiler::get().stopCapture(tracePath)) {
+            SDL_Log("Could not write %s", tracePath);
+        }
+        return match ? 0 : 1;
+    }
+
+    int result = 0;
     if (engine.init()) {
-        engine.run();
+        if (benchFrames > 0) {
+            FrameTimings timings;
+            if (tracePath) Profiler::get().startCapture();
+            engine.runScenario(scenario ? *scenario : BenchScenario::standard(), benchFrames, timings);
+            if (tracePath && !Profiler::get().stopCapture(tracePath)) {
+                SDL_Log("Could not write %s", tracePath);
+            }
+            timings.print();
+            if (benchOut && !timings.write(benchOut)) {
+                SDL_Log("Could not write %s", benchOut);
+                result = 1;
+            }
+        } else if (replayPath) {
+            if (engine.startPlayback(replayPath)) {
+                engine.run();
+            } else {
+                result = 1;
+            }
+        } else {
+            engine.run();
+        }
+    } else {
+        result = 1;
     }
     engine.cleanup();
-    return 0;
+    return result;
 }
@@ -0,0 +1,117 @@
+#pragma once
+#include <SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Tiny benchmark runner shared by the bench tools: warm up, time a number of
+// repetitions with the performance counter, report median and median absolute
+// deviation (both robust against the odd scheduler hiccup), and dump results
+// as a table, CSV or JSON.
+struct BenchResult {
+    std::string name;
+    std::string param;
+    double itemsPerRep = 1.0;
+    int reps = 0;
+    double medianNs = 0.0;
+    double madNs = 0.0;
+    double minNs = 0.0;
+
+    double perItemNs() const { return itemsPerRep > 0.0 ? medianNs / itemsPerRep : medianNs; }
+};
+
+class BenchRunner {
+public:
+    BenchRunner(int warmup = 3, int reps = 21) : warmup(warmup), reps(reps) {}
+
+    void setRepetitions(int warmupReps, int measuredReps) {
+        warmup = warmupReps;
+        reps = measuredReps > 0 ? measuredReps : 1;
+    }
+
+    // fn() runs one repetition covering itemsPerRep items
+    template<typename Fn>
+    const BenchResult& run(const std::string& name, const std::string& param, double itemsPerRep, Fn&& fn) {
+        for (int i = 0; i < warmup; ++i) fn();
+
+        samples.resize(reps);
+        const double nsPerTick = 1e9 / static_cast<double>(SDL_GetPerformanceFrequency());
+        for (int i = 0; i < reps; ++i) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            fn();
+            samples[i] = static_cast<double>(SDL_GetPerformanceCounter() - start) * nsPerTick;
+        }
+
+        BenchResult r;
+        r.name = name;
+        r.param = param;
+        r.itemsPerRep = itemsPerRep;
+        r.reps = reps;
+        r.medianNs = median(samples);
+        r.minNs = *std::min_element(samples.begin(), samples.end());
+        for (double& s : samples) s = std::fabs(s - r.medianNs);
+        r.madNs = median(samples);
+
+        results.push_back(r);
+        std::printf("%-28s %-12s median %12.1f ns  mad %10.1f ns  per item %10.2f ns\n",
+                    r.name.c_str(), r.param.c_str(), r.medianNs, r.madNs, r.perItemNs());
+        std::fflush(stdout);
+        return results.back();
+    }
+
+    const std::vector<BenchResult>& getResults() const { return results; }
+
+    bool writeCsv(const char* path) const {
+        FILE* f = std::fopen(path, "w");
+        if (!f) return false;
+        std::fprintf(f, "name,param,items_per_rep,reps,median_ns,mad_ns,min_ns,per_item_ns\n");
+        for (const BenchResult& r : results) {
+            std::fprintf(f, "%s,%s,%.0f,%d,%.1f,%.1f,%.1f,%.3f\n", r.name.c_str(), r.param.c_str(),
+                         r.itemsPerRep, r.reps, r.medianNs, r.madNs, r.minNs, r.perItemNs());
+        }
+        std::fclose(f);
+        return true;
+    }
+
+    bool writeJson(const char* path) const {
+        FILE* f = std::fopen(path, "w");
+        if (!f) return false;
+        std::fprintf(f, "{\n  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchResult& r = results[i];
+            std::fprintf(f, "    {\"name\": \"%s\", \"param\": \"%s\", \"items_per_rep\": %.0f, \"reps\": %d, "
+                            "\"median_ns\": %.1f, \"mad_ns\": %.1f, \"min_ns\": %.1f, \"per_item_ns\": %.3f}%s\n",
+                         r.name.c_str(), r.param.c_str(), r.itemsPerRep, r.reps, r.medianNs, r.madNs,
+                         r.minNs, r.perItemNs(), i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(f, "  ]\n}\n");
+        std::fclose(f);
+        return true;
+    }
+
+    // Writes CSV or JSON depending on the extension
+    bool write(const char* path) const {
+        std::string p(path);
+        if (p.size() >= 4 && p.compare(p.size() - 4, 4, ".csv") == 0) return writeCsv(path);
+        return writeJson(path);
+    }
+
+private:
+    int warmup;
+    int reps;
+    std::vector<double> samples;
+    std::vector<BenchResult> results;
+
+    static double median(std::vector<double>& v) {
+        size_t mid = v.size() / 2;
+        std::nth_element(v.begin(), v.begin() + mid, v.end());
+        double m = v[mid];
+        if (v.size() % 2 == 0) {
+            double lower = *std::max_element(v.begin(), v.begin() + mid);
+            m = (m + lower) * 0.5;
+        }
+        return m;
+    }
+};
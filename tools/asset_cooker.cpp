@@ -0,0 +1,232 @@
+// Packs every PNG under an asset directory into assets.pack: pages of
+// pre-decoded, premultiplied RGBA plus a sorted sprite-name -> UV table.
+// See include/AssetPack.h for the file layout.
+//
+//   asset_cooker <asset dir> <output pack> [--page-size N]
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <SDL_image.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct InputImage {
+    std::string name;
+    SDL_Surface* surface = nullptr; // RGBA32, premultiplied in place
+    int page = -1;
+    int x = 0;
+    int y = 0;
+};
+
+struct OutputPage {
+    int width = 0;
+    int height = 0;
+    std::vector<Uint8> pixels;
+};
+
+Uint64 alignUp(Uint64 value, Uint64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void premultiply(SDL_Surface* s) {
+    for (int y = 0; y < s->h; ++y) {
+        Uint8* row = static_cast<Uint8*>(s->pixels) + y * s->pitch;
+        for (int x = 0; x < s->w; ++x) {
+            Uint8* p = row + x * 4;
+            unsigned a = p[3];
+            p[0] = static_cast<Uint8>((p[0] * a + 127) / 255);
+            p[1] = static_cast<Uint8>((p[1] * a + 127) / 255);
+            p[2] = static_cast<Uint8>((p[2] * a + 127) / 255);
+        }
+    }
+}
+
+// Shelf packer: tallest images first, new page when one fills up
+bool packImages(std::vector<InputImage*>& images, int pageSize, std::vector<OutputPage>& pages) {
+    std::sort(images.begin(), images.end(), [](const InputImage* a, const InputImage* b) {
+        if (a->surface->h != b->surface->h) return a->surface->h > b->surface->h;
+        return a->name < b->name;
+    });
+
+    const int padding = 1;
+    int penX = padding, penY = padding, shelfHeight = 0;
+    int pageIndex = -1;
+
+    for (InputImage* img : images) {
+        int w = img->surface->w;
+        int h = img->surface->h;
+        if (w + 2 * padding > pageSize || h + 2 * padding > pageSize) {
+            std::fprintf(stderr, "%s (%dx%d) does not fit in a %d page\n", img->name.c_str(), w, h, pageSize);
+            return false;
+        }
+        if (pageIndex < 0 || penX + w + padding > pageSize) {
+            penX = padding;
+            penY += shelfHeight + padding;
+            shelfHeight = 0;
+        }
+        if (pageIndex < 0 || penY + h + padding > pageSize) {
+            pages.emplace_back();
+            pageIndex = static_cast<int>(pages.size() - 1);
+            penX = padding;
+            penY = padding;
+            shelfHeight = 0;
+        }
+        img->page = pageIndex;
+        img->x = penX;
+        img->y = penY;
+        penX += w + padding;
+        if (h > shelfHeight) shelfHeight = h;
+
+        OutputPage& page = pages[pageIndex];
+        if (penX > page.width) page.width = penX;
+        if (penY + h + padding > page.height) page.height = penY + h + padding;
+    }
+
+    // Pages only need to be as large as what's on them
+    for (OutputPage& page : pages) {
+        page.pixels.assign(static_cast<size_t>(page.width) * page.height * 4, 0);
+    }
+    for (InputImage* img : images) {
+        OutputPage& page = pages[img->page];
+        for (int y = 0; y < img->surface->h; ++y) {
+            const Uint8* src = static_cast<const Uint8*>(img->surface->pixels) + y * img->surface->pitch;
+            Uint8* dst = &page.pixels[(static_cast<size_t>(img->y + y) * page.width + img->x) * 4];
+            std::memcpy(dst, src, static_cast<size_t>(img->surface->w) * 4);
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: asset_cooker <asset dir> <output pack> [--page-size N]\n");
+        return 1;
+    }
+    const fs::path inputDir = argv[1];
+    const char* outputPath = argv[2];
+    int pageSize = 2048;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--page-size") == 0 && i + 1 < argc) pageSize = std::atoi(argv[++i]);
+    }
+
+    SDL_SetMainReady();
+    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+        std::fprintf(stderr, "SDL_image could not initialize: %s\n", IMG_GetError());
+        return 1;
+    }
+
+    std::vector<InputImage> images;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(inputDir, ec), end; it != end && !ec; it.increment(ec)) {
+        if (!it->is_regular_file()) continue;
+        std::string ext = it->path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (ext != ".png") continue;
+
+        std::string name = fs::relative(it->path(), inputDir).replace_extension().generic_string();
+        if (name.size() >= static_cast<size_t>(pack::NAME_LENGTH)) {
+            std::fprintf(stderr, "Sprite name too long: %s\n", name.c_str());
+            return 1;
+        }
+
+        SDL_Surface* loaded = IMG_Load(it->path().string().c_str());
+        if (!loaded) {
+            std::fprintf(stderr, "Failed to load %s: %s\n", it->path().string().c_str(), IMG_GetError());
+            return 1;
+        }
+        SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(loaded);
+        if (!rgba) {
+            std::fprintf(stderr, "Failed to convert %s: %s\n", name.c_str(), SDL_GetError());
+            return 1;
+        }
+        premultiply(rgba);
+
+        InputImage img;
+        img.name = name;
+        img.surface = rgba;
+        images.push_back(img);
+    }
+    if (ec) {
+        std::fprintf(stderr, "Could not scan %s: %s\n", inputDir.string().c_str(), ec.message().c_str());
+        return 1;
+    }
+
+    std::vector<InputImage*> order;
+    for (InputImage& img : images) order.push_back(&img);
+    std::vector<OutputPage> pages;
+    if (!packImages(order, pageSize, pages)) return 1;
+
+    // Sprite table sorted by name so the runtime can binary search it
+    std::sort(images.begin(), images.end(), [](const InputImage& a, const InputImage& b) { return a.name < b.name; });
+
+    pack::PackHeader header = {};
+    header.magic = pack::MAGIC;
+    header.version = pack::VERSION;
+    header.pageCount = static_cast<Uint32>(pages.size());
+    header.spriteCount = static_cast<Uint32>(images.size());
+    header.pageTableOffset = sizeof(pack::PackHeader);
+    header.spriteTableOffset = header.pageTableOffset + header.pageCount * sizeof(pack::PackPage);
+
+    std::vector<pack::PackPage> pageTable(pages.size());
+    Uint64 offset = alignUp(header.spriteTableOffset + Uint64(header.spriteCount) * sizeof(pack::PackSprite), 64);
+    for (size_t i = 0; i < pages.size(); ++i) {
+        pageTable[i].width = static_cast<Uint32>(pages[i].width);
+        pageTable[i].height = static_cast<Uint32>(pages[i].height);
+        pageTable[i].pitch = static_cast<Uint32>(pages[i].width * 4);
+        pageTable[i].reserved = 0;
+        pageTable[i].pixelOffset = offset;
+        offset = alignUp(offset + pages[i].pixels.size(), 64);
+    }
+
+    std::vector<pack::PackSprite> spriteTable(images.size());
+    for (size_t i = 0; i < images.size(); ++i) {
+        const InputImage& img = images[i];
+        const OutputPage& page = pages[img.page];
+        pack::PackSprite& s = spriteTable[i];
+        std::memset(&s, 0, sizeof(s));
+        std::memcpy(s.name, img.name.c_str(), img.name.size());
+        s.page = static_cast<Uint32>(img.page);
+        s.x = static_cast<Uint16>(img.x);
+        s.y = static_cast<Uint16>(img.y);
+        s.w = static_cast<Uint16>(img.surface->w);
+        s.h = static_cast<Uint16>(img.surface->h);
+        s.u0 = static_cast<float>(img.x) / page.width;
+        s.v0 = static_cast<float>(img.y) / page.height;
+        s.u1 = static_cast<float>(img.x + img.surface->w) / page.width;
+        s.v1 = static_cast<float>(img.y + img.surface->h) / page.height;
+    }
+
+    FILE* out = std::fopen(outputPath, "wb");
+    if (!out) {
+        std::fprintf(stderr, "Could not open %s for writing\n", outputPath);
+        return 1;
+    }
+    std::fwrite(&header, sizeof(header), 1, out);
+    std::fwrite(pageTable.data(), sizeof(pack::PackPage), pageTable.size(), out);
+    std::fwrite(spriteTable.data(), sizeof(pack::PackSprite), spriteTable.size(), out);
+    for (size_t i = 0; i < pages.size(); ++i) {
+        long pos = std::ftell(out);
+        static const Uint8 zeros[64] = {};
+        std::fwrite(zeros, 1, static_cast<size_t>(pageTable[i].pixelOffset - static_cast<Uint64>(pos)), out);
+        std::fwrite(pages[i].pixels.data(), 1, pages[i].pixels.size(), out);
+    }
+    std::fclose(out);
+
+    std::printf("Cooked %u sprites into %u page(s) -> %s\n", header.spriteCount, header.pageCount, outputPath);
+    for (InputImage& img : images) SDL_FreeSurface(img.surface);
+    IMG_Quit();
+    return 0;
+}
@@ -0,0 +1,208 @@
+// Cost per sprite blit, rect fill and circle fill for the two render
+// backends: SDL's software renderer (what SDL_CreateRenderer falls back to
+// without a GPU) behind SdlRenderBackend, against CpuRenderBackend on one
+// thread and on a job system. Everything draws into an 800x600 surface, so it
+// needs no window or GPU.
+//
+//   blit_bench [--out results.json|results.csv] [--reps N] [--sprites N] [--threads N]
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "BenchHarness.h"
+#include "JobSystem.h"
+#include "SpriteBatch.h"
+
+namespace {
+
+constexpr int WIDTH = 800;
+constexpr int HEIGHT = 600;
+
+// Soft-edged ball with a colored rim: alpha varies, so blending can't be
+// skipped. shaded = false gives a plain white disc for tinted circle fills.
+SDL_Surface* makeSprite(int size, bool shaded) {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!surface) return nullptr;
+    const float r = size * 0.5f;
+    for (int y = 0; y < size; ++y) {
+        Uint8* row = static_cast<Uint8*>(surface->pixels) + y * surface->pitch;
+        for (int x = 0; x < size; ++x) {
+            float dx = x + 0.5f - r;
+            float dy = y + 0.5f - r;
+            float d = SDL_sqrtf(dx * dx + dy * dy) / r;
+            float a = d >= 1.0f ? 0.0f : (shaded ? 1.0f - d * d : 1.0f);
+            Uint8* p = row + x * 4;
+            p[0] = shaded ? static_cast<Uint8>(255 * d) : 255;
+            p[1] = shaded ? static_cast<Uint8>(128 + 127 * (1.0f - d)) : 255;
+            p[2] = 255;
+            p[3] = static_cast<Uint8>(a * 255.0f);
+        }
+    }
+    return surface;
+}
+
+struct Textures {
+    SDL_Texture* sprite = nullptr;
+    SDL_Texture* disc = nullptr;
+};
+
+// One backend's batch with the textures it knows about
+template<typename Backend>
+struct Target {
+    BasicSpriteBatch<Backend> batch;
+    Sprite sprite;
+    Sprite disc;
+
+    bool init(SDL_Renderer* renderer, const Textures& textures, SDL_Surface* spriteSurface, SDL_Surface* discSurface) {
+        if (!batch.init(renderer, WIDTH, HEIGHT, 65536)) return false;
+        batch.backend().registerTexture(textures.sprite, spriteSurface);
+        batch.backend().registerTexture(textures.disc, discSurface);
+        sprite = Sprite::fromTexture(textures.sprite);
+        disc = Sprite::fromTexture(textures.disc);
+        return true;
+    }
+};
+
+template<typename Backend>
+void runCases(BenchRunner& bench, const std::string& backendName, Target<Backend>& target, SDL_Renderer* renderer,
+              const std::vector<SDL_FPoint>& positions, int size) {
+    const std::string param = "s=" + std::to_string(size);
+    const double items = static_cast<double>(positions.size());
+    const float fs = static_cast<float>(size);
+    BasicSpriteBatch<Backend>& batch = target.batch;
+
+    auto submit = [&]() {
+        batch.flush();
+        SDL_RenderFlush(renderer);
+    };
+
+    bench.run("blit_" + backendName, param, items, [&]() {
+        for (const SDL_FPoint& p : positions) batch.draw(target.sprite, { p.x, p.y, fs, fs }, LAYER_BULLETS);
+        submit();
+    });
+
+    bench.run("blit_scaled_" + backendName, param, items, [&]() {
+        for (const SDL_FPoint& p : positions) {
+            batch.draw(target.sprite, { p.x, p.y, fs * 1.5f, fs * 1.5f }, LAYER_BULLETS);
+        }
+        submit();
+    });
+
+    bench.run("rect_" + backendName, param, items, [&]() {
+        for (const SDL_FPoint& p : positions) {
+            batch.drawRect({ p.x, p.y, fs, fs }, LAYER_BULLETS, { 255, 96, 64, 128 }, SDL_BLENDMODE_BLEND);
+        }
+        submit();
+    });
+
+    // Like CircleRenderer's sprite backend: white disc, color from the tint
+    bench.run("circle_" + backendName, param, items, [&]() {
+        for (const SDL_FPoint& p : positions) {
+            batch.draw(target.disc, { p.x, p.y, fs, fs }, LAYER_BULLETS, { 173, 216, 230, 255 });
+        }
+        submit();
+    });
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const char* outPath = nullptr;
+    int reps = 21;
+    int spriteCount = 2048;
+    int threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--reps") == 0 && i + 1 < argc) reps = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--sprites") == 0 && i + 1 < argc) spriteCount = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = std::atoi(argv[++i]);
+    }
+
+    SDL_SetMainReady();
+    if (SDL_Init(0) < 0) {
+        SDL_Log("SDL_Init failed: %s", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, WIDTH, HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+    if (!renderer) {
+        SDL_Log("Could not create software renderer: %s", SDL_GetError());
+        return 1;
+    }
+
+    JobSystem jobs;
+    jobs.start(threads > 0 ? threads : SDL_GetCPUCount());
+    SDL_Log("CPU backend: %s span kernel, %d threads for the multithreaded run",
+            CpuRenderBackend::kernelName(), jobs.threadCount());
+
+    BenchRunner bench(3, reps);
+    const int sizes[] = { 8, 16, 32, 64, 128 };
+
+    for (int size : sizes) {
+        SDL_Surface* spriteSurface = makeSprite(size, true);
+        SDL_Surface* discSurface = makeSprite(size, false);
+        Textures textures;
+        textures.sprite = spriteSurface ? SDL_CreateTextureFromSurface(renderer, spriteSurface) : nullptr;
+        textures.disc = discSurface ? SDL_CreateTextureFromSurface(renderer, discSurface) : nullptr;
+        if (!textures.sprite || !textures.disc) {
+            SDL_Log("Could not create bench textures: %s", SDL_GetError());
+            return 1;
+        }
+
+        // Same pseudo-random positions for every backend, partly off-screen
+        std::vector<SDL_FPoint> positions(spriteCount);
+        Uint32 seed = 12345;
+        for (SDL_FPoint& p : positions) {
+            seed = seed * 1664525u + 1013904223u;
+            p.x = static_cast<float>(static_cast<int>((seed >> 8) % (WIDTH + size)) - size / 2);
+            seed = seed * 1664525u + 1013904223u;
+            p.y = static_cast<float>(static_cast<int>((seed >> 8) % (HEIGHT + size)) - size / 2);
+        }
+
+        {
+            Target<SdlRenderBackend> sdl;
+            if (sdl.init(renderer, textures, spriteSurface, discSurface)) {
+                runCases(bench, "sdl_soft", sdl, renderer, positions, size);
+            }
+            sdl.batch.cleanup();
+        }
+        {
+            Target<CpuRenderBackend> cpu;
+            if (cpu.init(renderer, textures, spriteSurface, discSurface)) {
+                runCases(bench, "cpu", cpu, renderer, positions, size);
+                cpu.batch.backend().setJobs(&jobs);
+                runCases(bench, "cpu_mt", cpu, renderer, positions, size);
+            }
+            cpu.batch.cleanup();
+        }
+
+        SDL_DestroyTexture(textures.sprite);
+        SDL_DestroyTexture(textures.disc);
+        SDL_FreeSurface(spriteSurface);
+        SDL_FreeSurface(discSurface);
+    }
+
+    // What the CPU backend pays on top of drawing: one upload per frame
+    {
+        Target<CpuRenderBackend> cpu;
+        if (cpu.batch.init(renderer, WIDTH, HEIGHT, 16)) {
+            bench.run("present_cpu", std::to_string(WIDTH) + "x" + std::to_string(HEIGHT), 1, [&]() {
+                cpu.batch.backend().present();
+            });
+        }
+        cpu.batch.cleanup();
+    }
+
+    if (outPath && !bench.write(outPath)) {
+        SDL_Log("Could not write %s", outPath);
+    }
+
+    jobs.stop();
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+    SDL_Quit();
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Cost per circle for radii 1-64: the old per-pixel SDL_RenderDrawPoint loop
+// against the cached-sprite and scanline backends of CircleRenderer.
+// Runs on SDL's software renderer drawing into a plain surface, so it needs
+// no window or GPU.
+//
+//   circle_bench [--out results.json|results.csv] [--reps N] [--circles N]
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "BenchHarness.h"
+#include "CircleRenderer.h"
+#include "SpriteBatch.h"
+
+namespace {
+
+// What Engine::drawFilledCircle used to do
+void legacyFilledCircle(SDL_Renderer* renderer, int centerX, int centerY, int radius, SDL_Color color) {
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    for (int w = 0; w < radius * 2; w++) {
+        for (int h = 0; h < radius * 2; h++) {
+            int dx = radius - w;
+            int dy = radius - h;
+            if ((dx * dx + dy * dy) <= (radius * radius)) {
+                SDL_RenderDrawPoint(renderer, centerX + dx, centerY + dy);
+            }
+        }
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const char* outPath = nullptr;
+    int reps = 21;
+    int circleCount = 256;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--reps") == 0 && i + 1 < argc) reps = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--circles") == 0 && i + 1 < argc) circleCount = std::atoi(argv[++i]);
+    }
+
+    SDL_SetMainReady();
+    if (SDL_Init(0) < 0) {
+        SDL_Log("SDL_Init failed: %s", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, 640, 480, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (!renderer) {
+        SDL_Log("Could not create software renderer: %s", SDL_GetError());
+        return 1;
+    }
+
+    SpriteBatch batch;
+    batch.init(renderer, 640, 480, 65536);
+    CircleRenderer circles;
+    if (!circles.init(renderer, &batch)) return 1;
+
+    // Same pseudo-random positions for every case
+    std::vector<SDL_Point> centers(circleCount);
+    Uint32 seed = 12345;
+    for (SDL_Point& p : centers) {
+        seed = seed * 1664525u + 1013904223u;
+        p.x = 64 + static_cast<int>((seed >> 8) % 512);
+        seed = seed * 1664525u + 1013904223u;
+        p.y = 64 + static_cast<int>((seed >> 8) % 352);
+    }
+
+    BenchRunner bench(3, reps);
+    const SDL_Color color = { 173, 216, 230, 255 };
+    const int radii[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    for (int r : radii) {
+        std::string param = "r=" + std::to_string(r);
+
+        bench.run("circle_legacy_points", param, circleCount, [&]() {
+            for (const SDL_Point& p : centers) legacyFilledCircle(renderer, p.x, p.y, r, color);
+            SDL_RenderFlush(renderer);
+        });
+
+        circles.setBackend(CircleBackend::SPRITE);
+        bench.run("circle_sprite", param, circleCount, [&]() {
+            for (const SDL_Point& p : centers) {
+                circles.fillCircle(static_cast<float>(p.x), static_cast<float>(p.y), static_cast<float>(r), color, LAYER_BULLETS);
+            }
+            batch.flush();
+            SDL_RenderFlush(renderer);
+        });
+
+        circles.setBackend(CircleBackend::SCANLINE);
+        bench.run("circle_scanline", param, circleCount, [&]() {
+            for (const SDL_Point& p : centers) {
+                circles.fillCircle(static_cast<float>(p.x), static_cast<float>(p.y), static_cast<float>(r), color, LAYER_BULLETS);
+            }
+            batch.flush();
+            SDL_RenderFlush(renderer);
+        });
+
+        circles.setBackend(CircleBackend::SPRITE);
+        bench.run("ring_sprite", param, circleCount, [&]() {
+            for (const SDL_Point& p : centers) {
+                circles.ring(static_cast<float>(p.x), static_cast<float>(p.y), static_cast<float>(r), 2.0f, color, LAYER_BULLETS);
+            }
+            batch.flush();
+            SDL_RenderFlush(renderer);
+        });
+
+        circles.setBackend(CircleBackend::SCANLINE);
+        bench.run("ring_scanline", param, circleCount, [&]() {
+            for (const SDL_Point& p : centers) {
+                circles.ring(static_cast<float>(p.x), static_cast<float>(p.y), static_cast<float>(r), 2.0f, color, LAYER_BULLETS);
+            }
+            batch.flush();
+            SDL_RenderFlush(renderer);
+        });
+    }
+
+    if (outPath && !bench.write(outPath)) {
+        SDL_Log("Could not write %s", outPath);
+    }
+
+    circles.cleanup();
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(target);
+    SDL_Quit();
+    return 0;
+}
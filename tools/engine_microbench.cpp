@@ -0,0 +1,508 @@
+// Microbenchmarks for the engine's hot paths, each across a range of sizes:
+// bullet and particle integration, the collision grid, the pattern VM, the
+// stage scheduler, state snapshots, lasers, circle fills, text, and with the game's
+// assets next to the executable, the Engine itself (clampPosition, one
+// simulation tick, a state save and load, and a full frame under the
+// software renderer for every bench scenario).
+//
+// Everything runs on SDL's software renderer and the dummy video driver, so
+// it needs no display or GPU. Results go through BenchRunner: warmup,
+// median and MAD per case, optionally written as JSON or CSV.
+//
+//   engine_microbench [--out results.json|results.csv] [--reps N] [--threads N]
+//                     [--filter substring] [--font LCALLIG.ttf]
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "BenchHarness.h"
+#include "BulletPattern.h"
+#include "BulletPool.h"
+#include "CircleRenderer.h"
+#include "CollisionGrid.h"
+#include "Engine.h"
+#include "JobSystem.h"
+#include "LaserPool.h"
+#include "ParticleSystem.h"
+#include "Playfield.h"
+#include "RenderCommandList.h"
+#include "SpriteBatch.h"
+#include "Stage.h"
+#include "StateSnapshot.h"
+#include "TextRenderer.h"
+
+namespace {
+
+constexpr int WIDTH = 640;
+constexpr int HEIGHT = 480;
+constexpr float DT = 1.0f / 60.0f;
+
+const char* filter = nullptr;
+
+bool selected(const char* group) {
+    return !filter || std::strstr(group, filter) != nullptr;
+}
+
+// Same LCG as the other bench tools, so inputs are identical run to run
+struct Lcg {
+    Uint32 state = 12345;
+    float next01() {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<float>(state >> 8) * (1.0f / 16777216.0f);
+    }
+    float range(float lo, float hi) { return lo + (hi - lo) * next01(); }
+};
+
+std::vector<BulletSpawn> makeBullets(size_t n, const Playfield& field, float speed, float lifetime) {
+    std::vector<BulletSpawn> spawns(n);
+    Lcg rng;
+    for (BulletSpawn& b : spawns) {
+        b = {};
+        b.x = rng.range(field.left, field.right);
+        b.y = rng.range(field.top, field.bottom);
+        b.vx = rng.range(-speed, speed);
+        b.vy = rng.range(-speed, speed);
+        b.angularVel = rng.range(-0.5f, 0.5f);
+        b.lifetime = lifetime;
+        b.radius = rng.range(2.0f, 6.0f);
+        b.color = 0xFF8040FFu;
+    }
+    return spawns;
+}
+
+const size_t BULLET_COUNTS[] = { 1024, 4096, 16384, 65536 };
+
+void benchBullets(BenchRunner& bench, JobSystem& jobs) {
+    // Nothing leaves this field or expires, so every rep moves all n bullets
+    const Playfield everywhere = { -1.0e7f, -1.0e7f, 1.0e7f, 1.0e7f };
+    const Playfield field = Playfield::fromWindow(WIDTH, HEIGHT);
+    for (size_t n : BULLET_COUNTS) {
+        std::vector<BulletSpawn> spawns = makeBullets(n, field, 120.0f, 1.0e9f);
+        BulletPool pool(n);
+        pool.spawnBatch(spawns.data(), n);
+        const std::string param = "n=" + std::to_string(n);
+        bench.run("bullet_update", param, static_cast<double>(n), [&]() { pool.update(DT, everywhere); });
+        bench.run("bullet_update_mt", param, static_cast<double>(n), [&]() { pool.update(DT, everywhere, jobs); });
+    }
+}
+
+void benchCollision(BenchRunner& bench, JobSystem& jobs) {
+    const Playfield field = Playfield::fromWindow(WIDTH, HEIGHT);
+    const size_t queries = 1024;
+    for (size_t n : BULLET_COUNTS) {
+        std::vector<BulletSpawn> spawns = makeBullets(n, field, 0.0f, 10.0f);
+        BulletPool pool(n);
+        pool.spawnBatch(spawns.data(), n);
+        CollisionGrid grid(field, 16.0f, n);
+        const std::string param = "n=" + std::to_string(n);
+
+        bench.run("collision_build", param, static_cast<double>(n), [&]() {
+            grid.build(pool.posX(), pool.posY(), pool.radii(), pool.size());
+        });
+        bench.run("collision_build_mt", param, static_cast<double>(n), [&]() {
+            grid.build(pool.posX(), pool.posY(), pool.radii(), pool.size(), jobs);
+        });
+
+        // Graze-sized circles at random points; the count keeps the work live
+        std::vector<float> qx(queries), qy(queries);
+        Lcg rng;
+        for (size_t i = 0; i < queries; ++i) {
+            qx[i] = rng.range(field.left, field.right);
+            qy[i] = rng.range(field.top, field.bottom);
+        }
+        size_t hits = 0;
+        bench.run("collision_query", param, static_cast<double>(queries), [&]() {
+            for (size_t i = 0; i < queries; ++i) {
+                grid.queryCircle(qx[i], qy[i], 16.0f, [&](size_t) { hits++; return true; });
+            }
+        });
+        if (hits == 0) SDL_Log("collision_query %s found nothing", param.c_str());
+    }
+}
+
+void benchParticles(BenchRunner& bench, JobSystem& jobs) {
+    const Playfield everywhere = { -1.0e7f, -1.0e7f, 1.0e7f, 1.0e7f };
+    // Long-lived so the pool stays full for the whole case
+    const ParticlePreset preset = { 20.0f, 200.0f, 1.0e9f, 1.0e9f, 3.0f, 1.0f, 0xFFE080FFu, 0xFF400000u, 1.0f, 0.0f };
+    const size_t counts[] = { 4096, 16384, 131072 };
+    for (size_t n : counts) {
+        ParticleSystem particles(n);
+        particles.burst(320.0f, 240.0f, static_cast<int>(n), preset);
+        const std::string param = "n=" + std::to_string(n);
+        bench.run("particle_update", param, static_cast<double>(n), [&]() { particles.update(DT, everywhere); });
+        bench.run("particle_update_mt", param, static_cast<double>(n), [&]() {
+            particles.update(DT, everywhere, jobs);
+        });
+    }
+}
+
+void benchEmitters(BenchRunner& bench, JobSystem& jobs) {
+    PatternLibrary patterns;
+    std::string error;
+    if (!patterns.compile(PatternLibrary::builtinSource(), error)) {
+        SDL_Log("Built-in patterns failed to compile: %s", error.c_str());
+        return;
+    }
+    const char* names[] = { "spiral", "fans", "pulse", "sweeper" };
+    const size_t counts[] = { 16, 256, 4096 };
+    BulletPool bullets(65536);
+    LaserPool lasers(1024);
+    for (size_t n : counts) {
+        EmitterPool emitters(n, 16384);
+        Lcg rng;
+        for (size_t i = 0; i < n; ++i) {
+            int program = patterns.find(names[i % 4]);
+            emitters.spawn(patterns, program, rng.range(20.0f, 300.0f), rng.range(20.0f, 200.0f));
+        }
+        // One tick of the VM plus handing the shots over; the pool is emptied
+        // each rep so it never fills up and starts dropping
+        bench.run("emitter_tick", "n=" + std::to_string(n), static_cast<double>(n), [&]() {
+            emitters.update(patterns, DT, 160.0f, 400.0f, jobs);
+            emitters.flushSpawns(bullets, lasers);
+            bullets.clear();
+            lasers.clear();
+        });
+    }
+}
+
+void benchStageScheduler(BenchRunner& bench) {
+    const size_t counts[] = { 64, 1024, 4000 };
+    StageScheduler scheduler(4096);
+    for (size_t n : counts) {
+        // Spread over 20 s, so some go to the overflow heap first
+        std::vector<StageEvent> events(n);
+        Lcg rng;
+        for (StageEvent& e : events) {
+            e = {};
+            e.tick = static_cast<Uint32>(rng.range(0.0f, 1200.0f));
+            e.type = StageEventType::CLEAR;
+        }
+        size_t dispatched = 0;
+        bench.run("stage_schedule_dispatch", "n=" + std::to_string(n), static_cast<double>(n), [&]() {
+            scheduler.reset(0);
+            for (const StageEvent& e : events) scheduler.schedule(e);
+            while (scheduler.pending() > 0) {
+                dispatched += scheduler.advance([](const StageEvent&) {});
+            }
+        });
+        if (dispatched == 0) SDL_Log("stage scheduler dispatched nothing");
+    }
+}
+
+void benchState(BenchRunner& bench) {
+    // 20k is the scene rewind and practice restarts are sized for
+    const size_t counts[] = { 4096, 20000, 65536 };
+    const Playfield field = Playfield::fromWindow(WIDTH, HEIGHT);
+    for (size_t n : counts) {
+        const std::string param = "n=" + std::to_string(n);
+        std::vector<BulletSpawn> spawns = makeBullets(n, field, 120.0f, 1.0e9f);
+        BulletPool pool(n);
+        pool.spawnBatch(spawns.data(), spawns.size());
+
+        std::vector<Uint8> image;
+        bench.run("state_save", param, static_cast<double>(n), [&]() {
+            StateWriter out(image);
+            pool.saveState(out);
+            out.finish();
+        });
+        bench.run("state_load", param, static_cast<double>(n), [&]() {
+            StateReader in(image.data(), image.size());
+            pool.loadState(in);
+        });
+
+        // Two images a tick apart, pushed in turn: the XOR of one tick of
+        // motion, which is what the rewind ring stores
+        std::vector<Uint8> moved;
+        const Playfield everywhere = { -1.0e7f, -1.0e7f, 1.0e7f, 1.0e7f };
+        pool.update(DT, everywhere);
+        {
+            StateWriter out(moved);
+            pool.saveState(out);
+            out.finish();
+        }
+        StateHistory history(64);
+        size_t pushes = 0;
+        bench.run("state_history_push", param, static_cast<double>(n), [&]() {
+            history.push(static_cast<Uint32>(pushes), (pushes & 1) ? moved : image);
+            pushes++;
+        });
+        SDL_Log("state n=%u: image %u KiB, %u delta slots in %u KiB", static_cast<unsigned>(n),
+                static_cast<unsigned>(image.size() / 1024), static_cast<unsigned>(history.size()),
+                static_cast<unsigned>(history.storedBytes() / 1024));
+        std::vector<Uint8> popped;
+        bench.run("state_history_pop", param, static_cast<double>(n), [&]() {
+            Uint32 tick = 0;
+            if (history.empty()) history.push(0, image);
+            history.pop(popped, tick);
+        });
+    }
+}
+
+const size_t LASER_COUNTS[] = { 64, 256, 1024 };
+constexpr Uint32 LASER_NODES = 100;
+
+// n lasers circling in place with full rings, so every update drops a node
+// and lays one and the bounds cover a whole loop's worth of path
+void fillLasers(LaserPool& lasers, size_t n, const Playfield& field) {
+    const Playfield everywhere = { -1.0e7f, -1.0e7f, 1.0e7f, 1.0e7f };
+    Lcg rng;
+    for (size_t i = 0; i < n; ++i) {
+        LaserSpawn l;
+        l.x = rng.range(field.left, field.right);
+        l.y = rng.range(field.top, field.bottom);
+        l.speed = rng.range(100.0f, 200.0f);
+        l.angle = rng.range(0.0f, 6.2831853f);
+        l.angularVel = rng.range(-2.0f, 2.0f);
+        l.lifetime = 1.0e9f;
+        l.radius = rng.range(3.0f, 8.0f);
+        l.color = 0xFF60E0FFu;
+        l.length = LASER_NODES;
+        lasers.spawn(l);
+    }
+    for (Uint32 t = 0; t < LASER_NODES; ++t) lasers.update(DT, everywhere);
+}
+
+void benchLasers(BenchRunner& bench) {
+    const Playfield everywhere = { -1.0e7f, -1.0e7f, 1.0e7f, 1.0e7f };
+    const Playfield field = Playfield::fromWindow(WIDTH, HEIGHT);
+    const size_t queries = 1024;
+    for (size_t n : LASER_COUNTS) {
+        LaserPool lasers(n);
+        fillLasers(lasers, n, field);
+        const std::string param = "n=" + std::to_string(n);
+        const double nodes = static_cast<double>(lasers.nodeCount());
+
+        bench.run("laser_update", param, nodes, [&]() { lasers.update(DT, everywhere); });
+
+        // Hurtbox-sized moves at random points: the bounding boxes reject
+        // most lasers and the rest get the capsule tests
+        std::vector<float> qx(queries), qy(queries);
+        Lcg rng;
+        for (size_t i = 0; i < queries; ++i) {
+            qx[i] = rng.range(field.left, field.right);
+            qy[i] = rng.range(field.top, field.bottom);
+        }
+        size_t hits = 0;
+        bench.run("laser_hits", param, static_cast<double>(queries), [&]() {
+            for (size_t i = 0; i < queries; ++i) {
+                if (lasers.hits(qx[i], qy[i], qx[i] + 4.0f, qy[i] + 2.0f, 2.0f)) hits++;
+            }
+        });
+        if (hits == 0) SDL_Log("laser_hits %s found nothing", param.c_str());
+    }
+}
+
+// Recording lasers as strips and turning them into quads, like a frame does
+void benchLaserStrips(BenchRunner& bench, SDL_Renderer* renderer, SpriteBatch& batch) {
+    CircleRenderer circles;
+    if (!circles.init(renderer, &batch)) {
+        SDL_Log("Could not set up circles");
+        return;
+    }
+    const Playfield field = Playfield::fromWindow(WIDTH, HEIGHT);
+    RenderCommandList list;
+    TextRenderer text; // never asked to draw; the list only holds strips
+    for (size_t n : LASER_COUNTS) {
+        LaserPool lasers(n);
+        fillLasers(lasers, n, field);
+        const std::string param = "n=" + std::to_string(n);
+        const double nodes = static_cast<double>(lasers.nodeCount());
+
+        auto record = [&]() {
+            list.clear();
+            RenderCommandList::StripRun run = list.beginStrips(n, lasers.nodeCount(), SDL_BLENDMODE_BLEND,
+                                                               LAYER_BULLETS);
+            float* x = run.x;
+            float* y = run.y;
+            for (size_t i = 0; i < lasers.size(); ++i) {
+                LaserPool::Path path = lasers.path(i);
+                run.strips[i] = { static_cast<Uint32>(path.count), path.radius, path.color,
+                                  path.headDx, path.headDy, path.tailDx, path.tailDy };
+                const size_t wrapped = path.count - path.firstCount;
+                std::memcpy(x, path.x, path.firstCount * sizeof(float));
+                std::memcpy(x + path.firstCount, path.wrapX, wrapped * sizeof(float));
+                std::memcpy(y, path.y, path.firstCount * sizeof(float));
+                std::memcpy(y + path.firstCount, path.wrapY, wrapped * sizeof(float));
+                x += path.count;
+                y += path.count;
+            }
+        };
+        bench.run("laser_record", param, nodes, record);
+        bench.run("laser_draw", param, nodes, [&]() {
+            list.replay(batch, circles, text, 0.5f);
+            batch.flush();
+            SDL_RenderFlush(renderer);
+        });
+    }
+    circles.cleanup();
+}
+
+void benchCircles(BenchRunner& bench, SDL_Renderer* renderer, SpriteBatch& batch) {
+    CircleRenderer circles;
+    if (!circles.init(renderer, &batch)) {
+        SDL_Log("Could not set up circles");
+        return;
+    }
+    // What Engine::drawFilledCircle forwards to, with the engine's backend
+    const int count = 1024;
+    std::vector<SDL_FPoint> centers(count);
+    Lcg rng;
+    for (SDL_FPoint& p : centers) {
+        p.x = rng.range(64.0f, WIDTH - 64.0f);
+        p.y = rng.range(64.0f, HEIGHT - 64.0f);
+    }
+    const int radii[] = { 2, 8, 32 };
+    for (int r : radii) {
+        bench.run("fill_circle", "r=" + std::to_string(r), count, [&]() {
+            for (const SDL_FPoint& p : centers) {
+                circles.fillCircle(p.x, p.y, static_cast<float>(r), { 173, 216, 230, 255 }, LAYER_BULLETS);
+            }
+            batch.flush();
+            SDL_RenderFlush(renderer);
+        });
+    }
+    circles.cleanup();
+}
+
+void benchText(BenchRunner& bench, SDL_Renderer* renderer, SpriteBatch& batch, const char* fontPath) {
+    if (TTF_Init() == -1) {
+        SDL_Log("TTF_Init failed: %s", TTF_GetError());
+        return;
+    }
+    TTF_Font* font = TTF_OpenFont(fontPath, 16);
+    TextRenderer text;
+    if (!font || !text.init(renderer, font, &batch)) {
+        SDL_Log("Skipping text: could not load %s", fontPath);
+        if (font) TTF_CloseFont(font);
+        TTF_Quit();
+        return;
+    }
+    // HUD-sized strings up to a full dialog line, 64 per rep
+    const int lines = 64;
+    const size_t lengths[] = { 8, 32, 128 };
+    for (size_t length : lengths) {
+        std::string str;
+        for (size_t i = 0; i < length; ++i) str += static_cast<char>('a' + i % 26);
+        bench.run("text_draw", "len=" + std::to_string(length), lines, [&]() {
+            for (int i = 0; i < lines; ++i) {
+                text.drawText(str.c_str(), 10, (i * 7) % HEIGHT, { 255, 255, 255, 255 });
+            }
+            batch.flush();
+            SDL_RenderFlush(renderer);
+        });
+        int w = 0;
+        bench.run("text_measure", "len=" + std::to_string(length), lines, [&]() {
+            for (int i = 0; i < lines; ++i) text.measureText(str.c_str(), &w, nullptr);
+        });
+    }
+    text.cleanup();
+    TTF_CloseFont(font);
+    TTF_Quit();
+}
+
+// Needs LCALLIG.ttf and assets.pack (or assets/) in the working directory,
+// like the game. Quits SDL on the way out, so it runs last.
+void benchEngine(BenchRunner& bench, int threads) {
+    Engine engine("engine_microbench", WIDTH, HEIGHT);
+    engine.setHeadless(true);
+    engine.setFramePacing(PacingMode::UNCAPPED);
+    engine.setThreadCount(threads);
+    if (!engine.init()) {
+        SDL_Log("Skipping Engine cases: init failed (run from the game's directory)");
+        engine.cleanup();
+        return;
+    }
+
+    const Uint32 scenarios[] = { 1, 2, 3, 4 };
+    for (Uint32 id : scenarios) {
+        const BenchScenario* scenario = BenchScenario::find(id);
+        if (!scenario) continue;
+        const std::string param = "scenario=" + std::to_string(id);
+        // Five seconds in, so the field is busy
+        engine.beginScenario(*scenario);
+        engine.stepScenario(300);
+
+        const int clamps = 1000;
+        bench.run("clamp_position", param, clamps, [&]() {
+            for (int i = 0; i < clamps; ++i) engine.clampPosition();
+        });
+        bench.run("frame_render", param, 1, [&]() { engine.drawFrame(); });
+        bench.run("frame_render_present", param, 1, [&]() {
+            engine.drawFrame();
+            engine.presentFrame();
+        });
+        std::vector<Uint8> image;
+        bench.run("engine_state_save", param, 1, [&]() { engine.saveState(image); });
+        bench.run("engine_state_load", param, 1, [&]() { engine.loadState(image); });
+        // Ticks move the scenario on, so this one varies a little by reps
+        bench.run("sim_tick", param, 1, [&]() { engine.stepScenario(1); });
+        engine.endScenario();
+    }
+    engine.cleanup();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const char* outPath = nullptr;
+    const char* fontPath = "LCALLIG.ttf";
+    int reps = 21;
+    int threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--reps") == 0 && i + 1 < argc) reps = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+        else if (std::strcmp(argv[i], "--font") == 0 && i + 1 < argc) fontPath = argv[++i];
+    }
+
+    SDL_SetMainReady();
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if (SDL_Init(0) < 0) {
+        SDL_Log("SDL_Init failed: %s", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, WIDTH, HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+    if (!renderer) {
+        SDL_Log("Could not create software renderer: %s", SDL_GetError());
+        return 1;
+    }
+
+    JobSystem jobs;
+    jobs.start(threads > 0 ? threads : SDL_GetCPUCount());
+    SDL_Log("Render backend %s, %d job threads", RenderBackend::name(), jobs.threadCount());
+
+    BenchRunner bench(3, reps);
+    if (selected("bullet")) benchBullets(bench, jobs);
+    if (selected("collision")) benchCollision(bench, jobs);
+    if (selected("particle")) benchParticles(bench, jobs);
+    if (selected("emitter")) benchEmitters(bench, jobs);
+    if (selected("stage")) benchStageScheduler(bench);
+    if (selected("state")) benchState(bench);
+    if (selected("laser")) benchLasers(bench);
+
+    SpriteBatch batch;
+    if (batch.init(renderer, WIDTH, HEIGHT, 65536)) {
+        batch.backend().setJobs(&jobs);
+        if (selected("circle")) benchCircles(bench, renderer, batch);
+        if (selected("laser")) benchLaserStrips(bench, renderer, batch);
+        if (selected("text")) benchText(bench, renderer, batch, fontPath);
+    }
+    batch.cleanup();
+    jobs.stop();
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+
+    if (selected("engine")) benchEngine(bench, threads);
+
+    if (outPath && !bench.write(outPath)) {
+        SDL_Log("Could not write %s", outPath);
+    }
+    SDL_Quit();
+    return 0;
+}